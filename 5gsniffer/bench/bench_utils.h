@@ -0,0 +1,48 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef BENCH_UTILS_H
+#define BENCH_UTILS_H
+
+#include <cstdint>
+#include <vector>
+#include <complex>
+#include <random>
+
+using namespace std;
+
+/**
+ * Unit-power complex Gaussian noise, seeded so every run processes the same
+ * samples.
+ *
+ * @param num_samples number of samples to generate
+ * @param seed seed of the generator
+ */
+inline vector<complex<float>> random_samples(size_t num_samples, uint32_t seed = 1) {
+  mt19937 generator(seed);
+  normal_distribution<float> distribution(0.0f, sqrt(0.5f));
+  vector<complex<float>> samples(num_samples);
+  for (auto& sample : samples)
+    sample = complex<float>(distribution(generator), distribution(generator));
+  return samples;
+}
+
+#endif // BENCH_UTILS_H
@@ -0,0 +1,93 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <vector>
+#include <complex>
+#include <benchmark/benchmark.h>
+#include "dsp.h"
+#include "bench_utils.h"
+
+using namespace std;
+
+/**
+ * Correlation with the PSS over an 8 ms chunk of the SSB band, downsampled
+ * to 3.84 MHz. Throughput is in input samples per second.
+ */
+static void dsp_correlate(benchmark::State& state) {
+  auto input = random_samples(state.range(0));
+  auto pss = random_samples(256, 2);
+  vector<complex<float>> output;
+  for (auto _ : state) {
+    correlate(output, input, pss);
+    benchmark::DoNotOptimize(output.data());
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+BENCHMARK(dsp_correlate)->Arg(30720);
+
+/**
+ * Normalized correlation of the DMRS of one PDCCH candidate, 18 DMRS per CCE
+ * and CORESET symbol. Throughput is in candidates per second.
+ */
+static void dsp_correlate_magnitude_normalized(benchmark::State& state) {
+  size_t num_dmrs = state.range(0) * 18;
+  auto received = random_samples(num_dmrs);
+  auto reference = random_samples(num_dmrs, 2);
+  vector<float> output;
+  for (auto _ : state) {
+    correlate_magnitude_normalized(output, received, reference);
+    benchmark::DoNotOptimize(output.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetLabel("AL " + to_string(state.range(0)));
+}
+BENCHMARK(dsp_correlate_magnitude_normalized)->RangeMultiplier(2)->Range(1, 16);
+
+/**
+ * Windowed correlation over a cyclic prefix, across an 8 ms chunk at
+ * 23.04 MHz. Throughput is in samples per second.
+ */
+static void dsp_moving_correlate(benchmark::State& state) {
+  auto a = random_samples(state.range(0));
+  auto b = random_samples(state.range(0), 2);
+  vector<complex<float>> output;
+  for (auto _ : state) {
+    moving_correlate(output, a, b, 108);
+    benchmark::DoNotOptimize(output.data());
+  }
+  state.SetItemsProcessed(state.iterations() * a.size());
+}
+BENCHMARK(dsp_moving_correlate)->Arg(184320);
+
+/**
+ * Frequency correction of an 8 ms chunk at 23.04 MHz. Throughput is in
+ * samples per second.
+ */
+static void dsp_rotate(benchmark::State& state) {
+  auto input = random_samples(state.range(0));
+  vector<complex<float>> output(input.size());
+  for (auto _ : state) {
+    rotate(output, input, 1234.5f, 23040000);
+    benchmark::DoNotOptimize(output.data());
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+BENCHMARK(dsp_rotate)->Arg(184320);
@@ -0,0 +1,113 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <vector>
+#include <complex>
+#include <string>
+#include <benchmark/benchmark.h>
+#include "pdcch.h"
+#include "coreset.h"
+#include "dci.h"
+#include "bench_utils.h"
+
+using namespace std;
+
+static constexpr uint16_t bench_cell_id = 1;
+
+/**
+ * PDCCH of a two-symbol, 48 PRB interleaved CORESET, i.e. 16 CCEs, with its
+ * DMRS tables initialized as by channel_mapper.
+ *
+ * @param rnti_start first RNTI of the RNTI list
+ * @param rnti_end last RNTI of the RNTI list
+ */
+static void init_bench_pdcch(nr::pdcch& pdcch, uint16_t rnti_start = 65535, uint16_t rnti_end = 65535) {
+  coreset coreset_info(0, 48, 2, "interleaved", 6, 2, bench_cell_id, bench_cell_id, 0, 14, 10, {4, 4, 2, 2, 1});
+  pdcch.set_coreset_info(coreset_info);
+  pdcch.scrambling_id_start = bench_cell_id;
+  pdcch.scrambling_id_end = bench_cell_id;
+  pdcch.rnti_start = rnti_start;
+  pdcch.rnti_end = rnti_end;
+  pdcch.dci_sizes_list = {39};
+  pdcch.sample_rate_time = 23040000;
+  pdcch.initialize_RNTI_list();
+  pdcch.initialize_dmrs_seq();
+}
+
+/**
+ * DMRS correlation of the first candidate of an AL. Throughput is in
+ * candidates per second.
+ */
+static void pdcch_compute_correlation_DMRS(benchmark::State& state) {
+  nr::pdcch pdcch;
+  init_bench_pdcch(pdcch);
+  uint8_t agg_level = state.range(0);
+  string key = to_string(bench_cell_id) + to_string(agg_level) + "0" + "0";
+  auto& dmrs_symbols = pdcch.dmrs_seq_table.at(key);
+  auto& dmrs_sc_indices = pdcch.dmrs_sc_indices_table.at(key);
+
+  symbol s;
+  s.samples = random_samples(48 * 12 * 2);
+  for (auto _ : state) {
+    float correlation = pdcch.compute_correlation_DMRS(s, dmrs_symbols, dmrs_sc_indices);
+    benchmark::DoNotOptimize(correlation);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetLabel("AL " + to_string(1 << agg_level));
+}
+BENCHMARK(pdcch_compute_correlation_DMRS)->DenseRange(0, 4);
+
+/**
+ * Decoding of one candidate, including rate recovery, polar decoding and the
+ * CRC check, with a 39 bit DCI. The second argument is the length of the RNTI
+ * list searched by the repetition optimization, 0 to decode a single RNTI.
+ * Throughput is in decoded candidates per second.
+ */
+static void pdcch_decode_pdcch(benchmark::State& state) {
+  nr::pdcch pdcch;
+  uint16_t num_rntis = state.range(1);
+  if (num_rntis > 0)
+    init_bench_pdcch(pdcch, 1000, 1000 + num_rntis - 1);
+  else
+    init_bench_pdcch(pdcch);
+
+  uint8_t aggregation_level = state.range(0);
+  dci candidate;
+  candidate.set_found_aggregation_level(aggregation_level);
+  candidate.set_found_candidate(0);
+  candidate.set_nof_bits(39);
+  candidate.set_pdcch_scrambling_id(bench_cell_id);
+  candidate.set_rnti(num_rntis > 0 ? 1000 : 65535);
+
+  symbol s;
+  s.samples = random_samples(48 * 12 * 2);
+  auto pdcch_symbols = random_samples(aggregation_level * 6 * 9, 2);
+  frame_metadata metadata = {};
+  srsran_pdcch_nr_res_t res = {};
+
+  for (auto _ : state) {
+    int found = pdcch.decode_pdcch(s, pdcch_symbols, candidate, &res, num_rntis > 0, metadata);
+    benchmark::DoNotOptimize(found);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetLabel("AL " + to_string(aggregation_level) + (num_rntis > 0 ? ", " + to_string(num_rntis) + " RNTIs" : ""));
+}
+BENCHMARK(pdcch_decode_pdcch)->ArgsProduct({{1, 2, 4, 8, 16}, {0}})->ArgsProduct({{8, 16}, {100, 1000}});
@@ -0,0 +1,159 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <vector>
+#include <array>
+#include <complex>
+#include <memory>
+#include <numeric>
+#include <benchmark/benchmark.h>
+#include "channel_mapper.h"
+#include "phy.h"
+#include "bandwidth_part.h"
+#include "config.h"
+#include "metrics.h"
+#include "bench_utils.h"
+
+using namespace std;
+
+static constexpr uint16_t scaling_num_prbs = 48;
+
+/// Search spaces of increasing size, the third one being the sniffer default
+static const array<vector<uint8_t>, 4> scaling_candidates_per_AL = {{
+  {1, 1, 1, 1, 0},
+  {4, 2, 2, 1, 0},
+  {8, 4, 2, 1, 0},
+  {8, 8, 4, 2, 1},
+}};
+
+static const vector<uint8_t> scaling_dci_sizes = {39, 41, 43, 49};
+
+enum scaling_mode : int64_t {
+  scaling_noise,          ///< Default thresholds on noise, i.e. the cost of an idle CORESET
+  scaling_all_candidates  ///< Every candidate passes the DMRS threshold and is decoded, i.e. the worst case
+};
+
+/**
+ * Cost of searching one slot of a 48 PRB CORESET through channel_mapper and
+ * pdcch, as a function of the search parameters. The arguments are the mode,
+ * the number of scrambling IDs, the number of RNTIs (also the rnti_list_length),
+ * the search space index in scaling_candidates_per_AL, the number of DCI sizes
+ * and the CORESET duration. Every iteration processes the 14 demodulated
+ * symbols of one slot of fixed noise, going through the 10 slots of a frame,
+ * so the reported time is the compute cost per slot. The DMRS candidates and
+ * polar decodes per slot are reported as counters.
+ */
+static void pdcch_search_space_scaling(benchmark::State& state) {
+  scaling_mode mode = (scaling_mode)state.range(0);
+  uint16_t num_scrambling_ids = state.range(1);
+  uint16_t num_rntis = state.range(2);
+  const vector<uint8_t>& num_candidates_per_AL = scaling_candidates_per_AL.at(state.range(3));
+  size_t num_dci_sizes = state.range(4);
+  uint8_t coreset_duration = state.range(5);
+
+  auto phy = make_shared<nr::phy>();
+  phy->nid1 = 0;
+  phy->nid2 = 1;
+  phy->in_synch = true;
+  phy->bandwidth_parts.push_back(make_shared<bandwidth_part>(23'040'000, 0, scaling_num_prbs));
+
+  pdcch_config pdcch_cfg = {};
+  pdcch_cfg.num_prbs = scaling_num_prbs;
+  pdcch_cfg.coreset_duration = coreset_duration;
+  pdcch_cfg.coreset_interleaving_pattern = "interleaved";
+  pdcch_cfg.coreset_reg_bundle_size = 6;
+  pdcch_cfg.coreset_interleaver_size = 2;
+  pdcch_cfg.coreset_nshift = phy->get_cell_id();
+  pdcch_cfg.scrambling_id_start = phy->get_cell_id();
+  pdcch_cfg.scrambling_id_end = phy->get_cell_id() + num_scrambling_ids - 1;
+  pdcch_cfg.rnti_start = 1000;
+  pdcch_cfg.rnti_end = 1000 + num_rntis - 1;
+  pdcch_cfg.rnti_list_length = num_rntis;
+  pdcch_cfg.max_rnti_queue_size = num_rntis;
+  pdcch_cfg.dci_sizes_list.assign(scaling_dci_sizes.begin(), scaling_dci_sizes.begin() + num_dci_sizes);
+  pdcch_cfg.num_candidates_per_AL = num_candidates_per_AL;
+  if (mode == scaling_all_candidates)
+    pdcch_cfg.AL_corr_thresholds = {-1, -1, -1, -1, -1};
+  else
+    pdcch_cfg.AL_corr_thresholds = {0.9, 0.8, 0.7, 0.2, 0.2};
+  pdcch_cfg.sample_rate_time = 23'040'000;
+  channel_mapper mapper(phy, pdcch_cfg);
+
+  // One slot of fixed noise per slot index, as the DMRS differs per slot
+  vector<shared_ptr<vector<symbol>>> slots;
+  for (uint8_t slot_index = 0; slot_index < 10; slot_index++) {
+    auto slot = make_shared<vector<symbol>>(14);
+    for (uint8_t symbol_index = 0; symbol_index < 14; symbol_index++) {
+      symbol& s = slot->at(symbol_index);
+      s.samples = random_samples(scaling_num_prbs * 12, slot_index * 14 + symbol_index + 1);
+      s.symbol_index = symbol_index;
+      s.slot_index = slot_index;
+    }
+    slots.push_back(slot);
+  }
+  frame_metadata metadata = {};
+
+  uint64_t candidates_before = 0;
+  for (metrics::counter c = metrics::dmrs_candidates_al1; c <= metrics::dmrs_candidates_al16; c = (metrics::counter)(c + 1))
+    candidates_before += metrics::get_counter(c);
+  uint64_t decodes_before = metrics::get_counter(metrics::polar_decodes);
+
+  size_t slot_index = 0;
+  for (auto _ : state) {
+    mapper.process(slots.at(slot_index), metadata);
+    slot_index = (slot_index + 1) % slots.size();
+  }
+
+  uint64_t candidates = 0;
+  for (metrics::counter c = metrics::dmrs_candidates_al1; c <= metrics::dmrs_candidates_al16; c = (metrics::counter)(c + 1))
+    candidates += metrics::get_counter(c);
+  uint64_t num_candidates = std::accumulate(num_candidates_per_AL.begin(), num_candidates_per_AL.end(), 0);
+
+  state.SetItemsProcessed(state.iterations());
+  state.counters["search_space"] = num_scrambling_ids * num_candidates;
+  state.counters["candidates_per_slot"] = benchmark::Counter(candidates - candidates_before, benchmark::Counter::kAvgIterations);
+  state.counters["decodes_per_slot"] = benchmark::Counter(metrics::get_counter(metrics::polar_decodes) - decodes_before, benchmark::Counter::kAvgIterations);
+  state.SetLabel(mode == scaling_all_candidates ? "all candidates" : "noise");
+}
+
+/**
+ * Sweeps each search parameter on its own around the sniffer defaults: one
+ * scrambling ID, one RNTI, the default search space, one DCI size and a two
+ * symbol CORESET. The worst case is only swept up to 256 RNTIs, as every
+ * candidate is then decoded once per RNTI.
+ */
+static void pdcch_search_space_scaling_grid(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"mode", "scrambling_ids", "rntis", "candidates", "dci_sizes", "duration"});
+  for (int64_t mode : {scaling_noise, scaling_all_candidates}) {
+    int64_t max_rntis = mode == scaling_noise ? 4096 : 256;
+    for (int64_t scrambling_ids : {1, 4, 16, 64})
+      b->Args({mode, scrambling_ids, 1, 2, 1, 2});
+    for (int64_t rntis = 16; rntis <= max_rntis; rntis *= 16)
+      b->Args({mode, 1, rntis, 2, 1, 2});
+    for (int64_t candidates : {0, 1, 3})
+      b->Args({mode, 1, 1, candidates, 1, 2});
+    for (int64_t dci_sizes : {2, 4})
+      b->Args({mode, 1, 1, 2, dci_sizes, 2});
+    for (int64_t duration : {1, 3})
+      b->Args({mode, 1, 1, 2, 1, duration});
+  }
+}
+BENCHMARK(pdcch_search_space_scaling)->Apply(pdcch_search_space_scaling_grid)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,101 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <vector>
+#include <complex>
+#include <memory>
+#include <benchmark/benchmark.h>
+#include "pn_sequences.h"
+#include "dmrs.h"
+#include "symbol.h"
+#include "ofdm.h"
+#include "bandwidth_part.h"
+#include "bench_utils.h"
+
+using namespace std;
+
+/**
+ * Gold sequence long enough for the PDCCH DMRS of a whole CORESET symbol.
+ * Throughput is in sequence bits per second.
+ */
+static void pn_sequences_pseudo_random_sequence(benchmark::State& state) {
+  int c_init = 0x1234567;
+  for (auto _ : state) {
+    auto sequence = pn_sequences::pseudo_random_sequence(state.range(0), c_init);
+    benchmark::DoNotOptimize(sequence.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(pn_sequences_pseudo_random_sequence)->Arg(2 * 16 * 18);
+
+/**
+ * PDCCH DMRS of a CORESET symbol, as generated per scrambling ID, slot and
+ * symbol when the DMRS tables are built. Throughput is in DMRS symbols per
+ * second.
+ */
+static void dmrs_generate_pdcch_dmrs_symb(benchmark::State& state) {
+  dmrs dmrs_pdcch;
+  for (auto _ : state) {
+    auto symbols = dmrs_pdcch.generate_pdcch_dmrs_symb(500, 3, 1, 14, state.range(0));
+    benchmark::DoNotOptimize(symbols.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) / 2);
+}
+BENCHMARK(dmrs_generate_pdcch_dmrs_symb)->Arg(2 * 16 * 18);
+
+/**
+ * Channel estimation and equalization of a 48 PRB CORESET symbol from its
+ * DMRS on every fourth subcarrier. Throughput is in subcarriers per second.
+ */
+static void symbol_channel_estimate(benchmark::State& state) {
+  size_t num_subcarriers = state.range(0) * 12;
+  symbol s;
+  s.samples = random_samples(num_subcarriers);
+  vector<uint64_t> dmrs_indices;
+  for (uint64_t i = 1; i < num_subcarriers; i += 4)
+    dmrs_indices.push_back(i);
+  auto dmrs_reference = random_samples(dmrs_indices.size(), 2);
+
+  for (auto _ : state) {
+    s.channel_estimate(dmrs_reference, dmrs_indices, 0, num_subcarriers - 1);
+    benchmark::DoNotOptimize(s.samples_eq.data());
+  }
+  state.SetItemsProcessed(state.iterations() * num_subcarriers);
+}
+BENCHMARK(symbol_channel_estimate)->Arg(48);
+
+/**
+ * OFDM demodulation of an 8 ms chunk at 23.04 MHz, into 106 PRB symbols.
+ * Throughput is in input samples per second.
+ */
+static void ofdm_process(benchmark::State& state) {
+  uint64_t sample_rate = 23040000;
+  auto bwp = make_shared<bandwidth_part>(sample_rate, 0, 106);
+  ofdm demodulator(bwp);
+  auto samples = make_shared<vector<complex<float>>>(random_samples(state.range(0)));
+  frame_metadata metadata = {};
+
+  for (auto _ : state) {
+    demodulator.process(samples, metadata);
+  }
+  state.SetItemsProcessed(state.iterations() * samples->size());
+}
+BENCHMARK(ofdm_process)->Arg(184320);
@@ -0,0 +1,87 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <vector>
+#include <complex>
+#include <cmath>
+#include <random>
+#include <benchmark/benchmark.h>
+#include "pss.h"
+#include "bench_utils.h"
+
+using namespace std;
+
+/**
+ * Initial PSS search over an 8 ms chunk of the SSB band at 3.84 MHz, by
+ * pss_coarse_decimation and per-sample SNR in dB. Every iteration searches a
+ * new chunk with a PSS of a random N_ID_2 at a random position. Besides the
+ * throughput in input samples per second, it reports the complex MACs of the
+ * search relative to an exhaustive one, and the fraction of chunks where the
+ * PSS was found at the right sample and N_ID_2.
+ */
+static void pss_detector_search(benchmark::State& state) {
+  uint16_t decimation = state.range(0);
+  float snr = pow(10.0f, state.range(1) / 10.0f);
+  size_t num_samples = 30720;
+  pss_detector detector(decimation);
+
+  // Templates scaled to the SNR over unit-power noise
+  pss generator;
+  vector<vector<complex<float>>> templates;
+  for (uint8_t nid_2 = 0; nid_2 <= nid_2_max; nid_2++) {
+    auto pss_seq_t = generator.convert_pss_t(generator.generate_pss_seq(nid_2));
+    float power = 0.0f;
+    for (auto& sample : pss_seq_t)
+      power += norm(sample) / pss_seq_t.size();
+    vector<complex<float>> scaled(pss_seq_t.begin(), pss_seq_t.end());
+    for (auto& sample : scaled)
+      sample *= sqrt(snr / power);
+    templates.push_back(scaled);
+  }
+
+  mt19937 rng(1);
+  uniform_int_distribution<int64_t> position_distribution(0, num_samples - ssb_nfft);
+  uniform_int_distribution<int> nid_2_distribution(0, nid_2_max);
+  uniform_real_distribution<float> phase_distribution(0.0f, 2 * M_PI);
+  int64_t num_found = 0;
+  uint32_t seed = 1;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto samples = random_samples(num_samples, seed++);
+    int64_t pss_position = position_distribution(rng);
+    uint8_t pss_nid_2 = nid_2_distribution(rng);
+    complex<float> phase = polar(1.0f, phase_distribution(rng));
+    for (size_t i = 0; i < ssb_nfft; i++)
+      samples.at(pss_position + i) += templates.at(pss_nid_2).at(i) * phase;
+    state.ResumeTiming();
+
+    int64_t position = 0;
+    float correlation = 0.0f;
+    uint8_t nid_2 = 0;
+    if (detector.search(samples, 0, nid_2_max, position, correlation, nid_2) && position == pss_position && nid_2 == pss_nid_2)
+      num_found++;
+  }
+  state.SetItemsProcessed(state.iterations() * num_samples);
+  state.counters["complex_macs"] = (double)detector.get_cost(num_samples, nid_2_max + 1) / pss_detector::get_exhaustive_cost(num_samples, nid_2_max + 1);
+  state.counters["found"] = (double)num_found / state.iterations();
+}
+BENCHMARK(pss_detector_search)->ArgsProduct({{1, 2, 4, 8}, {-15, -12, -9, -6}})->Iterations(200);
@@ -0,0 +1,93 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef ACTIVE_RNTI_TABLE_H
+#define ACTIVE_RNTI_TABLE_H
+
+#include <cstdint>
+#include <vector>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+using namespace std;
+
+/**
+ * The RNTIs a PDCCH found DCIs for recently. An RNTI becomes active with its
+ * first DCI and expires once no DCI was found for it during the inactivity
+ * timeout, e.g. after the UE released its RRC connection. Times are in
+ * seconds of signal time, so recordings expire RNTIs like live captures do.
+ * The table can be written to a CSV file at a regular interval of signal
+ * time, by a thread of its own, so that the PDCCH only requests the writes.
+ */
+class active_rnti_table {
+  public:
+    struct entry {
+      uint16_t rnti;
+      double first_seen;
+      double last_seen;
+      uint64_t dci_count;
+      uint8_t aggregation_levels;   ///< Bit i is set if a DCI was found with AL 2^i
+      set<uint8_t> dci_sizes;
+      uint16_t scrambling_id;       ///< Scrambling ID of the last DCI
+    };
+
+    active_rnti_table(double inactivity_timeout, uint16_t rnti_start = 0, uint16_t rnti_end = 0xffff);
+    virtual ~active_rnti_table();
+
+    bool update(uint16_t rnti, double time, uint8_t aggregation_level, uint8_t dci_size, uint16_t scrambling_id);
+    vector<uint16_t> expire(double now);
+    bool contains(uint16_t rnti) const;
+    size_t size() const;
+    size_t listed_size() const;
+    vector<entry> get_snapshot() const;
+    string to_csv() const;
+    bool write_file(const string& file_path) const;
+    void start_writer(const string& file_path, double interval);
+    void request_write(double now);
+
+  private:
+    const double inactivity_timeout;
+    const uint16_t rnti_start;    ///< Range of the RNTI list of the PDCCH
+    const uint16_t rnti_end;
+    mutable mutex table_mutex;
+    unordered_map<uint16_t, entry> entries;
+    atomic<size_t> count;
+    atomic<size_t> listed_count;  ///< Active RNTIs within the range of the RNTI list
+    double next_expiry;           ///< No entry expires before this time
+
+    void run_writer();
+
+    string writer_file_path;
+    double write_interval;        ///< Seconds of signal between two writes
+    atomic<double> next_write;    ///< No write is requested before this time
+    mutex writer_mutex;
+    condition_variable writer_wakeup;
+    bool write_requested;
+    bool writer_stopping;
+    thread writer;
+};
+
+#endif // ACTIVE_RNTI_TABLE_H
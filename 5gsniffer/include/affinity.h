@@ -0,0 +1,43 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <span>
+#include <pthread.h>
+
+using namespace std;
+
+/**
+ * Helpers to pin threads to CPUs and NUMA nodes, and to give them real-time
+ * priority. They only log a warning on failure, as the sniffer works without.
+ */
+vector<int> parse_cpu_list(string cpu_list);
+bool is_cpu_online(int cpu);
+vector<int> get_numa_node_cpus(int numa_node);
+bool set_thread_affinity(pthread_t thread, span<const int> cpus);
+bool set_thread_realtime(pthread_t thread, int priority);
+
+#endif // AFFINITY_H
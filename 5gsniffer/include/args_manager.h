@@ -34,6 +34,8 @@ struct args_t {
   std::string rf_dev;
   double rf_freq;
   double rf_gain;
+  uint64_t sample_rate;
+  uint16_t ssb_numerology;
 
 
   };
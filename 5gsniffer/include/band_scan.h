@@ -0,0 +1,94 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef BAND_SCAN_H
+#define BAND_SCAN_H
+
+#include <cstdint>
+#include <vector>
+#include <complex>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include "worker.h"
+#include "phy.h"
+#include "syncer.h"
+#include "channelizer.h"
+#include "flow_pool.h"
+#include "task_pool.h"
+#include <srsran/srsran.h>
+
+using namespace std;
+
+/**
+ * A cell found during a band scan.
+ */
+struct cell_info {
+  uint32_t gscn;
+  double frequency;   ///< SSB center frequency on the synchronization raster
+  uint16_t cell_id;
+  float cfo;          ///< Frequency offset of the SSB from the raster, in Hz
+  srsran_mib_nr_t mib;
+};
+
+/**
+ * A worker that looks for cells on every GSCN synchronization raster position
+ * within a wideband capture. The input is split by a polyphase channelizer in
+ * a single pass, and each raster position is shifted from its nearest channel
+ * to baseband and synchronized to by its own syncer. Raster positions are
+ * processed in parallel on a task pool that lives as long as the scan.
+ */
+class band_scan : public worker {
+  public:
+    band_scan(uint64_t sample_rate, double center_frequency, uint16_t ssb_numerology, optional<uint8_t> nid2 = nullopt, shared_ptr<task_pool> pool = nullptr);
+    void process(shared_ptr<vector<complex<float>>>& samples, const frame_metadata& metadata) override;
+    vector<cell_info> get_cells();
+
+    uint64_t channel_sample_rate;
+  private:
+    struct raster_position {
+      uint32_t gscn;
+      double frequency;
+      uint32_t channel;
+      float offset;             ///< Offset of the raster position from the center of its channel
+      complex<float> phase;
+      shared_ptr<nr::phy> phy;
+      shared_ptr<class syncer> syncer;
+      bool found;
+    };
+
+    void process_position(raster_position& position, const frame_metadata& metadata);
+    void on_cell_found(raster_position& position, srsran_mib_nr_t& mib, float cfo);
+
+    uint64_t sample_rate;
+    double center_frequency;
+    double ssb_half_bandwidth;
+    unique_ptr<class channelizer> channelizer;
+    vector<vector<complex<float>>> channels;
+    vector<unique_ptr<raster_position>> positions;
+    shared_ptr<nr::flow_pool> flow_pool;
+    shared_ptr<task_pool> pool;
+    int64_t channel_sample_index;
+    mutex cells_mutex;
+    vector<cell_info> cells;
+};
+
+#endif // BAND_SCAN_H
@@ -29,6 +29,7 @@
 using namespace std;
 
 static constexpr uint32_t subframes_per_frame = 10;
+static constexpr uint32_t frames_per_hyperframe = 1024; ///< Number of distinct system frame numbers
 static constexpr double seconds_per_subframe = 0.001;
 static constexpr double seconds_per_frame = 0.010;
 static constexpr double Tc = 1.0 / (480000.0 * 4096.0); ///< Basic time unit in 5G NR
@@ -0,0 +1,65 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef CARRIER_SPLITTER_H
+#define CARRIER_SPLITTER_H
+
+#include <cstdint>
+#include <vector>
+#include <complex>
+#include <memory>
+#include "worker.h"
+#include "channelizer.h"
+#include "config.h"
+
+using namespace std;
+
+/**
+ * A worker that splits a wideband input into the carriers it contains, each
+ * with its SSB brought to baseband. A single polyphase channelizer filters and
+ * decimates the input for all carriers, after which each carrier is shifted
+ * from its nearest channel and passed to its own next workers.
+ */
+class carrier_splitter : public worker {
+  public:
+    carrier_splitter(uint64_t sample_rate, double center_frequency, const vector<carrier_config>& carriers);
+    void process(shared_ptr<vector<complex<float>>>& samples, const frame_metadata& metadata) override;
+    void connect_carrier(size_t carrier, shared_ptr<worker> next_worker);
+    void set_parallel_fanout(shared_ptr<task_pool> pool, size_t queue_depth = 0, bool force_queue = false) override;
+
+    uint64_t carrier_sample_rate;
+  private:
+    struct carrier_stream {
+      uint32_t channel;
+      float offset;             ///< Offset of the SSB from the center of its channel
+      complex<float> phase;
+      vector<shared_ptr<worker>> next_workers;
+      unique_ptr<task_queue> queue; ///< Only with parallel fan-out
+    };
+
+    unique_ptr<class channelizer> channelizer;
+    vector<vector<complex<float>>> channels;
+    vector<carrier_stream> carriers;
+    int64_t carrier_sample_index;
+    size_t fanout_queue_depth;
+};
+
+#endif // CARRIER_SPLITTER_H
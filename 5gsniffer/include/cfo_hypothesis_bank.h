@@ -0,0 +1,82 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef CFO_HYPOTHESIS_BANK_H
+#define CFO_HYPOTHESIS_BANK_H
+
+#include <cstdint>
+#include <vector>
+#include <complex>
+#include <span>
+#include <array>
+#include <memory>
+#include <liquid/liquid.h>
+#include "phy_params_common.h"
+#include "task_pool.h"
+
+using namespace std;
+
+/**
+ * Searches for the PSS under several integer-subcarrier CFO hypotheses at
+ * once, for CFOs beyond the half subcarrier that fine sync can resolve from
+ * the cyclic prefix. The input is transformed once, and each hypothesis
+ * correlates with the PSS in the frequency domain after shifting the spectrum
+ * by its number of subcarriers. Hypotheses are evaluated in parallel on a
+ * task pool, and a PSS is only found where the correlation stands out of its
+ * average like in the other PSS searches.
+ */
+class cfo_hypothesis_bank {
+  public:
+    /** Best PSS correlation found under one hypothesis */
+    struct result {
+      int32_t subcarrier_offset;
+      int64_t position;
+      float correlation;
+      uint8_t nid_2;
+      bool found;         ///< Whether the correlation is over the threshold
+    };
+
+    cfo_hypothesis_bank(vector<int32_t> subcarrier_offsets, size_t num_samples = 0, shared_ptr<task_pool> pool = nullptr, float times_avg_threshold = pss_sss_times_avg_threshold);
+    virtual ~cfo_hypothesis_bank();
+    cfo_hypothesis_bank(const cfo_hypothesis_bank&) = delete;
+    cfo_hypothesis_bank& operator=(const cfo_hypothesis_bank&) = delete;
+    bool search(span<const complex<float>> samples, uint8_t nid_2_start, uint8_t nid_2_end, result& best);
+
+    vector<int32_t> subcarrier_offsets;
+    vector<result> results; ///< Result of each hypothesis of the last search
+  private:
+    void resize(size_t num_samples);
+    void destroy_plans();
+    void evaluate(size_t hypothesis, size_t num_lags, uint8_t nid_2_start, uint8_t nid_2_end);
+
+    shared_ptr<task_pool> pool;
+    float times_avg_threshold;
+    size_t fft_size;
+    vector<complex<float>> input;
+    vector<complex<float>> input_fft;
+    fftplan forward;
+    array<vector<complex<float>>, nid_2_max + 1> pss_fft; ///< Conjugated spectra of the zero-padded PSS
+    vector<vector<complex<float>>> products;              ///< Per hypothesis
+    vector<vector<complex<float>>> correlations;          ///< Per hypothesis
+    vector<fftplan> backward;                             ///< Per hypothesis
+};
+
+#endif // CFO_HYPOTHESIS_BANK_H
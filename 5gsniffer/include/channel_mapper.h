@@ -44,7 +44,7 @@ class channel_mapper : public worker {
   public:
     channel_mapper(shared_ptr<nr::phy> phy, pdcch_config pdcch_config);
     virtual ~channel_mapper();
-    void process(shared_ptr<vector<symbol>>& symbols, int64_t metadata) override;
+    void process(shared_ptr<vector<symbol>>& symbols, const frame_metadata& metadata) override;
 
     shared_ptr<nr::phy> phy;
     
@@ -0,0 +1,66 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef CHANNELIZER_H
+#define CHANNELIZER_H
+
+#include <cstdint>
+#include <vector>
+#include <complex>
+#include <span>
+#include <liquid/liquid.h>
+
+using namespace std;
+
+/**
+ * An oversampled polyphase filterbank channelizer. Splits the input into
+ * num_channels channels, spaced sample_rate / num_channels apart and brought
+ * to baseband, each decimated by the given factor. With a decimation of a
+ * quarter of the number of channels, each channel is output at four times the
+ * channel spacing and the prototype filter passes about 1.35 spacings on each
+ * side, so any frequency is within half a spacing of a channel center and
+ * keeps more than 0.85 spacings of bandwidth on each side.
+ */
+class channelizer {
+  public:
+    channelizer(uint32_t num_channels, uint32_t decimation, uint32_t taps_per_channel = 12, float stopband_attenuation = 60.0f);
+    virtual ~channelizer();
+    channelizer(const channelizer&) = delete;
+    channelizer& operator=(const channelizer&) = delete;
+    void execute(span<complex<float>> input, vector<vector<complex<float>>>& outputs);
+    double channel_frequency(uint32_t channel, uint64_t sample_rate);
+    uint32_t nearest_channel(double frequency, uint64_t sample_rate);
+    static uint32_t get_num_channels(uint64_t sample_rate, double half_bandwidth, uint32_t rate_multiple = 1);
+
+    uint32_t num_channels;
+    uint32_t decimation;
+  private:
+    vector<float> prototype;
+    vector<complex<float>> history;     ///< Input samples, starting with the ones the next output still needs
+    size_t next_output_position;        ///< Index in history of the newest sample of the next output
+    uint32_t output_phase;              ///< Index of the next output, modulo num_channels
+    vector<complex<float>> twiddles;
+    vector<complex<float>> fft_input;
+    vector<complex<float>> fft_output;
+    fftplan fft;
+};
+
+#endif // CHANNELIZER_H
@@ -24,9 +24,13 @@
 
 #include "toml.hpp"
 #include <cstdint>
+#include <algorithm>
 #include <iostream>
 #include <spdlog/spdlog.h>
 #include "exceptions.h"
+#include "phy_params_common.h"
+#include "deadline_scheduler.h"
+#include "affinity.h"
 
 using namespace std;
 
@@ -57,17 +61,105 @@ typedef struct pdcch_config {
   uint8_t coreset_interleaver_size;
   int64_t sample_rate_time;
   int rnti_list_length;
+  std::string grid_recording_path;
+  bool grid_recording_half_precision;
+  uint8_t carrier;
+  double slot_budget_us;               ///< Compute budget of one CORESET slot, 0 to never shed work
+  std::vector<shed_step> shed_order;   ///< Work shed when a slot is over budget, first step first
+  uint32_t hot_rnti_count;             ///< RNTIs decoded while the RNTI list is shed
+  uint32_t shed_recovery_slots;        ///< Slots under half the budget before a shed step is lifted
+  double rnti_inactivity_timeout;      ///< Seconds without a DCI before an RNTI expires, 0 to keep every RNTI active
+  std::string active_rnti_file;        ///< CSV file the active RNTIs are written to
+  double active_rnti_interval;         ///< Seconds of signal between two writes of active_rnti_file
+  bool learned_rntis_only;             ///< Only decode the RNTIs learned for the scrambling ID of a candidate, once there are some
+
+  /**
+   * Restricts the brute force to the SI DCI, whose scrambling ID, RNTI and
+   * CORESET interleaving are fixed for a given cell.
+   *
+   * @param cell_id cell ID of the synchronized cell
+   */
+  void restrict_to_si_dci(uint16_t cell_id) {
+    scrambling_id_start = cell_id; // Scrambling ID for SI DCI is always the cell ID
+    scrambling_id_end = cell_id;
+    rnti_start = 65535; // SI-RNTI is always 65535
+    rnti_end = 65535;
+    coreset_interleaving_pattern = "interleaved";
+    coreset_reg_bundle_size = 6;
+    coreset_interleaver_size = 2;
+    coreset_nshift = cell_id;
+  }
 } pdcch_config;
 
+typedef struct generator_dci_config {
+  size_t pdcch;                ///< Index of the [[pdcch]] config whose CORESET carries the DCI
+  uint16_t rnti;
+  uint16_t scrambling_id;
+  uint8_t aggregation_level;
+  uint8_t candidate;
+  uint8_t dci_size;            ///< DCI payload size in bits
+  uint32_t slot_period;        ///< The DCI is sent every slot_period slots
+  uint32_t slot_offset;        ///< Slot within the period in which the DCI is sent
+} generator_dci_config;
+
+typedef struct generator_config {
+  string output_path;          ///< IQ file to write, interleaved 32-bit float I/Q
+  string truth_path;           ///< CSV file listing every DCI written
+  double duration;             ///< Length of the generated signal in seconds
+  double snr_db;               ///< SNR per resource element in dB
+  double cfo;                  ///< Carrier frequency offset in Hz
+  uint64_t timing_offset;      ///< Number of noise-only samples before the first frame
+  uint16_t cell_id;
+  uint16_t sfn_start;
+  uint32_t seed;
+  uint32_t ssb_offset;         ///< MIB k_SSB
+  uint32_t coreset0_idx;       ///< MIB controlResourceSetZero
+  uint32_t ss0_idx;            ///< MIB searchSpaceZero
+  bool dmrs_typeA_pos;         ///< MIB dmrs-TypeA-Position (false is pos2)
+  vector<generator_dci_config> dcis;
+} generator_config;
+
+typedef struct carrier_config {
+  double frequency;   ///< SSB center frequency of the carrier in Hz
+  double bandwidth;   ///< Bandwidth around the SSB center that is decoded, in Hz
+} carrier_config;
+
 struct config {
   string file_path;
+  string grid_file_path;
+  bool realtime;
+  bool follow;
+  double follow_timeout;
   uint64_t sample_rate;
   double frequency;
   uint8_t nid_2;
+  bool multi_cell;
+  bool sss_fast_transform;
+  uint32_t pbch_decode_interval;
+  uint16_t pss_coarse_decimation;
+  uint16_t pss_coarse_candidates;
+  uint16_t pss_refine_window;
+  vector<int32_t> cfo_hypotheses;
+  uint64_t max_flows;
+  uint64_t initial_flows;
+  string flow_cpus;
+  int numa_node;
+  int ingest_cpu;
+  int sdr_realtime_priority;
+  bool parallel_fanout;
+  uint32_t fanout_threads;
+  uint32_t fanout_queue_depth;
+  uint16_t metrics_port;
+  string metrics_file;
+  double metrics_interval;
+  string trace_file;
+  uint32_t trace_events_per_thread;
   string rf_args;
   uint16_t ssb_numerology;
 
+  vector<carrier_config> carriers;
   vector<pdcch_config> pdcch_configs;
+  generator_config generator;
 
   static struct config load(string config_path) {
     struct config conf;
@@ -77,11 +169,68 @@ struct config {
     SPDLOG_INFO("Loading configuration file {}", config_path);
     toml::table toml = toml::parse_file(config_path);
     conf.file_path = toml["sniffer"]["file_path"].value_or(""sv).data();
+    conf.grid_file_path = toml["sniffer"]["grid_file_path"].value_or(""sv).data();
+    conf.realtime = toml["sniffer"]["realtime"].value_or(false);
+    conf.follow = toml["sniffer"]["follow"].value_or(false);
+    conf.follow_timeout = toml["sniffer"]["follow_timeout"].value_or(0.0);
     conf.sample_rate = toml["sniffer"]["sample_rate"].value_or(default_sample_rate);
     conf.frequency = toml["sniffer"]["frequency"].value_or(default_frequency);
     conf.nid_2 = toml["sniffer"]["nid_2"].value_or(4);
+    conf.multi_cell = toml["sniffer"]["multi_cell"].value_or(false);
+    conf.sss_fast_transform = toml["sniffer"]["sss_fast_transform"].value_or(false);
+    conf.pbch_decode_interval = toml["sniffer"]["pbch_decode_interval"].value_or(1);
+    if(conf.pbch_decode_interval == 0)
+      throw config_exception("pbch_decode_interval must be at least 1");
+    conf.pss_coarse_decimation = toml["sniffer"]["pss_coarse_decimation"].value_or(1);
+    conf.pss_coarse_candidates = toml["sniffer"]["pss_coarse_candidates"].value_or(3);
+    conf.pss_refine_window = toml["sniffer"]["pss_refine_window"].value_or(0);
+    if(conf.pss_coarse_decimation == 0 || conf.pss_coarse_candidates == 0)
+      throw config_exception("pss_coarse_decimation and pss_coarse_candidates must be at least 1");
+    conf.max_flows = toml["sniffer"]["max_flows"].value_or(64);
+    conf.initial_flows = toml["sniffer"]["initial_flows"].value_or(0);
+    conf.flow_cpus = toml["sniffer"]["flow_cpus"].value_or(""sv).data();
+    conf.numa_node = toml["sniffer"]["numa_node"].value_or(-1);
+    conf.ingest_cpu = toml["sniffer"]["ingest_cpu"].value_or(-1);
+    for(int cpu : parse_cpu_list(conf.flow_cpus)) {
+      if(!is_cpu_online(cpu))
+        throw config_exception("flow_cpus lists CPU " + to_string(cpu) + ", which is not online");
+    }
+    if(conf.ingest_cpu >= 0 && !is_cpu_online(conf.ingest_cpu))
+      throw config_exception("ingest_cpu " + to_string(conf.ingest_cpu) + " is not an online CPU");
+    conf.sdr_realtime_priority = toml["sniffer"]["sdr_realtime_priority"].value_or(0);
+    if(conf.sdr_realtime_priority < 0 || conf.sdr_realtime_priority > 99)
+      throw config_exception("sdr_realtime_priority must be between 0 (disabled) and 99");
+    conf.parallel_fanout = toml["sniffer"]["parallel_fanout"].value_or(false);
+    conf.fanout_threads = toml["sniffer"]["fanout_threads"].value_or(0);
+    conf.fanout_queue_depth = toml["sniffer"]["fanout_queue_depth"].value_or(0);
+    conf.metrics_port = toml["sniffer"]["metrics_port"].value_or(0);
+    conf.metrics_file = toml["sniffer"]["metrics_file"].value_or(""sv).data();
+    conf.metrics_interval = toml["sniffer"]["metrics_interval"].value_or(10.0);
+    if(conf.metrics_interval <= 0)
+      throw config_exception("metrics_interval must be positive");
+    conf.trace_file = toml["sniffer"]["trace_file"].value_or(""sv).data();
+    conf.trace_events_per_thread = toml["sniffer"]["trace_events_per_thread"].value_or(65536);
+    toml::array* cfo_hypotheses_array = toml["sniffer"]["cfo_hypotheses"].as<toml::array>();
+    if(cfo_hypotheses_array) {
+      for(auto&& elem : *cfo_hypotheses_array)
+        conf.cfo_hypotheses.push_back(elem.value_or(0));
+    }
     conf.rf_args = toml["sniffer"]["rf_args"].value_or(""sv).data();
     conf.ssb_numerology = toml["sniffer"]["ssb_numerology"].value_or(0);
+
+    // Carriers within a wideband input, all carriers are decoded at once
+    if(toml["carrier"]) {
+      if(!toml["carrier"].is_array_of_tables())
+        throw config_exception("Carrier TOML config should be an array of tables, e.g. [[carrier]]");
+      for(toml::node& node : *toml["carrier"].as<toml::array>()) {
+        toml::table carrier_table = *node.as_table();
+        carrier_config carrier_cfg;
+        carrier_cfg.frequency = carrier_table["frequency"].value_or(conf.frequency);
+        carrier_cfg.bandwidth = carrier_table["bandwidth"].value_or(20e6);
+        conf.carriers.push_back(carrier_cfg);
+      }
+    }
+
     if(!toml["pdcch"].is_array_of_tables())
       throw config_exception("PDCCH TOML config should be an array of tables, e.g. [[pdcch]]");
     
@@ -150,6 +299,29 @@ struct config {
         pdcch_cfg.coreset_nshift = pdcch_table["coreset_nshift"].value_or(0);
         pdcch_cfg.coreset_reg_bundle_size = pdcch_table["coreset_reg_bundle_size"].value_or(6);
         pdcch_cfg.coreset_interleaver_size = pdcch_table["coreset_interleaver_size"].value_or(2);
+        pdcch_cfg.grid_recording_path = pdcch_table["grid_recording_path"].value_or(""sv).data();
+        pdcch_cfg.grid_recording_half_precision = pdcch_table["grid_recording_half_precision"].value_or(false);
+        pdcch_cfg.carrier = pdcch_table["carrier"].value_or(0);
+        pdcch_cfg.slot_budget_us = pdcch_table["slot_budget_us"].value_or(0.0);
+        pdcch_cfg.hot_rnti_count = pdcch_table["hot_rnti_count"].value_or(16);
+        pdcch_cfg.shed_recovery_slots = pdcch_table["shed_recovery_slots"].value_or(100);
+        pdcch_cfg.rnti_inactivity_timeout = pdcch_table["rnti_inactivity_timeout"].value_or(0.0);
+        if(pdcch_cfg.rnti_inactivity_timeout < 0)
+          throw config_exception("rnti_inactivity_timeout must not be negative");
+        pdcch_cfg.active_rnti_file = pdcch_table["active_rnti_file"].value_or(""sv).data();
+        pdcch_cfg.active_rnti_interval = pdcch_table["active_rnti_interval"].value_or(10.0);
+        if(pdcch_cfg.active_rnti_interval <= 0)
+          throw config_exception("active_rnti_interval must be positive");
+        pdcch_cfg.learned_rntis_only = pdcch_table["learned_rntis_only"].value_or(false);
+        toml::array* shed_order_array = pdcch_table["shed_order"].as<toml::array>();
+        if(shed_order_array){
+          for (auto&& elem : *shed_order_array)
+            pdcch_cfg.shed_order.push_back(parse_shed_step(string(elem.value_or(""sv))));
+        }else{
+          pdcch_cfg.shed_order = {shed_step::low_al, shed_step::rnti_list, shed_step::scrambling_ids};
+        }
+        if(pdcch_cfg.carrier >= std::max<size_t>(conf.carriers.size(), 1))
+          throw config_exception("PDCCH config refers to a carrier that is not configured");
         conf.pdcch_configs.push_back(pdcch_cfg);
       } else {
         SPDLOG_ERROR("Unexpected config file format");
@@ -157,6 +329,50 @@ struct config {
       }
     }
 
+    // Synthetic downlink used by 5g_nr_generator, which shares the [[pdcch]] configs with the sniffer
+    generator_config& gen = conf.generator;
+    // Never defaults to the sniffer file_path, which may be a real recording
+    gen.output_path = toml["generator"]["output_path"].value_or(""sv).data();
+    gen.truth_path = toml["generator"]["truth_path"].value_or(gen.output_path + ".csv");
+    gen.duration = toml["generator"]["duration"].value_or(1.0);
+    gen.snr_db = toml["generator"]["snr_db"].value_or(30.0);
+    gen.cfo = toml["generator"]["cfo"].value_or(0.0);
+    gen.timing_offset = toml["generator"]["timing_offset"].value_or(0);
+    gen.cell_id = toml["generator"]["cell_id"].value_or(1);
+    gen.sfn_start = toml["generator"]["sfn_start"].value_or(0);
+    gen.seed = toml["generator"]["seed"].value_or(1);
+    gen.ssb_offset = toml["generator"]["ssb_offset"].value_or(0);
+    gen.coreset0_idx = toml["generator"]["coreset0_idx"].value_or(0);
+    gen.ss0_idx = toml["generator"]["ss0_idx"].value_or(0);
+    gen.dmrs_typeA_pos = toml["generator"]["dmrs_typeA_pos"].value_or(false);
+    if(gen.cell_id > nid_max)
+      throw config_exception("Generator cell_id must be at most 1007");
+    if(gen.sfn_start >= 1024)
+      throw config_exception("Generator sfn_start must be below 1024");
+    if(toml["generator"]["dci"]) {
+      if(!toml["generator"]["dci"].is_array_of_tables())
+        throw config_exception("Generator DCI TOML config should be an array of tables, e.g. [[generator.dci]]");
+      for(toml::node& node : *toml["generator"]["dci"].as<toml::array>()) {
+        toml::table dci_table = *node.as_table();
+        generator_dci_config dci_cfg;
+        dci_cfg.pdcch = dci_table["pdcch"].value_or(0);
+        if(dci_cfg.pdcch >= conf.pdcch_configs.size())
+          throw config_exception("Generator DCI refers to a PDCCH that is not configured");
+        dci_cfg.rnti = dci_table["rnti"].value_or(SI_RNTI);
+        dci_cfg.scrambling_id = dci_table["scrambling_id"].value_or(gen.cell_id);
+        dci_cfg.aggregation_level = dci_table["aggregation_level"].value_or(4);
+        dci_cfg.candidate = dci_table["candidate"].value_or(0);
+        dci_cfg.dci_size = dci_table["dci_size"].value_or(conf.pdcch_configs.at(dci_cfg.pdcch).dci_sizes_list.at(0));
+        dci_cfg.slot_period = dci_table["slot_period"].value_or(1);
+        dci_cfg.slot_offset = dci_table["slot_offset"].value_or(0);
+        if(dci_cfg.slot_period == 0)
+          throw config_exception("Generator DCI slot_period must be at least 1");
+        if(dci_cfg.slot_offset >= dci_cfg.slot_period)
+          throw config_exception("Generator DCI slot_offset must be smaller than its slot_period");
+        gen.dcis.push_back(dci_cfg);
+      }
+    }
+
     return conf;
   }
 };
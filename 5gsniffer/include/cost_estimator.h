@@ -0,0 +1,74 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef COST_ESTIMATOR_H
+#define COST_ESTIMATOR_H
+
+#include <cstdint>
+#include <array>
+#include "config.h"
+#include "phy_params_common.h"
+
+using namespace std;
+
+/**
+ * Predicts the compute cost of the PDCCH brute force of a config before it is
+ * run. The kernel calls per slot follow from the CORESET and search space
+ * geometry, and are scaled by the cost of each kernel measured on this host.
+ */
+namespace cost_estimator {
+  /**
+   * Kernel calls per slot of one CORESET, per AL index (AL 1 to 16).
+   * Equalizations and decodes are for the worst case, in which every
+   * candidate passes the DMRS threshold and no DCI is found.
+   */
+  struct workload {
+    array<uint64_t, NUM_ALs> correlations = {};
+    array<uint64_t, NUM_ALs> equalizations = {};
+    array<uint64_t, NUM_ALs> decodes = {};
+    array<uint64_t, NUM_ALs> repetition_rntis = {}; ///< RNTIs scanned by the repetition optimization
+
+    uint64_t total_correlations() const;
+    uint64_t total_equalizations() const;
+    uint64_t total_decodes() const;
+  };
+
+  /**
+   * Seconds per call of each kernel, per AL index.
+   */
+  struct kernel_costs {
+    array<double, NUM_ALs> correlation = {};
+    array<double, NUM_ALs> equalization = {};
+    array<double, NUM_ALs> decode = {};
+    double repetition_rnti = 0;
+
+    static kernel_costs measure(double seconds_per_kernel = 0.02);
+  };
+
+  workload count_workload(const pdcch_config& pdcch_cfg);
+  double idle_seconds_per_slot(const workload& w, const kernel_costs& costs);
+  double worst_seconds_per_slot(const workload& w, const kernel_costs& costs);
+  uint32_t slots_per_second(const pdcch_config& pdcch_cfg);
+  uint32_t cells_per_pdcch(const struct config& conf);
+  void report(const struct config& conf);
+}
+
+#endif // COST_ESTIMATOR_H
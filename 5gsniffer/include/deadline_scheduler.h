@@ -0,0 +1,77 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef DEADLINE_SCHEDULER_H
+#define DEADLINE_SCHEDULER_H
+
+#include <cstdint>
+#include <vector>
+#include <set>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+
+using namespace std;
+
+/**
+ * Parts of the PDCCH search that can be shed when it falls behind.
+ */
+enum class shed_step : uint8_t {
+  low_al,           ///< Skip the candidates of AL 1 and 2
+  rnti_list,        ///< Only decode the hot RNTIs at the front of the RNTI list
+  scrambling_ids    ///< Only correlate the scrambling IDs DCIs were found with
+};
+
+shed_step parse_shed_step(const string& name);
+const char* shed_step_name(shed_step step);
+
+/**
+ * Per-slot compute budget of a PDCCH. Whenever a slot takes longer than the
+ * budget, the next step of the shedding order is applied, and once enough
+ * slots in a row take less than half of the budget, the last step applied is
+ * lifted. Flows processing the same PDCCH share the scheduler.
+ */
+class deadline_scheduler {
+  public:
+    deadline_scheduler(chrono::nanoseconds slot_budget, vector<shed_step> order, size_t hot_rnti_count = 16, uint32_t recovery_slots = 100);
+    virtual ~deadline_scheduler();
+
+    bool is_shedding(shed_step step) const;
+    uint8_t get_level() const;
+    bool skip_aggregation_level(uint8_t agg_level) const;
+    size_t rnti_limit(size_t num_rntis) const;
+    vector<uint16_t> get_scrambling_ids(uint16_t scrambling_id_start, uint16_t scrambling_id_end, uint16_t cell_id);
+    void add_hot_scrambling_id(uint16_t scrambling_id);
+    void slot_done(chrono::nanoseconds elapsed);
+
+  private:
+    const chrono::nanoseconds slot_budget;
+    const vector<shed_step> order;
+    const size_t hot_rnti_count;
+    const uint32_t recovery_slots;
+    atomic<uint8_t> level;
+    atomic<uint32_t> slots_under_budget;
+    mutex hot_scrambling_ids_mutex;
+    set<uint16_t> hot_scrambling_ids;
+};
+
+#endif // DEADLINE_SCHEDULER_H
@@ -38,6 +38,9 @@ void correlate_magnitude_normalized(vector<float>& output, span<complex<float>>
 void magnitude(vector<float>& output, span<complex<float>> input);
 float frobenius_norm(span<complex<float>> input);
 void rotate(vector<complex<float>>& output, span<complex<float>> input, float frequency, uint32_t sample_rate);
+void rotate(vector<complex<float>>& output, span<complex<float>> input, float frequency, uint32_t sample_rate, complex<float>& phase);
+void decimate(vector<complex<float>>& output, span<const complex<float>> input, span<const float> taps, size_t decimation);
+void cp_correlate(vector<complex<float>>& output, span<const complex<float>> samples, size_t delay, size_t window_size, span<const size_t> lags);
 
 
 #endif // DSP_H
\ No newline at end of file
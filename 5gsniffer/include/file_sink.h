@@ -38,7 +38,7 @@ class file_sink : public worker {
   public:
     file_sink(string path);
     virtual ~file_sink();
-    void process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata) override;
+    void process(shared_ptr<vector<complex<float>>>& samples, const frame_metadata& metadata) override;
   private:
     ofstream f;
 };
@@ -23,6 +23,7 @@
 #define FILE_SOURCE_H
 
 #include <cstdint>
+#include <chrono>
 #include <fstream>
 #include <string>
 #include <vector>
@@ -40,12 +41,37 @@ class file_source : public worker {
     int size_bytes;
     uint64_t sample_rate;
 
-    file_source(uint64_t sample_rate, string path, bool repeat = false);
+    file_source(uint64_t sample_rate, string path, bool repeat = false, bool realtime = false, bool follow = false, double follow_timeout = 0.0);
     virtual ~file_source();
     shared_ptr<vector<complex<float>>> produce_samples(size_t num_samples) override;
+    double get_lag_seconds();
+  protected:
+    int64_t get_timestamp_ns(int64_t sample_index) override;
   private:
     ifstream f;
+    string path;
     bool repeat;
+
+    // Following a file that is still being written
+    bool follow;
+    double follow_timeout;
+    int inotify_fd;
+    uint64_t next_lag_report;
+
+    bool wait_for_data();
+
+    // Real-time pacing
+    bool realtime;
+    chrono::steady_clock::time_point realtime_start;
+    chrono::steady_clock::time_point last_chunk_time;
+    double processing_seconds;
+    double signal_seconds;
+    double min_slack_seconds;
+    uint64_t num_chunks;
+    uint64_t num_overflows;
+
+    void pace(size_t num_samples);
+    void report_realtime_stats();
 };
 
 #endif
\ No newline at end of file
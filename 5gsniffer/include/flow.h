@@ -28,6 +28,7 @@
 #include <complex>
 #include <memory>
 #include <thread>
+#include <mutex>
 #include <zmq.hpp>
 #include "worker.h"
 
@@ -39,25 +40,25 @@ using namespace std;
  */
 class flow : public worker {
   public:
-    flow(uint64_t flow_id, zmq::socket_ref send_socket, shared_ptr<counting_semaphore<>> available_flows);
+    flow(uint64_t flow_id, zmq::socket_ref send_socket, shared_ptr<mutex> send_socket_mutex, shared_ptr<counting_semaphore<>> available_flows);
     virtual ~flow();
     // void process(shared_ptr<vector<complex<float>>>& samples) override;
-    void process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata) override;
+    void process(shared_ptr<vector<complex<float>>>& samples, const frame_metadata& metadata) override;
     void finish() override;
     void handle_messages();
     void set_available();
+    thread::native_handle_type native_handle();
 
     bool available;
     bool sniffer_finished;
     uint64_t flow_id;
   private:
-    void wait_for_start_message_ack(zmq::socket_ref send_socket);
     void wait_for_start_message(zmq::socket_ref receive_socket);
 
     thread t;
     zmq::socket_ref send_socket;
+    shared_ptr<mutex> send_socket_mutex; ///< ZMQ sockets are not thread-safe, and all flows of a pool share one
     std::string routing_id;
-    int64_t metadata;
     shared_ptr<counting_semaphore<>> available_flows;
 };
 
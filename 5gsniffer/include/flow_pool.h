@@ -27,6 +27,7 @@
 #include <memory>
 #include <zmq.hpp>
 #include <semaphore>
+#include <mutex>
 #include "flow.h"
 
 using namespace std;
@@ -36,20 +37,46 @@ using namespace std;
  * reserved by a worker to execute a certain flow graph.
  */
 namespace nr {
-  class flow_pool : public worker {
+  /**
+   * A pool of flows with their processing threads, shared by all syncers. The
+   * pool starts with initial_flows flows and doubles, up to max_flows, when a
+   * flow is acquired while none is available. Flow threads can be pinned to
+   * CPUs, one CPU per flow in turn.
+   */
+  class flow_pool {
     public:
-      flow_pool(uint64_t max_flows);
+      flow_pool(uint64_t max_flows, uint64_t initial_flows = 0, vector<int> cpus = {});
       virtual ~flow_pool();
-      void process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata) override;
       shared_ptr<flow> acquire_flow();
-      void release_flows();
+      size_t size();
+      static shared_ptr<flow_pool> from_config();
     private:
+      void add_flows(uint64_t num_flows);
+
       vector<shared_ptr<flow>> pool;
-      vector<shared_ptr<flow>> acquired_flows;
+      mutex pool_mutex;
       zmq::context_t main_ctx;
       zmq::socket_t zmq_socket;
+      shared_ptr<mutex> zmq_socket_mutex;
       shared_ptr<counting_semaphore<>> available_flows;
       uint64_t max_flows;
+      vector<int> cpus;
+  };
+
+  /**
+   * The flows a single syncer acquired from a flow_pool, to which it passes
+   * its synchronized samples.
+   */
+  class flow_set : public worker {
+    public:
+      flow_set(shared_ptr<flow_pool> pool);
+      virtual ~flow_set();
+      void process(shared_ptr<vector<complex<float>>>& samples, const frame_metadata& metadata) override;
+      shared_ptr<flow> acquire_flow();
+      void release_flows();
+    private:
+      shared_ptr<flow_pool> pool;
+      vector<shared_ptr<flow>> acquired_flows;
   };
 }
 
@@ -0,0 +1,44 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef FRAME_METADATA_H
+#define FRAME_METADATA_H
+
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * Metadata describing the first sample of a buffer passed between workers.
+ * It is plain data so it can be sent as is alongside the samples, e.g. as a
+ * separate ZMQ message part.
+ */
+struct frame_metadata {
+  int64_t sample_index = 0;     ///< Absolute index of the first sample, at the sample rate of the buffer it describes
+  int64_t timestamp_ns = 0;     ///< Time of the first sample in ns: SDR time, or time since the start of a recording
+  int32_t sfn = -1;             ///< System frame number of the first sample, -1 if unknown
+  int16_t slot_index = -1;      ///< Slot of the first sample within its frame in the SSB numerology, -1 if unknown
+  float cfo = 0.0f;             ///< Carrier frequency offset (Hz) already removed from the samples
+  uint32_t sync_generation = 0; ///< Incremented every time the syncer acquires the cell
+};
+
+static_assert(std::is_trivially_copyable_v<frame_metadata>, "frame_metadata is sent as raw bytes");
+
+#endif // FRAME_METADATA_H
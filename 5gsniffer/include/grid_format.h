@@ -0,0 +1,135 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef GRID_FORMAT_H
+#define GRID_FORMAT_H
+
+#include <cstdint>
+#include <cstring>
+#include "frame_metadata.h"
+
+/**
+ * On-disk format of a CORESET resource-grid recording. A recording starts with
+ * a grid_file_header, followed by one frame per CORESET monitoring occasion.
+ * Each frame is a grid_frame_header followed by num_res resource elements,
+ * stored as interleaved I/Q floats, or as IEEE 754 half floats if the
+ * grid_flag_half_precision flag is set. All fields are little endian.
+ */
+static constexpr uint32_t grid_magic = 0x44495247; ///< "GRID"
+static constexpr uint16_t grid_version = 1;
+static constexpr uint16_t grid_flag_half_precision = 1 << 0;
+static constexpr uint16_t grid_flag_extended_prefix = 1 << 1;
+
+#pragma pack(push, 1)
+struct grid_file_header {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t flags;
+  uint64_t sample_rate;
+  uint16_t cell_id;
+  uint8_t coreset_id;
+  uint8_t numerology;
+  uint16_t num_prbs;
+  uint8_t coreset_duration;
+  uint8_t coreset_ofdm_symbol_start;
+};
+
+struct grid_frame_header {
+  frame_metadata metadata; ///< Metadata of the buffer in which the occasion was demodulated
+  uint64_t sample_index;   ///< Sample index of the first CORESET symbol
+  uint16_t sfn;
+  uint8_t slot_index;
+  uint8_t symbol_index;
+  uint32_t num_res;        ///< Number of resource elements, aggregated over the CORESET duration
+};
+#pragma pack(pop)
+
+/**
+ * Converts a float to an IEEE 754 half float, rounding to nearest even.
+ *
+ * @param value float to convert
+ */
+inline uint16_t float_to_half(float value) {
+  uint32_t f;
+  std::memcpy(&f, &value, sizeof(f));
+  uint32_t sign = (f >> 16) & 0x8000;
+  uint32_t biased_exponent = (f >> 23) & 0xff;
+  uint32_t mantissa = f & 0x7fffff;
+  int32_t exponent = (int32_t)biased_exponent - 127 + 15;
+
+  if(biased_exponent == 0xff) // Inf or NaN
+    return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+  if(exponent >= 31) // Overflow to Inf
+    return sign | 0x7c00;
+  if(exponent <= 0) { // Subnormal or zero
+    if(exponent < -10)
+      return sign;
+    mantissa |= 0x800000;
+    uint32_t shift = 14 - exponent;
+    uint32_t half = mantissa >> shift;
+    uint32_t remainder = mantissa & ((1u << shift) - 1);
+    uint32_t halfway = 1u << (shift - 1);
+    if(remainder > halfway || (remainder == halfway && (half & 1)))
+      half++;
+    return sign | half;
+  }
+
+  uint32_t half = sign | (exponent << 10) | (mantissa >> 13);
+  uint32_t remainder = mantissa & 0x1fff;
+  if(remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+    half++; // A carry into the exponent is still the correctly rounded value
+  return half;
+}
+
+/**
+ * Converts an IEEE 754 half float to a float.
+ *
+ * @param half half float to convert
+ */
+inline float half_to_float(uint16_t half) {
+  uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+  uint32_t exponent = (half >> 10) & 0x1f;
+  uint32_t mantissa = half & 0x3ff;
+  uint32_t f;
+
+  if(exponent == 0) {
+    if(mantissa == 0) {
+      f = sign;
+    } else { // Subnormal, normalize it
+      exponent = 127 - 15 + 1;
+      while(!(mantissa & 0x400)) {
+        mantissa <<= 1;
+        exponent--;
+      }
+      f = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+    }
+  } else if(exponent == 0x1f) {
+    f = sign | 0x7f800000 | (mantissa << 13);
+  } else {
+    f = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+  }
+
+  float value;
+  std::memcpy(&value, &f, sizeof(value));
+  return value;
+}
+
+#endif // GRID_FORMAT_H
@@ -0,0 +1,51 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef GRID_SINK_H
+#define GRID_SINK_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include "worker.h"
+#include "grid_format.h"
+
+using namespace std;
+
+/**
+ * A worker that consumes the CORESET symbols produced by the channel_mapper
+ * and writes them to a grid recording, one frame per monitoring occasion.
+ */
+class grid_sink : public worker {
+  public:
+    grid_sink(string path, grid_file_header header);
+    virtual ~grid_sink();
+    void process(shared_ptr<vector<symbol>>& symbols, const frame_metadata& metadata) override;
+  private:
+    ofstream f;
+    bool half_precision;
+    vector<uint16_t> half_buffer;
+    std::mutex mutex; ///< The channel_mapper may be shared by flows that are still finishing
+};
+
+#endif
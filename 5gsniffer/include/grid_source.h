@@ -0,0 +1,61 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef GRID_SOURCE_H
+#define GRID_SOURCE_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include "worker.h"
+#include "grid_format.h"
+
+using namespace std;
+
+/**
+ * A worker that replays a grid recording made by grid_sink. The CORESET
+ * symbols are produced with the same grouping and metadata as when they were
+ * recorded, so they can be passed straight to nr::pdcch.
+ */
+class grid_source : public worker {
+  public:
+    grid_file_header header;
+
+    grid_source(string path);
+    virtual ~grid_source();
+    using worker::work;
+    void work(size_t num_samples) override;
+    shared_ptr<vector<symbol>> produce_symbols(size_t num_symbols) override;
+  private:
+    ifstream f;
+    bool half_precision;
+    vector<uint16_t> half_buffer;
+    bool has_pending;
+    symbol pending;
+    frame_metadata pending_metadata;
+    frame_metadata produced_metadata;
+
+    bool read_frame(symbol& s, frame_metadata& metadata);
+};
+
+#endif
@@ -0,0 +1,91 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef GSCN_H
+#define GSCN_H
+
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+/* Synchronization raster, 3GPP TS 38.104 Table 5.4.3.1-1 */
+static constexpr uint32_t gscn_min = 2;
+static constexpr uint32_t gscn_3ghz = 7499;     ///< First GSCN of the 3 GHz - 24.25 GHz range
+static constexpr uint32_t gscn_fr2 = 22256;     ///< First GSCN of the FR2 range
+static constexpr uint32_t gscn_max = 26639;
+
+/**
+ * Returns the SSB center frequency (SS_REF) of a global synchronization channel number.
+ *
+ * @param gscn global synchronization channel number
+ */
+inline double gscn_to_frequency(uint32_t gscn) {
+  if(gscn < gscn_3ghz) {
+    // SS_REF = N * 1200 kHz + M * 50 kHz, with GSCN = 3N + (M - 3) / 2 and M in {1, 3, 5}
+    uint32_t n = (gscn + 1) / 3;
+    int32_t m = 2 * ((int32_t)gscn - 3 * (int32_t)n) + 3;
+    return n * 1.2e6 + m * 50e3;
+  } else if(gscn < gscn_fr2) {
+    return 3000e6 + (gscn - gscn_3ghz) * 1.44e6;
+  } else {
+    return 24250.08e6 + (gscn - gscn_fr2) * 17.28e6;
+  }
+}
+
+/**
+ * Returns the first GSCN whose SS_REF is at or above a frequency.
+ *
+ * @param frequency frequency in Hz
+ */
+inline uint32_t frequency_to_gscn(double frequency) {
+  // Start slightly below the frequency and step up to it
+  int64_t estimate;
+  if(frequency < 3000e6) {
+    estimate = 3 * (int64_t)std::floor(frequency / 1.2e6) - 1;
+  } else if(frequency < 24250.08e6) {
+    estimate = gscn_3ghz + (int64_t)std::floor((frequency - 3000e6) / 1.44e6);
+  } else {
+    estimate = gscn_fr2 + (int64_t)std::floor((frequency - 24250.08e6) / 17.28e6);
+  }
+  uint32_t gscn = (uint32_t)std::clamp<int64_t>(estimate, gscn_min, gscn_max);
+  while(gscn < gscn_max && gscn_to_frequency(gscn) < frequency)
+    gscn++;
+  return gscn;
+}
+
+/**
+ * Returns all GSCNs whose SS_REF lies within a frequency range.
+ *
+ * @param frequency_start lowest frequency in Hz
+ * @param frequency_end highest frequency in Hz
+ */
+inline vector<uint32_t> gscns_in_range(double frequency_start, double frequency_end) {
+  vector<uint32_t> gscns;
+  for(uint32_t gscn = frequency_to_gscn(frequency_start); gscn <= gscn_max && gscn_to_frequency(gscn) <= frequency_end; gscn++) {
+    gscns.push_back(gscn);
+  }
+  return gscns;
+}
+
+#endif // GSCN_H
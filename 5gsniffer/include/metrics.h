@@ -0,0 +1,130 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <cstdint>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <memory>
+
+using namespace std;
+
+/**
+ * Always-on pipeline metrics. Counters and stage latency histograms are kept
+ * per thread, so recording is an uncontended store, and are only summed when
+ * scraped. Gauges are shared and updated with deltas, so the contributions of
+ * all syncers and flows add up.
+ */
+namespace metrics {
+  enum counter : uint16_t {
+    chunks_in,            ///< Buffers produced by the device
+    samples_in,           ///< Samples produced by the device
+    symbols_out,          ///< OFDM symbols demodulated
+    pss_found,
+    sync_losses,          ///< Tracked SSBs that were missed
+    mibs_decoded,
+    mibs_predicted,
+    dmrs_candidates_al1,  ///< PDCCH candidates whose DMRS correlation is over the threshold of their AL
+    dmrs_candidates_al2,
+    dmrs_candidates_al4,
+    dmrs_candidates_al8,
+    dmrs_candidates_al16,
+    polar_decodes,
+    crc_passes,
+    slots_over_budget,    ///< CORESET slots whose PDCCH search took longer than the slot budget
+    shed_correlations,    ///< DMRS correlations skipped by the deadline scheduler
+    shed_decodes,         ///< Polar decodes, or RNTIs of the repetition optimization, skipped by the deadline scheduler
+    num_counters
+  };
+
+  enum stage : uint16_t {
+    sniffer_work,         ///< Producing and processing one device buffer
+    syncer_process,
+    syncer_find_pss,
+    syncer_find_sss,
+    ofdm_process,
+    pdcch_process,        ///< Processing one CORESET symbol
+    pdcch_correlate_dmrs,
+    pdcch_decode,         ///< Decoding one candidate with one DCI size, over all RNTIs
+    num_stages
+  };
+
+  enum gauge : uint16_t {
+    flows_in_use,
+    fanout_tasks_pending,
+    syncer_queued_samples,
+    pdcch_shed_level,     ///< Shedding steps applied, summed over all PDCCHs
+    active_rntis,         ///< RNTIs with a recent DCI, summed over all PDCCHs with an active RNTI table
+    num_gauges
+  };
+
+  static constexpr size_t num_latency_buckets = 22; ///< Upper bounds of 1 us up to 2^20 us, and +Inf
+
+  void count(counter c, uint64_t n = 1);
+  void record_latency(stage s, chrono::nanoseconds duration);
+  void add_gauge(gauge g, int64_t delta);
+  uint64_t get_counter(counter c);
+  uint64_t get_latency_count(stage s);
+  int64_t get_gauge(gauge g);
+  string to_prometheus();
+
+  /**
+   * Records the time from its construction to its destruction as the latency
+   * of a stage.
+   */
+  class stage_timer {
+    public:
+      stage_timer(stage s) : s(s), start(chrono::steady_clock::now()) {}
+      ~stage_timer() { record_latency(s, chrono::steady_clock::now() - start); }
+    private:
+      stage s;
+      chrono::steady_clock::time_point start;
+  };
+
+  /**
+   * Exposes the metrics in the Prometheus text format, on a local HTTP
+   * endpoint and/or in a file that is rewritten periodically.
+   */
+  class exporter {
+    public:
+      exporter(int port, string file_path = "", double interval = 10.0);
+      virtual ~exporter();
+      int get_port();
+      static unique_ptr<exporter> from_config();
+    private:
+      void run();
+      void serve_request();
+      void write_file();
+
+      int listen_fd;
+      int port;
+      string file_path;
+      chrono::duration<double> interval;
+      atomic<bool> stopping;
+      thread t;
+  };
+}
+
+#endif // METRICS_H
@@ -0,0 +1,92 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef NR_GENERATOR_H
+#define NR_GENERATOR_H
+
+#include <cstdint>
+#include <complex>
+#include <vector>
+#include <memory>
+#include <map>
+#include <random>
+#include <string>
+#include <srsran/srsran.h>
+#include "config.h"
+#include "bandwidth_part.h"
+#include "ofdm.h"
+#include "pdcch.h"
+
+using namespace std;
+
+namespace nr {
+  /**
+   * A DCI written into the generated signal, as listed in the ground truth file.
+   */
+  struct generated_dci {
+    uint64_t sample_index;     ///< First sample (start of the CP) of the first CORESET symbol
+    uint16_t sfn;
+    uint8_t slot_index;
+    uint8_t symbol_index;
+    size_t pdcch;              ///< Index of the [[pdcch]] config of the CORESET
+    uint16_t rnti;
+    uint16_t scrambling_id;
+    uint8_t aggregation_level;
+    uint8_t candidate;
+    vector<uint8_t> payload;
+  };
+
+  /**
+   * Synthesizes a 15 kHz NR downlink: an SSB with PSS, SSS, PBCH and its DMRS
+   * every 20 ms, and the configured DCIs on their CORESETs. The signal can be
+   * impaired with a CFO, a timing offset and white noise, so that it can be
+   * fed to the sniffer with a known ground truth.
+   */
+  class nr_generator {
+    public:
+      nr_generator(uint64_t sample_rate, vector<pdcch_config> pdcch_configs, generator_config cfg);
+      ~nr_generator();
+
+      vector<complex<float>> modulate_frame(uint16_t sfn, vector<generated_dci>& dcis);
+      void impair(vector<complex<float>>& samples);
+      uint64_t write(const string& output_path, const string& truth_path);
+
+      const uint64_t sample_rate;
+      const uint64_t samples_per_frame;
+
+    private:
+      void map_ssb(vector<symbol>& slot, uint16_t sfn);
+      void map_dci(vector<symbol>& slot, uint8_t slot_index, const generator_dci_config& dci_cfg, generated_dci& dci);
+      nr::pdcch& get_pdcch(size_t pdcch_index, uint16_t scrambling_id);
+
+      vector<pdcch_config> pdcch_configs;
+      generator_config cfg;
+      shared_ptr<bandwidth_part> bwp;
+      ofdm modulator;
+      srsran_pbch_nr_t pbch_nr;
+      map<pair<size_t, uint16_t>, unique_ptr<nr::pdcch>> pdcchs; ///< DMRS tables and encoders per CORESET and scrambling ID
+      mt19937 rng;
+      float noise_stddev;
+      complex<float> cfo_phase;
+  };
+}
+
+#endif // NR_GENERATOR_H
@@ -39,15 +39,15 @@ class ofdm : public worker {
   public:
     uint8_t symbol_index; ///< Index of the current symbol in the subframe
     uint8_t slot_index;   ///< Index of the current slot in the frame
+    uint16_t sfn;         ///< System frame number of the current frame
     
     ofdm(shared_ptr<bandwidth_part> bwp, float cyclic_prefix_fraction = 0.5);
     virtual ~ofdm();
-    void process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata) override;
+    void process(shared_ptr<vector<complex<float>>>& samples, const frame_metadata& metadata) override;
     vector<complex<float>> modulate(vector<symbol>& symbols);
   private:
     shared_ptr<bandwidth_part> bwp;
     float cyclic_prefix_fraction;
-    uint64_t samples_processed;
     std::vector<std::complex<float>> leftover_samples;
 
 
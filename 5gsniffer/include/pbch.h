@@ -28,6 +28,8 @@
 #include <memory>
 #include <srsran/srsran.h>
 #include <span>
+#include <array>
+#include <optional>
 #include "worker.h"
 #include "phy.h"
 
@@ -41,21 +43,28 @@ namespace nr {
     public:
       pbch(shared_ptr<nr::phy> phy);
       virtual ~pbch();
+      pbch(const pbch&) = delete;
+      pbch& operator=(const pbch&) = delete;
       std::function<void(srsran_mib_nr_t&, bool)> on_mib_found = [](srsran_mib_nr_t& mib, bool found) {};
-      void process(shared_ptr<vector<symbol>>& symbols, int64_t metadata) override;
-      float get_ibar_ssb_snr(uint8_t i_ssb, uint8_t n_hf, vector<symbol> symbols);
+      void process(shared_ptr<vector<symbol>>& symbols, const frame_metadata& metadata) override;
+      float get_ibar_ssb_snr(uint8_t i_ssb, uint8_t n_hf, vector<symbol>& symbols);
       float channel_estimate(uint8_t i_ssb, uint8_t n_hf, vector<symbol>& symbols);
       static vector<uint64_t> get_dmrs_indices(uint8_t ofdm_symbol_number, uint16_t cell_id);
       static vector<uint64_t> get_data_indices(uint8_t ofdm_symbol_number, uint16_t cell_id);
       void initialize_dmrs_seq();
-      // Tables for optimization
-      std::unordered_map<string, std::vector<std::complex<float>> > dmrs_seq_table;
-      std::unordered_map<string, std::vector<uint64_t> > dmrs_sc_indices_table;
+      // Tables for optimization, built once per cell ID. Indexed by [i_ssb][n_hf][symbol_index - 1] and [symbol_index - 1].
+      std::array<std::array<std::array<std::vector<std::complex<float>>, 3>, 2>, 5> dmrs_seq_table;
+      std::array<std::vector<uint64_t>, 3> dmrs_sc_indices_table;
+      std::array<std::vector<uint64_t>, 3> data_sc_indices_table;
 
     private:
       void decode(vector<complex<float>>& soft_symbols);
       
       shared_ptr<nr::phy> phy;
+      optional<uint16_t> table_cell_id; ///< Cell ID the tables were built for
+      srsran_pbch_nr_t pbch_nr;
+      bool pbch_nr_initialized;
+      vector<complex<float>> pbch_symbols;
   };
 }
 
@@ -27,9 +27,12 @@
 #include "dci.h"
 #include <cmath>
 #include "worker.h"
-#include <semaphore>
 #include <srsran/srsran.h>
 #include "srsran_exports.h"
+#include "deadline_scheduler.h"
+#include "rnti_recency_list.h"
+#include "active_rnti_table.h"
+#include "rnti_scrambling_map.h"
 
 namespace nr {
   class pdcch : public worker {
@@ -47,6 +50,12 @@ namespace nr {
       // Used to compute the timing of found DCIs
       uint64_t sample_rate_time;
       int rnti_list_length;
+      // Sheds work when a slot is over its compute budget, if set
+      shared_ptr<deadline_scheduler> scheduler;
+      // Limits the RNTIs decoded at low ALs to the recently found ones, if set
+      shared_ptr<active_rnti_table> active_rntis;
+      // Only decode the RNTIs learned for a scrambling ID, once there are some
+      bool learned_rntis_only;
 
       /*Constructor/Destructor*/
       pdcch();
@@ -60,6 +69,7 @@ namespace nr {
       void set_coreset_info(coreset coreset_info_);
       void initialize_RNTI_list();
       bool update_RNTI_list(uint16_t found_RNTI);
+      int get_rnti_list_length();
       void initialize_dmrs_seq(); 
 
       std::vector<dci> get_found_dci_list_per_AL(uint8_t AL, std::vector<dci>& found_dci_list);
@@ -68,7 +78,7 @@ namespace nr {
       int delete_lower_AL_dcis(uint16_t scrambling_id, uint8_t n_slot, uint8_t n_ofdm , uint8_t candidate_idx, uint8_t AL, std::vector<dci>& found_dci_list);
 
     /*Function that processes input symbols to PDCCH, finding PDCCH/DMRS, decoding, starts here*/
-      void process(shared_ptr<vector<symbol>>& symbols, int64_t metadata) override;
+      void process(shared_ptr<vector<symbol>>& symbols, const frame_metadata& metadata) override;
     
     /*Aux function that finds candidates based on subcarriers where power was found*/
       std::vector<uint8_t> find_list_candidates(std::vector<uint16_t> occupied_subcarriers, uint8_t agg_level,uint8_t nSlot, bool user_search_space);
@@ -84,7 +94,10 @@ namespace nr {
       std::vector<std::complex<float>> estimate_channel_dci(symbol& symbol, dci dci_);
 
     /*PDCCH decoder*/
-    int decode_pdcch(symbol& symbol, std::vector<std::complex<float>>& pdcch_symbols, dci dci_, srsran_pdcch_nr_res_t* res, bool rep_opt, int64_t metadata, int symbol_in_chunk);
+    int decode_pdcch(symbol& symbol, std::vector<std::complex<float>>& pdcch_symbols, dci dci_, srsran_pdcch_nr_res_t* res, bool rep_opt, const frame_metadata& metadata);
+
+    /*PDCCH encoder, the inverse of decode_pdcch. Used to synthesize test signals*/
+    std::vector<std::complex<float>> encode_pdcch(const std::vector<uint8_t>& payload, uint16_t rnti, uint16_t pdcch_scrambling_id, uint8_t aggregation_level);
 
     
     /*Util functions to generate PDCCH RB/SC indices, candidates, etc*/
@@ -116,7 +129,10 @@ namespace nr {
     private:
       uint16_t RNTI;
       coreset coreset_info;
-      std::vector<uint16_t> found_RNTI_list;
+      rnti_recency_list rnti_list;
+      rnti_scrambling_map learned_scrambling_ids;
+
+      double get_symbol_time(const symbol& symbol, const frame_metadata& metadata);
 
       void write_pdcch_symbol_metadata(uint64_t sample_index, uint16_t scrambling_id, uint8_t aggregation_level, uint8_t candidate_idx, float correlation);
   };
@@ -44,7 +44,6 @@ namespace nr {
       shared_ptr<bandwidth_part> ssb_bwp;                 ///< Special bandwidth part used for the SSB only
       vector<shared_ptr<bandwidth_part>> bandwidth_parts;
       vector<shared_ptr<channel_mapper>> channel_mappers;
-      std::array<std::array<std::complex<float>,sss_length>,nid_max+1> ssss;
 
       phy();
       uint16_t get_cell_id() const;
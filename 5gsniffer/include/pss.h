@@ -25,6 +25,9 @@
 #include <liquid/liquid.h>
 #include <complex>
 #include <utility>
+#include <vector>
+#include <span>
+#include <cstdint>
 #include "common_checks.h"
 
 class pss
@@ -68,4 +71,39 @@ private:
 
 };
 
-#endif
\ No newline at end of file
+/**
+ * Coarse-to-fine PSS search. A coarse pass correlates a lowpass filtered and
+ * decimated copy of the signal with equally decimated, thus shorter, PSS
+ * templates to find candidate peaks. Only small windows around the candidates
+ * are then correlated with the full PSS to find the exact timing.
+ */
+class pss_detector
+{
+public:
+  pss_detector(uint16_t decimation, uint16_t num_candidates = 3, uint16_t refine_window = 0);
+
+  bool search(std::span<std::complex<float>> samples, uint8_t nid_2_start, uint8_t nid_2_end, int64_t& position, float& correlation, uint8_t& nid_2);
+  uint64_t get_cost(uint64_t num_samples, uint8_t num_nid_2) const;
+  static uint64_t get_exhaustive_cost(uint64_t num_samples, uint8_t num_nid_2);
+
+private:
+  struct candidate {
+    float correlation;
+    int64_t position;
+    uint8_t nid_2;
+  };
+
+  static constexpr int64_t average_lags = 64; ///< Lags the average full PSS correlation is estimated from
+
+  uint16_t decimation;
+  uint16_t num_candidates;
+  uint16_t refine_window;
+  std::vector<float> taps;
+  std::array<std::array<std::complex<float>,ssb_nfft>,nid_2_max + 1> templates;
+  std::array<std::vector<std::complex<float>>,nid_2_max + 1> coarse_templates;
+  std::vector<std::complex<float>> decimated;
+  std::vector<float> correlations;
+  std::vector<candidate> candidates;
+};
+
+#endif
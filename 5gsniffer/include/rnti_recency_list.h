@@ -0,0 +1,85 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef RNTI_RECENCY_LIST_H
+#define RNTI_RECENCY_LIST_H
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <array>
+#include <memory>
+#include <atomic>
+#include <mutex>
+
+using namespace std;
+
+/**
+ * The RNTIs searched by a PDCCH, most recently found first. Changes are O(1):
+ * they update a lock-free membership bitmap and are appended to a log.
+ * Decoders never read the list while it changes: they read immutable
+ * snapshots of its order, which are rebuilt on demand by merging the log into
+ * the previous snapshot. The lock is only held to change the list or to copy
+ * the log, never during a merge, and a reader that finds the lock taken keeps
+ * using the previous snapshot.
+ */
+class rnti_recency_list {
+  public:
+    typedef vector<uint16_t> snapshot;
+
+    rnti_recency_list();
+    virtual ~rnti_recency_list();
+
+    void assign(uint16_t rnti_start, uint16_t rnti_end);
+    bool promote(uint16_t rnti);
+    bool push_front(uint16_t rnti);
+    bool remove(uint16_t rnti);
+    bool contains(uint16_t rnti) const;
+    size_t size() const;
+    shared_ptr<const snapshot> get_snapshot();
+
+  private:
+    struct published_snapshot {
+      uint64_t version;
+      snapshot rntis;
+    };
+
+    struct change {
+      uint64_t version;
+      uint16_t rnti;
+      bool to_front;  ///< Moved or added to the front, otherwise removed
+    };
+
+    bool log_change(uint16_t rnti, bool to_front);
+    void set_member(uint16_t rnti, bool member);
+    shared_ptr<const published_snapshot> rebuild(bool wait);
+
+    static constexpr size_t num_rntis = 1 << 16;
+
+    deque<change> changes;    ///< Changes not merged into the published snapshot yet
+    atomic<size_t> count;
+    array<atomic<uint64_t>, num_rntis / 64> members;
+    mutex write_mutex;
+    atomic<uint64_t> version;
+    atomic<shared_ptr<const published_snapshot>> published;
+};
+
+#endif // RNTI_RECENCY_LIST_H
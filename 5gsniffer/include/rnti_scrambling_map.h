@@ -0,0 +1,68 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef RNTI_SCRAMBLING_MAP_H
+#define RNTI_SCRAMBLING_MAP_H
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+
+using namespace std;
+
+/**
+ * The pdcch-DMRS-ScramblingID learned for each RNTI from the DCIs found for
+ * it. A UE keeps its scrambling ID for the whole RRC connection, so the
+ * candidates correlated with a scrambling ID most likely carry the DCIs of
+ * the RNTIs it was learned for. Readers get immutable sets of RNTIs, which
+ * are copied on write, as RNTIs are learned far less often than candidates
+ * are decoded.
+ */
+class rnti_scrambling_map {
+  public:
+    struct rnti_set {
+      vector<uint16_t> rntis;   ///< Most recently learned first
+      vector<uint16_t> sorted;  ///< The same RNTIs, in ascending order
+      bool contains(uint16_t rnti) const;
+    };
+
+    rnti_scrambling_map();
+    virtual ~rnti_scrambling_map();
+
+    static bool is_learnable(uint16_t rnti, uint16_t scrambling_id, uint16_t cell_id);
+    bool learn(uint16_t rnti, uint16_t scrambling_id);
+    bool forget(uint16_t rnti);
+    shared_ptr<const rnti_set> get_rntis(uint16_t scrambling_id) const;
+    bool get_scrambling_id(uint16_t rnti, uint16_t& scrambling_id) const;
+    size_t size() const;
+
+  private:
+    void remove_locked(uint16_t rnti, uint16_t scrambling_id);
+
+    mutable mutex map_mutex;
+    unordered_map<uint16_t, uint16_t> scrambling_ids;            ///< Scrambling ID of each RNTI
+    unordered_map<uint16_t, shared_ptr<const rnti_set>> rntis;  ///< RNTIs of each scrambling ID
+    const shared_ptr<const rnti_set> no_rntis;
+};
+
+#endif // RNTI_SCRAMBLING_MAP_H
@@ -37,7 +37,7 @@ using namespace std;
 class rotator : public worker {
   public:
     rotator(uint32_t sample_rate, float frequency);
-    void process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata) override;
+    void process(shared_ptr<vector<complex<float>>>& samples, const frame_metadata& metadata) override;
   private:
     float frequency;
     uint32_t sample_rate;
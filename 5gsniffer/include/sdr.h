@@ -48,6 +48,9 @@ class sdr : public worker {
     virtual ~sdr();
     shared_ptr<vector<complex<float>>> produce_samples(size_t num_samples) override;
 
+  protected:
+    int64_t get_timestamp_ns(int64_t sample_index) override;
+
   private:
     double sample_rate;
     double frequency;
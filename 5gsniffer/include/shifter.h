@@ -37,7 +37,7 @@ using namespace std;
 class shifter : public worker {
   public:
     shifter(int64_t num_samples);
-    void process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata) override;
+    void process(shared_ptr<vector<complex<float>>>& samples, const frame_metadata& metadata) override;
   private:
     int64_t num_samples;
 };
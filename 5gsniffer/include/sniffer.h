@@ -34,7 +34,8 @@ using namespace std;
 class sniffer {
   public:
     sniffer(uint64_t sample_rate, uint64_t frequency, string rf_args, uint16_t ssb_numerology); ///< Create a sniffer for an SDR source.
-    sniffer(uint64_t sample_rate, string path, uint16_t ssb_numerology); ////< Create a sniffer for a file source.
+    sniffer(uint64_t sample_rate, string path, uint16_t ssb_numerology, bool realtime = false, bool follow = false, double follow_timeout = 0.0); ////< Create a sniffer for a file source.
+    sniffer(string grid_path); ///< Create a sniffer that replays a CORESET grid recording.
     virtual ~sniffer();
     void start();
     void stop();
@@ -44,6 +45,8 @@ class sniffer {
     unique_ptr<worker> device;
   private:
     void init();
+    vector<shared_ptr<syncer>> create_syncers(uint64_t sample_rate, shared_ptr<nr::flow_pool> flow_pool, uint8_t carrier);
+    void init_grid_replay();
     bool running;
 };
 
@@ -32,6 +32,7 @@
 #include "worker.h"
 #include "phy.h"
 #include "pss.h"
+#include "sss.h"
 #include "pbch.h"
 
 using namespace std;
@@ -44,15 +45,21 @@ class ssb_mapper : public worker {
     // Callbacks
     std::function<void(uint16_t)> on_sss_found = [](uint16_t nid1) {}; ///< Default callback when SSS is found: do nothing
     std::function<void(void)> on_sss_not_found = [](){}; ///< Callback when SSS is not found
+    std::function<void(void)> on_mib_predictable = [](){}; ///< Callback when the SSS of the tracked cell is found while predicting the MIB
 
-    ssb_mapper(shared_ptr<nr::phy> phy);
+    ssb_mapper(shared_ptr<nr::phy> phy, bool sss_fast_transform = false);
     virtual ~ssb_mapper();
-    void process(shared_ptr<vector<symbol>>& symbols, int64_t metadata) override;
+    void process(shared_ptr<vector<symbol>>& symbols, const frame_metadata& metadata) override;
 
     // Sublayers
     nr::pbch pbch;
+    bool predicting_mib; ///< Skip the PBCH of the tracked cell if its SSS is still found
   private:
+    bool detect_sss(vector<symbol>& symbols, uint16_t& nid1);
+
     shared_ptr<nr::phy> phy;
+    class sss_detector sss_detector;
+    std::array<float, nid_1_max+1> sss_correlations;
 };
 
 #endif // SSB_MAPPER_H
\ No newline at end of file
@@ -29,8 +29,12 @@
 #include <algorithm>
 #include <utility>
 #include <memory>
+#include <span>
 #include "common_checks.h"
 
+/* All SSS of each PSS index as +1/-1 values, indexed by [nid_2][nid_1][subcarrier] */
+typedef std::array<std::array<std::array<float,sss_length>,nid_1_max+1>,nid_2_max+1> sss_reference_matrix;
+
 class sss
 {
 public:
@@ -66,4 +70,35 @@ private:
   std::array <std::complex<float>,ssb_nfft>  sss_seq_t;
 };
 
+/**
+ * Identifies a received SSS by correlating it with all 336 SSS of its PSS
+ * index at once, either as a single matrix-vector product against the shared
+ * reference matrix, or with a fast transform that exploits that each SSS is
+ * the product of two cyclically shifted m-sequences.
+ */
+class sss_detector
+{
+public:
+  sss_detector(bool fast_transform = false);
+  ~sss_detector();
+  sss_detector(const sss_detector&) = delete;
+  sss_detector& operator=(const sss_detector&) = delete;
+
+  void correlate(std::span<const std::complex<float>> sss_res, uint8_t nid_2, std::array<float,nid_1_max+1>& correlations);
+  static const sss_reference_matrix& get_reference_matrix();
+
+private:
+  void correlate_matrix(std::span<const std::complex<float>> sss_res, uint8_t nid_2, std::array<float,nid_1_max+1>& correlations);
+  void correlate_m_sequences(std::span<const std::complex<float>> sss_res, uint8_t nid_2, std::array<float,nid_1_max+1>& correlations);
+
+  bool fast_transform;
+  std::array<float,sss_length> x_0;
+  std::array<std::complex<float>,sss_length> x_1_fft;
+  std::array<std::complex<float>,sss_length> z;
+  std::array<std::complex<float>,sss_length> z_fft;
+  std::array<std::complex<float>,sss_length> c;
+  fftplan forward;
+  fftplan backward;
+};
+
 #endif
\ No newline at end of file
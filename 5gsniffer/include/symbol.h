@@ -56,6 +56,7 @@ class symbol {
     vector<complex<float>> noise;
     uint8_t symbol_index;
     uint8_t slot_index;
+    uint16_t sfn; ///< System frame number the symbol belongs to
     span<complex<float>> get_res(size_t start_index, size_t end_index);
 
     // Equalization
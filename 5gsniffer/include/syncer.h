@@ -28,11 +28,15 @@
 #include <vector>
 #include <complex>
 #include <memory>
+#include <optional>
+#include <functional>
 #include "worker.h"
 #include "pss.h"
 #include "sss.h"
 #include "phy.h"
 #include "flow_pool.h"
+#include "ssb_mapper.h"
+#include "cfo_hypothesis_bank.h"
 #include <srsran/srsran.h>
 
 using namespace std;
@@ -42,19 +46,27 @@ using namespace std;
  */
 class syncer : public worker {
   public:
-    syncer(uint64_t sample_rate, shared_ptr<nr::phy> phy);
+    syncer(uint64_t sample_rate, shared_ptr<nr::phy> phy, shared_ptr<nr::flow_pool> flow_pool = nullptr, optional<uint8_t> nid2 = nullopt, uint8_t carrier = 0);
     virtual ~syncer();
-    void process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata) override;
+    void process(shared_ptr<vector<complex<float>>>& samples, const frame_metadata& metadata) override;
+
+    std::function<void(srsran_mib_nr_t&, float)> on_cell_found = [](srsran_mib_nr_t& mib, float cfo) {}; ///< Callback with the MIB and CFO when synchronized to a cell
   private:
+    friend class syncer_test; ///< Hands SSBs to the syncer without a PSS search
+
     void downsample(uint64_t num_samples, int64_t start_sample, int64_t end_sample);
     void fine_sync();
     void find_pss();
     void find_sss();
     void fine_time_sync();
+    void send_queue_front(shared_ptr<vector<complex<float>>> samples);
+    void anchor_frame_timing(srsran_mib_nr_t& mib);
+    void label_frame_timing(frame_metadata& metadata);
 
     std::array<uint8_t, 4> pdcch_coreset0_get(uint16_t min_chann_bw, uint32_t ssb_scs, uint32_t pdcch_scs, uint8_t coreset0_idx);
 
     // Callbacks
+    void on_mib_predictable();
     void on_sss_found(uint16_t nid1);
     void on_sync_lost();
     void on_mib_found(srsran_mib_nr_t& mib, bool found);
@@ -64,6 +76,8 @@ class syncer : public worker {
     shared_ptr<nr::phy> phy;
     enum class state { find_pss, fine_sync, find_sss, wait, reset, relay } state;
     vector<pss> psss;
+    unique_ptr<pss_detector> coarse_pss; ///< Coarse-to-fine PSS search for initial acquisition, if enabled
+    unique_ptr<cfo_hypothesis_bank> cfo_bank; ///< Integer CFO search for initial acquisition, if enabled
     sss ssss;
     vector<complex<float>> processing_queue;
     vector<complex<float>> downsampled_samples;
@@ -71,13 +85,30 @@ class syncer : public worker {
     float resampling_rate;
     uint32_t max_resampled_samples_per_sample;
     float cfo;
+    float cfo_integer; ///< Part of the CFO found by the integer CFO search
     float new_cfo_fine;
     int64_t sss_hint;
     uint64_t mib_id;
     int waiting_for_pss;
-    int64_t counting_samples;
+    frame_metadata queue_metadata; ///< Describes the first sample of the processing queue
+    uint32_t sync_generation;
+
+    // Frame timing, anchored at the last decoded MIB
+    bool anchored;
+    int64_t anchor_sample_index;
+    uint32_t anchor_sfn;
+    uint32_t anchor_slot; ///< Slot in the SSB numerology
     float ssb_period;
-    shared_ptr<nr::flow_pool> flow_pool;
+    shared_ptr<nr::flow_set> flows;
+    shared_ptr<class ssb_mapper> ssb_mapper;
+
+    // SFN prediction, skipping PBCH decoding while tracking the cell
+    srsran_mib_nr_t last_mib;
+    bool last_mib_valid;
+    bool predicting_mib;
+    uint32_t mibs_predicted; ///< SSBs whose MIB was predicted since the last decoded one
+    int64_t reported_queue_size; ///< Processing queue length last added to the syncer_queued_samples gauge
+    uint8_t carrier;
     uint8_t pss_start;
     uint8_t pss_end;
     int pss_window_size;
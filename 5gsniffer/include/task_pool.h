@@ -0,0 +1,83 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef TASK_POOL_H
+#define TASK_POOL_H
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+using namespace std;
+
+/**
+ * A fixed set of threads that run submitted tasks, shared by all workers that
+ * fan out their work in parallel.
+ */
+class task_pool {
+  public:
+    task_pool(size_t num_threads = 0);
+    virtual ~task_pool();
+    void submit(function<void()> task);
+    size_t size();
+    static shared_ptr<task_pool> from_config();
+  private:
+    void run();
+
+    vector<thread> threads;
+    deque<function<void()>> tasks;
+    mutex tasks_mutex;
+    condition_variable tasks_available;
+    bool stopping;
+};
+
+/**
+ * An ordered queue of tasks that run on a task_pool. Tasks of one queue run
+ * one at a time and in the order they were pushed, while the tasks of
+ * different queues run in parallel. An exception thrown by a task is rethrown
+ * by the next call to wait.
+ */
+class task_queue {
+  public:
+    task_queue(shared_ptr<task_pool> pool);
+    virtual ~task_queue();
+    void push(function<void()> task);
+    void wait(size_t max_pending = 0);
+    size_t pending();
+  private:
+    void run_tasks();
+
+    shared_ptr<task_pool> pool;
+    deque<function<void()>> tasks;
+    mutex tasks_mutex;
+    condition_variable tasks_done;
+    size_t num_pending;
+    bool running;
+    exception_ptr error;
+};
+
+#endif // TASK_POOL_H
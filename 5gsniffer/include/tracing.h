@@ -0,0 +1,79 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <cstdint>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <memory>
+
+using namespace std;
+
+/**
+ * Opt-in timeline tracer for the processing graph. Every thread records its
+ * events in its own ring buffer, without locks, and the rings are dumped as
+ * Chrome trace JSON, which chrome://tracing and the Perfetto UI open.
+ */
+namespace tracing {
+  extern atomic<bool> enabled;
+
+  void enable(size_t events_per_thread = 65536);
+  void record(const char* name, int64_t start_ns, int64_t end_ns);
+  int64_t now_ns();
+  string to_chrome_json();
+  bool write_chrome_json(string path);
+
+  /**
+   * Records the time from its construction to its destruction as an event,
+   * if tracing is enabled. The name must outlive the trace, e.g. a literal.
+   */
+  class trace_scope {
+    public:
+      trace_scope(const char* name) : name(enabled.load(memory_order_relaxed) ? name : nullptr), start(this->name ? now_ns() : 0) {}
+      ~trace_scope() { if (name) record(name, start, now_ns()); }
+    private:
+      const char* name;
+      int64_t start;
+  };
+
+  /**
+   * Enables tracing for its lifetime and writes the trace to a file when it
+   * is destroyed, on SIGUSR1, and on SIGINT or SIGTERM before exiting.
+   */
+  class session {
+    public:
+      session(string path, size_t events_per_thread = 65536);
+      virtual ~session();
+      static unique_ptr<session> from_config();
+    private:
+      void handle_signals();
+
+      string path;
+      atomic<bool> stopping;
+      thread t;
+  };
+}
+
+#endif // TRACING_H
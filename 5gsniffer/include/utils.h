@@ -28,6 +28,7 @@
 #include <fstream>
 #include <iostream>
 #include <chrono>
+#include <string_view>
 #include <spdlog/spdlog.h>
 
 using namespace std;
@@ -60,7 +61,12 @@ inline chrono::system_clock::time_point time_profile_start(void) {
   #endif
 }
 
-inline void time_profile_end(chrono::system_clock::time_point start_time_point, string function_name) {
+/**
+ * Logs the time since start_time_point in debug builds. The name is a
+ * string_view so release builds do not build a string per call, see metrics.h
+ * for the always-on measurements.
+ */
+inline void time_profile_end(chrono::system_clock::time_point start_time_point, string_view function_name) {
   #ifdef DEBUG_BUILD
     auto end_time_point = std::chrono::high_resolution_clock::now();
     chrono::duration<double> time_difference = end_time_point - start_time_point;
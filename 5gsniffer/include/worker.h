@@ -27,7 +27,9 @@
 #include <complex>
 #include <memory>
 #include "symbol.h"
+#include "frame_metadata.h"
 #include "exceptions.h"
+#include "task_pool.h"
 
 using namespace std;
 
@@ -41,27 +43,30 @@ class worker {
 
     worker();
     virtual ~worker();
-    virtual void process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata) { throw sniffer_exception("Tried to call worker::process directly"); };
-    virtual void process(shared_ptr<vector<symbol>>& symbols, int64_t metadata) { throw sniffer_exception("Tried to call worker::process directly"); };
+    virtual void process(shared_ptr<vector<complex<float>>>& samples, const frame_metadata& metadata) { throw sniffer_exception("Tried to call worker::process directly"); };
+    virtual void process(shared_ptr<vector<symbol>>& symbols, const frame_metadata& metadata) { throw sniffer_exception("Tried to call worker::process directly"); };
     virtual shared_ptr<vector<complex<float>>> produce_samples(size_t num_samples);
     virtual shared_ptr<vector<symbol>> produce_symbols(size_t num_symbols);
     virtual void finish();
+    virtual void set_parallel_fanout(shared_ptr<task_pool> pool, size_t queue_depth = 0, bool force_queue = false);
 
-    void work(size_t num_samples);
+    virtual void work(size_t num_samples);
     void connect(shared_ptr<worker> w);
     void disconnect(shared_ptr<worker> w);
     void disconnect_all();
     void disconnect_finished();
     void finish_next_workers();
+    void join_next_workers(size_t max_pending = 0);
     const size_t num_next_workers();
     
     /** 
      * Work function executed by processing workers.
      *
      * @param samples shared_ptr to input buffer to process
+     * @param metadata description of the first sample of the buffer
      */
     template<class T>
-    void work(shared_ptr<vector<T>>& inputs, int64_t metadata = 0) {
+    void work(shared_ptr<vector<T>>& inputs, const frame_metadata& metadata = {}) {
       this->process(inputs, metadata);
     }
   protected:
@@ -72,23 +77,47 @@ class worker {
      */
     template<class T>
     void send_to_next_workers(shared_ptr<vector<T>> inputs) {
-      // Send work to next workers TODO parallelize
-      for (const auto& worker : this->next_workers) {
-        worker->work(inputs, 0);
-      }
+      send_to_next_workers(inputs, frame_metadata{});
     }
+
+    /** 
+     * Helper function to distribute work to the next workers. With parallel
+     * fan-out, every next worker is run as a task on the queue of its edge,
+     * so buffers reach each next worker in order. A lone next worker is run
+     * in place, unless the fan-out was set to always queue.
+     *
+     * @param inputs shared_ptr to input buffer to pass on to the next workers
+     * @param metadata description of the first sample of the buffer
+     */
     template<class T>
-    void send_to_next_workers(shared_ptr<vector<T>> inputs, int64_t metadata) {
-      // Send work to next workers TODO parallelize
-      for (const auto& worker : this->next_workers) {
-        worker->work(inputs,metadata);
+    void send_to_next_workers(shared_ptr<vector<T>> inputs, const frame_metadata& metadata) {
+      if (edge_queues.empty() || (next_workers.size() < 2 && !fanout_force_queue)) {
+        join_next_workers();
+        for (const auto& worker : this->next_workers) {
+          worker->work(inputs, metadata);
+        }
+        return;
+      }
+
+      for (size_t i = 0; i < next_workers.size(); i++) {
+        // Each edge gets its own copy of the shared_ptr, as work may reassign it
+        edge_queues.at(i)->push([next_worker = next_workers.at(i), inputs, metadata]() mutable {
+          next_worker->work(inputs, metadata);
+        });
       }
+      join_next_workers(fanout_queue_depth);
     }
 
+    virtual int64_t get_timestamp_ns(int64_t sample_index);
+
     bool finished;
     int64_t total_produced_samples;
   private:
     vector<shared_ptr<worker>> next_workers;
+    vector<unique_ptr<task_queue>> edge_queues; ///< Queue per next worker, only with parallel fan-out
+    shared_ptr<task_pool> fanout_pool;
+    size_t fanout_queue_depth;
+    bool fanout_force_queue;      ///< Queue even for a lone next worker, so it never runs on the calling thread
 };
 
 #endif
\ No newline at end of file
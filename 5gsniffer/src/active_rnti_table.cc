@@ -0,0 +1,251 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <algorithm>
+#include <limits>
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <spdlog/spdlog.h>
+#include "active_rnti_table.h"
+#include "metrics.h"
+
+/**
+ * Constructor for active_rnti_table.
+ *
+ * @param inactivity_timeout seconds without a DCI after which an RNTI expires
+ * @param rnti_start first RNTI of the RNTI list of the PDCCH
+ * @param rnti_end last RNTI of the RNTI list of the PDCCH
+ */
+active_rnti_table::active_rnti_table(double inactivity_timeout, uint16_t rnti_start, uint16_t rnti_end) :
+  inactivity_timeout(inactivity_timeout),
+  rnti_start(rnti_start),
+  rnti_end(rnti_end),
+  count(0),
+  listed_count(0),
+  next_expiry(numeric_limits<double>::infinity()),
+  write_interval(0),
+  next_write(0),
+  write_requested(false),
+  writer_stopping(false) {
+}
+
+/**
+ * Destructor for active_rnti_table. The writer writes the file a last time
+ * before it stops.
+ */
+active_rnti_table::~active_rnti_table() {
+  if (writer.joinable()) {
+    {
+      lock_guard<mutex> lock(writer_mutex);
+      writer_stopping = true;
+    }
+    writer_wakeup.notify_one();
+    writer.join();
+  }
+  metrics::add_gauge(metrics::active_rntis, -(int64_t)count.load());
+}
+
+/**
+ * Records a DCI found for an RNTI.
+ *
+ * @return true if the RNTI became active with this DCI
+ */
+bool active_rnti_table::update(uint16_t rnti, double time, uint8_t aggregation_level, uint8_t dci_size, uint16_t scrambling_id) {
+  lock_guard<mutex> lock(table_mutex);
+  auto [it, added] = entries.try_emplace(rnti);
+  entry& e = it->second;
+  if (added) {
+    e.rnti = rnti;
+    e.first_seen = time;
+    e.last_seen = time;
+    e.dci_count = 0;
+    e.aggregation_levels = 0;
+    count.fetch_add(1, memory_order_relaxed);
+    if (rnti >= rnti_start && rnti <= rnti_end)
+      listed_count.fetch_add(1, memory_order_relaxed);
+    metrics::add_gauge(metrics::active_rntis, 1);
+  }
+  e.last_seen = std::max(e.last_seen, time);
+  e.dci_count++;
+  if (aggregation_level > 0)
+    e.aggregation_levels |= aggregation_level;
+  e.dci_sizes.insert(dci_size);
+  e.scrambling_id = scrambling_id;
+  next_expiry = std::min(next_expiry, e.last_seen + inactivity_timeout);
+  return added;
+}
+
+/**
+ * Removes the RNTIs without a DCI during the inactivity timeout. Cheap to call
+ * every symbol: the table is only scanned once the oldest entry may expire.
+ *
+ * @return the RNTIs that expired
+ */
+vector<uint16_t> active_rnti_table::expire(double now) {
+  vector<uint16_t> expired;
+  lock_guard<mutex> lock(table_mutex);
+  if (now < next_expiry)
+    return expired;
+
+  next_expiry = numeric_limits<double>::infinity();
+  for (auto it = entries.begin(); it != entries.end();) {
+    double expiry = it->second.last_seen + inactivity_timeout;
+    if (now >= expiry) {
+      expired.push_back(it->first);
+      if (it->first >= rnti_start && it->first <= rnti_end)
+        listed_count.fetch_sub(1, memory_order_relaxed);
+      it = entries.erase(it);
+    } else {
+      next_expiry = std::min(next_expiry, expiry);
+      it++;
+    }
+  }
+  count.fetch_sub(expired.size(), memory_order_relaxed);
+  metrics::add_gauge(metrics::active_rntis, -(int64_t)expired.size());
+  return expired;
+}
+
+bool active_rnti_table::contains(uint16_t rnti) const {
+  lock_guard<mutex> lock(table_mutex);
+  return entries.contains(rnti);
+}
+
+size_t active_rnti_table::size() const {
+  return count.load(memory_order_relaxed);
+}
+
+/**
+ * Number of active RNTIs within the range of the RNTI list, i.e. without the
+ * SI-RNTI or other RNTIs that are decoded but not listed.
+ */
+size_t active_rnti_table::listed_size() const {
+  return listed_count.load(memory_order_relaxed);
+}
+
+/**
+ * Copies the active RNTIs, most recently seen first.
+ */
+vector<active_rnti_table::entry> active_rnti_table::get_snapshot() const {
+  vector<entry> snapshot;
+  {
+    lock_guard<mutex> lock(table_mutex);
+    snapshot.reserve(entries.size());
+    for (auto& [rnti, e] : entries)
+      snapshot.push_back(e);
+  }
+  std::sort(snapshot.begin(), snapshot.end(), [](const entry& a, const entry& b) {
+    return a.last_seen != b.last_seen ? a.last_seen > b.last_seen : a.rnti < b.rnti;
+  });
+  return snapshot;
+}
+
+/**
+ * Formats the active RNTIs as CSV, one RNTI per row, most recently seen
+ * first. ALs and DCI sizes are space-separated lists.
+ */
+string active_rnti_table::to_csv() const {
+  string out = "rnti,first_seen,last_seen,dci_count,aggregation_levels,dci_sizes,scrambling_id\n";
+  for (const entry& e : get_snapshot()) {
+    string aggregation_levels;
+    for (int al = 0; al < 8; al++) {
+      if (e.aggregation_levels & (1 << al))
+        aggregation_levels += (aggregation_levels.empty() ? "" : " ") + to_string(1 << al);
+    }
+    string dci_sizes;
+    for (uint8_t dci_size : e.dci_sizes)
+      dci_sizes += (dci_sizes.empty() ? "" : " ") + to_string(dci_size);
+    out += fmt::format("{},{:.6f},{:.6f},{},{},{},{}\n", e.rnti, e.first_seen, e.last_seen, e.dci_count, aggregation_levels, dci_sizes, e.scrambling_id);
+  }
+  return out;
+}
+
+/**
+ * Writes the CSV snapshot to a temporary file and renames it, so readers never
+ * see a partial file.
+ */
+bool active_rnti_table::write_file(const string& file_path) const {
+  string tmp_path = file_path + ".tmp";
+  {
+    ofstream f(tmp_path, ios::trunc);
+    f << to_csv();
+    if (!f) {
+      SPDLOG_WARN("Could not write active RNTIs to {}", tmp_path);
+      return false;
+    }
+  }
+  if (std::rename(tmp_path.c_str(), file_path.c_str()) != 0) {
+    SPDLOG_WARN("Could not write active RNTIs to {}: {}", file_path, strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Starts the thread that writes the CSV file whenever a write is requested.
+ *
+ * @param file_path file to write the active RNTIs to
+ * @param interval seconds of signal between two writes
+ */
+void active_rnti_table::start_writer(const string& file_path, double interval) {
+  if (writer.joinable())
+    return;
+  writer_file_path = file_path;
+  write_interval = interval;
+  writer = thread(&active_rnti_table::run_writer, this);
+}
+
+/**
+ * Asks the writer for a new CSV file, without waiting for it, once the write
+ * interval passed since the last request. Cheap to call every symbol, from
+ * several threads: only one of them requests each write. Requests made while
+ * a write is in progress are merged into the next write.
+ *
+ * @param now time of the current symbol
+ */
+void active_rnti_table::request_write(double now) {
+  double next = next_write.load(memory_order_relaxed);
+  if (!writer.joinable() || now < next)
+    return;
+  if (!next_write.compare_exchange_strong(next, now + write_interval, memory_order_relaxed))
+    return;
+
+  {
+    lock_guard<mutex> lock(writer_mutex);
+    write_requested = true;
+  }
+  writer_wakeup.notify_one();
+}
+
+void active_rnti_table::run_writer() {
+  unique_lock<mutex> lock(writer_mutex);
+  while (true) {
+    writer_wakeup.wait(lock, [this] { return write_requested || writer_stopping; });
+    bool stopping = writer_stopping;
+    write_requested = false;
+    lock.unlock();
+    write_file(writer_file_path);
+    if (stopping)
+      return;
+    lock.lock();
+  }
+}
@@ -0,0 +1,153 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <sched.h>
+#include <unistd.h>
+#include <spdlog/spdlog.h>
+#include "affinity.h"
+#include "exceptions.h"
+
+/**
+ * Parses a Linux CPU list, e.g. "0-3,8,10-11".
+ *
+ * @param cpu_list comma-separated CPUs and inclusive CPU ranges
+ * @return the CPUs in the order they are listed
+ * @throws config_exception if the list is malformed or a CPU does not fit in a cpu_set_t
+ */
+vector<int> parse_cpu_list(string cpu_list) {
+  vector<int> cpus;
+  stringstream ss(cpu_list);
+  string item;
+  while(getline(ss, item, ',')) {
+    item.erase(0, item.find_first_not_of(" \t\n"));
+    item.erase(item.find_last_not_of(" \t\n") + 1);
+    if(item.empty())
+      continue;
+
+    try {
+      auto parse_cpu = [](string cpu) {
+        size_t parsed = 0;
+        int value = stoi(cpu, &parsed);
+        if(parsed != cpu.size() || value < 0 || value >= CPU_SETSIZE)
+          throw invalid_argument(cpu);
+        return value;
+      };
+      size_t dash = item.find('-');
+      int first = parse_cpu(item.substr(0, dash));
+      int last = dash == string::npos ? first : parse_cpu(item.substr(dash + 1));
+      if(last < first)
+        throw invalid_argument(item);
+      for(int cpu = first; cpu <= last; cpu++)
+        cpus.push_back(cpu);
+    } catch(logic_error& e) {
+      throw config_exception("Invalid CPU list: " + cpu_list);
+    }
+  }
+  return cpus;
+}
+
+/**
+ * Checks that a CPU is online, from sysfs, or else that it is one of the
+ * configured CPUs.
+ *
+ * @param cpu index of the CPU
+ * @return true if threads can be pinned to the CPU
+ */
+bool is_cpu_online(int cpu) {
+  if(cpu < 0 || cpu >= CPU_SETSIZE)
+    return false;
+
+  ifstream f("/sys/devices/system/cpu/online");
+  string cpu_list;
+  if(!f || !getline(f, cpu_list))
+    return cpu < sysconf(_SC_NPROCESSORS_CONF);
+  vector<int> online = parse_cpu_list(cpu_list);
+  return find(online.begin(), online.end(), cpu) != online.end();
+}
+
+/**
+ * Gets the CPUs of a NUMA node from sysfs.
+ *
+ * @param numa_node index of the NUMA node
+ * @return the CPUs of the node, empty if the node does not exist
+ */
+vector<int> get_numa_node_cpus(int numa_node) {
+  ifstream f("/sys/devices/system/node/node" + to_string(numa_node) + "/cpulist");
+  string cpu_list;
+  if(!f || !getline(f, cpu_list)) {
+    SPDLOG_WARN("Could not read the CPUs of NUMA node {}", numa_node);
+    return {};
+  }
+  return parse_cpu_list(cpu_list);
+}
+
+/**
+ * Restricts a thread to a set of CPUs.
+ *
+ * @param thread thread to pin
+ * @param cpus CPUs the thread may run on
+ * @return true if the affinity was set
+ */
+bool set_thread_affinity(pthread_t thread, span<const int> cpus) {
+  if(cpus.empty())
+    return false;
+
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for(int cpu : cpus) {
+    if(cpu < 0 || cpu >= CPU_SETSIZE) {
+      SPDLOG_WARN("Could not set thread affinity: CPU {} is out of range", cpu);
+      return false;
+    }
+    CPU_SET(cpu, &cpu_set);
+  }
+
+  int result = pthread_setaffinity_np(thread, sizeof(cpu_set), &cpu_set);
+  if(result != 0) {
+    SPDLOG_WARN("Could not set thread affinity: {}", strerror(result));
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Schedules a thread with SCHED_FIFO at the given priority. Usually requires
+ * CAP_SYS_NICE or a suitable RLIMIT_RTPRIO.
+ *
+ * @param thread thread to schedule
+ * @param priority SCHED_FIFO priority, from 1 to 99
+ * @return true if the scheduling policy was set
+ */
+bool set_thread_realtime(pthread_t thread, int priority) {
+  sched_param param = {};
+  param.sched_priority = priority;
+  int result = pthread_setschedparam(thread, SCHED_FIFO, &param);
+  if(result != 0) {
+    SPDLOG_WARN("Could not set SCHED_FIFO priority {}: {}", priority, strerror(result));
+    return false;
+  }
+  return true;
+}
@@ -24,6 +24,7 @@
 #include <iostream>
 #include <unistd.h>
 #include <cstdio>
+#include <cstdlib>
 
 using namespace std;
 
@@ -34,38 +35,48 @@ void args_manager::default_args(args_t& args) {
   args.rf_dev = "";
   args.rf_freq = -1.0;
   args.rf_gain = -1.0;
+  args.sample_rate = 23040000;
+  args.ssb_numerology = 0;
 }
 
 void args_manager::usage(args_t& args, const std::string& prog) {
-  printf("Usage: %s [afgil] -f rx_frequency (in Hz) | -i input_file\n", prog.c_str());
+  printf("Usage: %s [hlns] -f center_frequency (in Hz) -i input_file\n", prog.c_str());
   printf("\t-h show this help message\n");
-  printf("\t-a RF args [Default %s]\n", args.rf_args.c_str());
-  printf("\t-f Set RX freq [Default %.1f Hz]\n", args.rf_freq);
-  printf("\t-g Set RX gain [Default %.1f dB]\n", args.rf_gain);
-  printf("\t-d RF devicename [Default %s]\n", args.rf_dev.c_str());
-  printf("\t-i input_file [Default use RF board]\n");
-  printf("\t-l Force N_id_2 [Default find best]\n");
+  printf("\t-f Center frequency of the recording\n");
+  printf("\t-i Input file, a wideband recording of complex float samples\n");
+  printf("\t-s Sample rate of the recording [Default %lu Hz]\n", args.sample_rate);
+  printf("\t-n SSB numerology [Default %u]\n", args.ssb_numerology);
+  printf("\t-l Force N_id_2 [Default find all]\n");
 }
 
 void args_manager::parse_args(args_t& args, int argc, char **argv) {
   int opt;
   default_args(args);
-  while ((opt = getopt(argc, argv, "afgil")) != -1) {
+  while ((opt = getopt(argc, argv, "a:d:f:g:hi:l:n:s:")) != -1) {
     switch (opt) {
       case 'a':
-        args.rf_args = argv[optind];
+        args.rf_args = optarg;
+        break;
+      case 'd':
+        args.rf_dev = optarg;
         break;
       case 'i':
-        args.input_file_name = argv[optind];
+        args.input_file_name = optarg;
         break;
       case 'l':
-        args.force_N_id_2 = atoi(argv[optind]);
+        args.force_N_id_2 = atoi(optarg);
         break;
       case 'f':
-        args.rf_freq = strtod(argv[optind], nullptr);
+        args.rf_freq = strtod(optarg, nullptr);
         break;
       case 'g':
-        args.rf_gain = strtod(argv[optind], nullptr);
+        args.rf_gain = strtod(optarg, nullptr);
+        break;
+      case 'n':
+        args.ssb_numerology = atoi(optarg);
+        break;
+      case 's':
+        args.sample_rate = strtoull(optarg, nullptr, 10);
         break;
       case 'h':
       default:
@@ -74,7 +85,7 @@ void args_manager::parse_args(args_t& args, int argc, char **argv) {
     }
   }
 
-  if (args.rf_freq < 0 && args.input_file_name == "") {
+  if (args.rf_freq < 0 || args.input_file_name == "") {
     usage(args, argv[0]);
     exit(-1);
   }
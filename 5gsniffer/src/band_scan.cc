@@ -0,0 +1,185 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include "band_scan.h"
+#include "bandwidth_part.h"
+#include "phy_params_common.h"
+#include "gscn.h"
+#include "dsp.h"
+#include "exceptions.h"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <latch>
+#include <thread>
+
+using namespace std;
+
+/**
+ * Constructor for band_scan. Sets up the channelizer and a syncer for every
+ * raster position whose SSB fits within the capture.
+ *
+ * @param sample_rate sample rate of the capture
+ * @param center_frequency center frequency of the capture in Hz
+ * @param ssb_numerology numerology of the SSBs to look for
+ * @param nid2 only look for this PSS index
+ * @param pool pool processing the raster positions, a pool of its own is started if null
+ */
+band_scan::band_scan(uint64_t sample_rate, double center_frequency, uint16_t ssb_numerology, optional<uint8_t> nid2, shared_ptr<task_pool> pool) :
+  sample_rate(sample_rate),
+  center_frequency(center_frequency),
+  pool(pool),
+  channel_sample_index(0) {
+  uint32_t scs = subcarrier_spacing_15khz << ssb_numerology;
+  ssb_half_bandwidth = ssb_sc / 2.0 * scs;
+
+  // Any raster position is within half a channel spacing of a channel center, so
+  // the spacing is chosen for the whole SSB to be in the channel passband
+  uint32_t num_channels = channelizer::get_num_channels(sample_rate, ssb_half_bandwidth);
+  channelizer = make_unique<class channelizer>(num_channels, num_channels / 4);
+  channel_sample_rate = std::llround((double)sample_rate / channelizer->decimation);
+
+  // Leave a guard band at the edges of the capture, which are filtered by the SDR
+  double max_offset = 0.45 * sample_rate - ssb_half_bandwidth;
+  if(max_offset <= 0)
+    throw sniffer_exception("Sample rate too low to capture a whole SSB");
+
+  // Raster positions only need PHY-layer state up to the MIB, so they share a pool without flows
+  flow_pool = make_shared<nr::flow_pool>(0);
+  for(uint32_t gscn : gscns_in_range(center_frequency - max_offset, center_frequency + max_offset)) {
+    auto position = make_unique<raster_position>();
+    position->gscn = gscn;
+    position->frequency = gscn_to_frequency(gscn);
+    double relative_frequency = position->frequency - center_frequency;
+    position->channel = channelizer->nearest_channel(relative_frequency, sample_rate);
+    position->offset = relative_frequency - channelizer->channel_frequency(position->channel, sample_rate);
+    position->phase = 1.0f;
+    position->phy = make_shared<nr::phy>();
+    position->phy->ssb_bwp = make_unique<bandwidth_part>(3'840'000 * (1<<ssb_numerology), ssb_numerology, ssb_rb);
+    position->syncer = make_shared<class syncer>(channel_sample_rate, position->phy, flow_pool, nid2);
+    position->syncer->on_cell_found = std::bind(&band_scan::on_cell_found, this, std::ref(*position), std::placeholders::_1, std::placeholders::_2);
+    position->found = false;
+    positions.push_back(std::move(position));
+  }
+
+  // The calling thread processes a share of the raster positions, the pool the others
+  if(!this->pool && positions.size() > 1)
+    this->pool = make_shared<task_pool>(std::min<size_t>(positions.size() - 1, std::max(1u, thread::hardware_concurrency())));
+
+  SPDLOG_INFO("Scanning {} GSCN raster positions with {} channels of {} MHz", positions.size(), num_channels, channel_sample_rate / 1e6);
+}
+
+/**
+ * Channelizes the samples and passes them to the syncer of every raster
+ * position where no cell was found yet.
+ *
+ * @param samples shared_ptr to sample buffer to process
+ */
+void band_scan::process(shared_ptr<vector<complex<float>>>& samples, const frame_metadata& metadata) {
+  channelizer->execute(*samples, channels);
+
+  frame_metadata channel_metadata = metadata;
+  channel_metadata.sample_index = channel_sample_index;
+  channel_sample_index += channels.at(0).size();
+
+  // Each thread handles an interleaved subset of the raster positions
+  size_t num_threads = pool ? pool->size() + 1 : 1;
+  exception_ptr error;
+  mutex error_mutex;
+  auto process_subset = [&](size_t t) {
+    try {
+      for(size_t i = t; i < positions.size(); i += num_threads) {
+        process_position(*positions.at(i), channel_metadata);
+      }
+    } catch(...) {
+      lock_guard<mutex> lock(error_mutex);
+      if(!error)
+        error = current_exception();
+    }
+  };
+
+  latch done(num_threads - 1);
+  for(size_t t = 1; t < num_threads; t++) {
+    pool->submit([&process_subset, &done, t] {
+      process_subset(t);
+      done.count_down();
+    });
+  }
+  process_subset(0);
+  done.wait();
+  if(error)
+    rethrow_exception(error);
+}
+
+/**
+ * Shifts the channel of a raster position so the raster position is at
+ * baseband, and passes it to its syncer.
+ *
+ * @param position raster position to process
+ * @param metadata metadata of the channelized samples
+ */
+void band_scan::process_position(raster_position& position, const frame_metadata& metadata) {
+  if(position.found)
+    return;
+
+  auto& channel = channels.at(position.channel);
+  auto samples = make_shared<vector<complex<float>>>(channel.size());
+  rotate(*samples, channel, -position.offset, channel_sample_rate, position.phase);
+  position.syncer->process(samples, metadata);
+}
+
+/**
+ * Records the cell a syncer found. The raster position is not processed anymore.
+ */
+void band_scan::on_cell_found(raster_position& position, srsran_mib_nr_t& mib, float cfo) {
+  position.found = true;
+  uint16_t cell_id = position.phy->get_cell_id();
+  SPDLOG_INFO("Found cell {} at GSCN {} ({:.2f} MHz), CFO {:.1f} Hz", cell_id, position.gscn, position.frequency / 1e6, cfo);
+
+  std::lock_guard<std::mutex> lock(cells_mutex);
+  cells.push_back({position.gscn, position.frequency, cell_id, cfo, mib});
+}
+
+/**
+ * Returns the cells found so far, sorted by frequency. A cell found on
+ * several nearby raster positions is only returned for the one with the
+ * smallest frequency offset.
+ */
+vector<cell_info> band_scan::get_cells() {
+  std::lock_guard<std::mutex> lock(cells_mutex);
+  vector<cell_info> sorted = cells;
+  std::sort(sorted.begin(), sorted.end(), [](const cell_info& a, const cell_info& b) {
+    return a.cell_id != b.cell_id ? a.cell_id < b.cell_id : std::abs(a.cfo) < std::abs(b.cfo);
+  });
+
+  vector<cell_info> result;
+  for(auto& cell : sorted) {
+    bool duplicate = std::any_of(result.begin(), result.end(), [&](const cell_info& other) {
+      return other.cell_id == cell.cell_id && std::abs(other.frequency - cell.frequency) < ssb_half_bandwidth;
+    });
+    if(!duplicate)
+      result.push_back(cell);
+  }
+
+  std::sort(result.begin(), result.end(), [](const cell_info& a, const cell_info& b) {
+    return a.frequency < b.frequency;
+  });
+  return result;
+}
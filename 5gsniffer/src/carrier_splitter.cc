@@ -0,0 +1,127 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include "carrier_splitter.h"
+#include "phy_params_common.h"
+#include "dsp.h"
+#include "exceptions.h"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+
+using namespace std;
+
+/**
+ * Constructor for carrier_splitter. Chooses the channel spacing for the
+ * widest carrier to fit the channel passband.
+ *
+ * @param sample_rate sample rate of the input
+ * @param center_frequency center frequency of the input in Hz
+ * @param carriers carriers to split the input into
+ */
+carrier_splitter::carrier_splitter(uint64_t sample_rate, double center_frequency, const vector<carrier_config>& carriers) :
+  carrier_sample_index(0),
+  fanout_queue_depth(0) {
+  double max_bandwidth = 0;
+  for(auto& carrier : carriers)
+    max_bandwidth = std::max(max_bandwidth, carrier.bandwidth);
+
+  // The carrier sample rate must be a whole number of subcarriers, so the OFDM blocks can demodulate it
+  uint32_t num_channels = channelizer::get_num_channels(sample_rate, max_bandwidth / 2, subcarrier_spacing_15khz);
+  channelizer = make_unique<class channelizer>(num_channels, num_channels / 4);
+  carrier_sample_rate = sample_rate / channelizer->decimation;
+  if(sample_rate % channelizer->decimation != 0 || carrier_sample_rate % subcarrier_spacing_15khz != 0)
+    throw config_exception("Sample rate cannot be split into carriers at a multiple of 15 kHz");
+
+  for(auto& carrier : carriers) {
+    double relative_frequency = carrier.frequency - center_frequency;
+    if(std::abs(relative_frequency) + carrier.bandwidth / 2 > sample_rate / 2.0)
+      throw config_exception("Carrier is outside of the sampled band");
+
+    carrier_stream stream;
+    stream.channel = channelizer->nearest_channel(relative_frequency, sample_rate);
+    stream.offset = relative_frequency - channelizer->channel_frequency(stream.channel, sample_rate);
+    stream.phase = 1.0f;
+    SPDLOG_INFO("Carrier at {:.3f} MHz is decoded from channel {} at {} MHz", carrier.frequency / 1e6, stream.channel, carrier_sample_rate / 1e6);
+    this->carriers.push_back(std::move(stream));
+  }
+}
+
+/**
+ * Connects a worker to the output of a carrier.
+ *
+ * @param carrier index of the carrier
+ * @param next_worker worker to pass the samples of the carrier to
+ */
+void carrier_splitter::connect_carrier(size_t carrier, shared_ptr<worker> next_worker) {
+  carriers.at(carrier).next_workers.push_back(next_worker);
+}
+
+/**
+ * Processes the carriers in parallel, each on its own queue of the pool. The
+ * next workers of a single carrier still run in turn.
+ *
+ * @param pool pool to run the carriers on, or nullptr to run them in turn
+ * @param queue_depth number of buffers a carrier may still have pending when
+ * process returns, 0 to wait until all carriers are done
+ * @param force_queue ignored, every carrier is queued, even a lone one
+ */
+void carrier_splitter::set_parallel_fanout(shared_ptr<task_pool> pool, size_t queue_depth, bool force_queue) {
+  fanout_queue_depth = queue_depth;
+  for(auto& carrier : carriers) {
+    carrier.queue = pool ? make_unique<task_queue>(pool) : nullptr;
+  }
+}
+
+/**
+ * Channelizes the samples and passes each carrier to its next workers.
+ *
+ * @param samples shared_ptr to sample buffer to process
+ */
+void carrier_splitter::process(shared_ptr<vector<complex<float>>>& samples, const frame_metadata& metadata) {
+  channelizer->execute(*samples, channels);
+
+  // Sample indices of a carrier are at the carrier sample rate
+  frame_metadata carrier_metadata = metadata;
+  carrier_metadata.sample_index = carrier_sample_index;
+  carrier_sample_index += channels.at(0).size();
+
+  // Carriers are shifted here, as the channels are overwritten by the next buffer
+  for(auto& carrier : carriers) {
+    auto& channel = channels.at(carrier.channel);
+    auto carrier_samples = make_shared<vector<complex<float>>>(channel.size());
+    rotate(*carrier_samples, channel, -carrier.offset, carrier_sample_rate, carrier.phase);
+    auto process_carrier = [&next_workers = carrier.next_workers, carrier_samples, carrier_metadata]() mutable {
+      for(auto& next_worker : next_workers) {
+        next_worker->process(carrier_samples, carrier_metadata);
+      }
+    };
+
+    if(carrier.queue)
+      carrier.queue->push(process_carrier);
+    else
+      process_carrier();
+  }
+
+  for(auto& carrier : carriers) {
+    if(carrier.queue)
+      carrier.queue->wait(fanout_queue_depth);
+  }
+}
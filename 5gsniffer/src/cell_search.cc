@@ -19,48 +19,67 @@
  *
  */
 
-// #include <iostream>
-// #include <cstdlib>
-// #include <unistd.h>
-// #include "args_manager.h"
+#include <iostream>
+#include <cstdlib>
+#include <cstdio>
 
-// // #ifdef __cplusplus
-// // extern "C" {
-// // #undef I // Fix complex.h #define I nastiness when using C++
-// #include "srsran/srsran.h"
-// #include "srsran/phy/rf/rf_utils.h"
-// #include "srsran/phy/rf/rf.h"
-// // }
+#include "spdlog/spdlog.h"
+#include "spdlog/cfg/env.h"
+#include "args_manager.h"
+#include "file_source.h"
+#include "band_scan.h"
+#include "exceptions.h"
+#include "config.h"
+#include <srsran/srsran.h>
 
-// using namespace std;
+using namespace std;
+extern struct config config;
 
-// char rf_dev[]  = "";
-// char rf_args[]  = "";
+/** 
+ * Scans a wideband recording for cells on every GSCN synchronization raster
+ * position, and prints the cells found.
+ *
+ * @param argc 
+ * @param argv 
+ */
+int main(int argc, char** argv) {
+  args_t args;
+  args_manager::parse_args(args, argc, argv);
 
-// int main(int argc, char** argv) {
+  spdlog::cfg::load_env_levels();
+  spdlog::set_pattern("[%^%l%$] [%H:%M:%S.%f thread %t] [%s:%#] %v");
 
-//   args_t args;
-//   args_manager::parse_args(args, argc, argv);
+  // Look for all PSS indexes unless one is forced
+  config.nid_2 = 4;
+  optional<uint8_t> nid2;
+  if(args.force_N_id_2 >= 0)
+    nid2 = args.force_N_id_2;
 
-//   int                           n;
-//   srsran_rf_t                   rf;
-//   srsran_ue_cellsearch_t        cs;
-//   srsran_ue_cellsearch_result_t found_cells[3];
-//   int                           nof_freqs;
-//   // srsran_earfcn_t               channels[MAX_EARFCN];
-//   uint32_t                      freq;
-//   uint32_t                      n_found_cells = 0;
+  vector<cell_info> cells;
+  try {
+    file_source source(args.sample_rate, args.input_file_name);
+    auto scan = make_shared<band_scan>(args.sample_rate, args.rf_freq, args.ssb_numerology, nid2);
+    source.connect(scan);
 
-//   printf("Opening RF device...\n");
+    bool running = true;
+    source.on_end = [&running]() { running = false; };
+    uint32_t num_samples_per_chunk = static_cast<uint32_t>(args.sample_rate * 0.0080);
+    while(running) {
+      source.work(num_samples_per_chunk);
+    }
 
-//   if (srsran_rf_open_devname(&rf, rf_dev, rf_args, 1)) {
-//     // ERROR("Error opening rf");
-//     cout << "error opening rf" << endl;
-//     exit(-1);
-//   }
-//   cout << "opened" << endl;
+    cells = scan->get_cells();
+  } catch (sniffer_exception& e) {
+    SPDLOG_ERROR(e.what());
+    return 1;
+  }
 
-//   // DEBUG(" ----  Receive %d samples  ---- ", nsamples);
-//   // return srsran_rf_recv_with_time((srsran_rf_t*)h, data, nsamples, 1, NULL, NULL);
-//   srsran_rf_close(&rf);
-// }
+  printf("Found %zu cells\n", cells.size());
+  printf("%6s %16s %5s %10s  %s\n", "GSCN", "Frequency (MHz)", "PCI", "CFO (Hz)", "MIB");
+  for(auto& cell : cells) {
+    char mib_str[512] = {};
+    srsran_pbch_msg_nr_mib_info(&cell.mib, mib_str, sizeof(mib_str));
+    printf("%6u %16.2f %5u %10.1f  %s\n", cell.gscn, cell.frequency / 1e6, cell.cell_id, cell.cfo, mib_str);
+  }
+  return 0;
+}
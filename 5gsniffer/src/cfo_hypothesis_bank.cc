@@ -0,0 +1,191 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <algorithm>
+#include <latch>
+#include <spdlog/spdlog.h>
+#include "cfo_hypothesis_bank.h"
+#include "exceptions.h"
+#include "pss.h"
+
+/**
+ * Constructor for cfo_hypothesis_bank.
+ *
+ * @param subcarrier_offsets CFO hypotheses, in subcarriers of the SSB
+ * @param num_samples number of samples to prepare the FFTs for, they are resized on demand
+ * @param pool pool evaluating the hypotheses, a pool of its own is started if null
+ * @param times_avg_threshold number of times a PSS correlation must be higher than the average correlation
+ */
+cfo_hypothesis_bank::cfo_hypothesis_bank(vector<int32_t> subcarrier_offsets, size_t num_samples, shared_ptr<task_pool> pool, float times_avg_threshold) :
+  subcarrier_offsets(subcarrier_offsets),
+  pool(pool),
+  times_avg_threshold(times_avg_threshold),
+  fft_size(0),
+  forward(nullptr) {
+  if(subcarrier_offsets.empty())
+    throw sniffer_exception("CFO hypothesis bank needs at least one hypothesis");
+  for(auto offset : subcarrier_offsets) {
+    if(abs(offset) >= ssb_nfft / 4)
+      throw sniffer_exception("CFO hypotheses must be smaller than a quarter of the SSB FFT size");
+  }
+  results.resize(subcarrier_offsets.size());
+  resize(num_samples);
+
+  // The calling thread evaluates the first hypothesis, the pool the others
+  if(!this->pool && subcarrier_offsets.size() > 1)
+    this->pool = make_shared<task_pool>(std::min<size_t>(subcarrier_offsets.size() - 1, std::max(1u, thread::hardware_concurrency())));
+}
+
+/**
+ * Destructor for cfo_hypothesis_bank.
+ */
+cfo_hypothesis_bank::~cfo_hypothesis_bank() {
+  destroy_plans();
+}
+
+void cfo_hypothesis_bank::destroy_plans() {
+  if(forward)
+    fft_destroy_plan(forward);
+  for(auto plan : backward)
+    fft_destroy_plan(plan);
+  forward = nullptr;
+  backward.clear();
+}
+
+/**
+ * Prepares the FFTs for at least num_samples input samples. The FFT size is
+ * a multiple of the SSB FFT size, so that a subcarrier is a whole number of
+ * bins. FFT plans are created here, outside of the worker threads.
+ *
+ * @param num_samples number of input samples
+ */
+void cfo_hypothesis_bank::resize(size_t num_samples) {
+  size_t required = ((num_samples + ssb_nfft + ssb_nfft - 1) / ssb_nfft) * ssb_nfft;
+  if(required <= fft_size)
+    return;
+
+  destroy_plans();
+  fft_size = required;
+  SPDLOG_DEBUG("Preparing CFO hypothesis bank with FFT size {}", fft_size);
+
+  input.assign(fft_size, 0);
+  input_fft.assign(fft_size, 0);
+  forward = fft_create_plan(fft_size, input.data(), input_fft.data(), LIQUID_FFT_FORWARD, 0);
+
+  pss generator;
+  for(int i = 0; i <= nid_2_max; i++) {
+    auto pss_seq_t = generator.convert_pss_t(generator.generate_pss_seq(i));
+    copy(pss_seq_t.begin(), pss_seq_t.end(), input.begin());
+    fill(input.begin() + ssb_nfft, input.end(), 0);
+    fft_execute(forward);
+    pss_fft[i].resize(fft_size);
+    for(size_t b = 0; b < fft_size; b++)
+      pss_fft[i][b] = conj(input_fft[b]);
+  }
+
+  products.assign(subcarrier_offsets.size(), vector<complex<float>>(fft_size));
+  correlations.assign(subcarrier_offsets.size(), vector<complex<float>>(fft_size));
+  for(size_t h = 0; h < subcarrier_offsets.size(); h++)
+    backward.push_back(fft_create_plan(fft_size, products[h].data(), correlations[h].data(), LIQUID_FFT_BACKWARD, 0));
+}
+
+/**
+ * Finds the strongest PSS correlation over all hypotheses, among the
+ * correlations that are times_avg_threshold times higher than the average
+ * correlation of their hypothesis and PSS.
+ *
+ * @param samples samples at the SSB sample rate
+ * @param nid_2_start first PSS index to look for
+ * @param nid_2_end last PSS index to look for
+ * @param best set to the best hypothesis and the PSS found under it
+ * @return false if no correlation is over the threshold, or the input is shorter than the PSS
+ */
+bool cfo_hypothesis_bank::search(span<const complex<float>> samples, uint8_t nid_2_start, uint8_t nid_2_end, result& best) {
+  if(samples.size() < ssb_nfft)
+    return false;
+
+  resize(samples.size());
+  copy(samples.begin(), samples.end(), input.begin());
+  fill(input.begin() + samples.size(), input.end(), 0);
+  fft_execute(forward);
+
+  // Correlations at lags beyond this would wrap around
+  size_t num_lags = samples.size() - ssb_nfft + 1;
+
+  latch done(subcarrier_offsets.size() - 1);
+  for(size_t h = 1; h < subcarrier_offsets.size(); h++) {
+    pool->submit([this, h, num_lags, nid_2_start, nid_2_end, &done] {
+      evaluate(h, num_lags, nid_2_start, nid_2_end);
+      done.count_down();
+    });
+  }
+  evaluate(0, num_lags, nid_2_start, nid_2_end);
+  done.wait();
+
+  best = *max_element(results.begin(), results.end(), [](const result& a, const result& b) {
+    return a.found != b.found ? b.found : a.correlation < b.correlation;
+  });
+  if(!best.found)
+    return false;
+  SPDLOG_DEBUG("Best CFO hypothesis {} subcarriers: PSS {} at {} with correlation {}", best.subcarrier_offset, best.nid_2, best.position, best.correlation);
+  return true;
+}
+
+/**
+ * Correlates the input, shifted down by the subcarrier offset of a
+ * hypothesis, with the PSS by multiplying the spectra, and keeps the highest
+ * peak over the threshold.
+ */
+void cfo_hypothesis_bank::evaluate(size_t hypothesis, size_t num_lags, uint8_t nid_2_start, uint8_t nid_2_end) {
+  auto& product = products[hypothesis];
+  auto& correlation = correlations[hypothesis];
+  result& r = results[hypothesis];
+  r = {subcarrier_offsets[hypothesis], 0, 0.0f, nid_2_start, false};
+
+  size_t bins_per_subcarrier = fft_size / ssb_nfft;
+  size_t shift = (fft_size + subcarrier_offsets[hypothesis] * (int64_t)bins_per_subcarrier) % fft_size;
+  for(uint8_t nid_2 = nid_2_start; nid_2 <= nid_2_end; nid_2++) {
+    const auto& pss = pss_fft[nid_2];
+    for(size_t b = 0; b < fft_size; b++)
+      product[b] = input_fft[(b + shift) % fft_size] * pss[b];
+    fft_execute(backward[hypothesis]);
+
+    float peak = 0.0f;
+    size_t peak_position = 0;
+    float sum = 0.0f;
+    for(size_t n = 0; n < num_lags; n++) {
+      float magnitude = abs(correlation[n]) / fft_size;
+      sum += magnitude;
+      if(magnitude > peak) {
+        peak = magnitude;
+        peak_position = n;
+      }
+    }
+
+    float threshold = times_avg_threshold * sum / num_lags;
+    if(peak > threshold && peak > r.correlation) {
+      r.correlation = peak;
+      r.position = peak_position;
+      r.nid_2 = nid_2;
+      r.found = true;
+    }
+  }
+}
@@ -27,6 +27,8 @@
 #include "dsp.h"
 #include "utils.h"
 #include "phy.h"
+#include "grid_sink.h"
+#include "tracing.h"
 
 using namespace std;
 
@@ -50,6 +52,7 @@ channel_mapper::channel_mapper(shared_ptr<nr::phy> phy, pdcch_config pdcch_confi
   pdcch.sc_power_decision = pdcch_config.sc_power_decision;
   pdcch.sample_rate_time = pdcch_config.sample_rate_time;
   pdcch.rnti_list_length = pdcch_config.rnti_list_length;
+  pdcch.learned_rntis_only = pdcch_config.learned_rntis_only;
   std::vector<uint8_t> num_candidates_per_AL = pdcch_config.num_candidates_per_AL;  
 
   coreset coreset_info_(pdcch_config.coreset_id,
@@ -66,9 +69,37 @@ channel_mapper::channel_mapper(shared_ptr<nr::phy> phy, pdcch_config pdcch_confi
                         pdcch_config.num_candidates_per_AL);
   pdcch.set_coreset_info(coreset_info_);
 
+  if(pdcch_config.slot_budget_us > 0) {
+    pdcch.scheduler = make_shared<deadline_scheduler>(chrono::duration_cast<chrono::nanoseconds>(chrono::duration<double, micro>(pdcch_config.slot_budget_us)),
+                                                      pdcch_config.shed_order,
+                                                      pdcch_config.hot_rnti_count,
+                                                      pdcch_config.shed_recovery_slots);
+  }
+
+  if(pdcch_config.rnti_inactivity_timeout > 0) {
+    pdcch.active_rntis = make_shared<active_rnti_table>(pdcch_config.rnti_inactivity_timeout, pdcch_config.rnti_start, pdcch_config.rnti_end);
+    if(!pdcch_config.active_rnti_file.empty())
+      pdcch.active_rntis->start_writer(pdcch_config.active_rnti_file, pdcch_config.active_rnti_interval);
+  }
+
   // Initialize RNTI list and DMRS sequences
   pdcch.initialize_RNTI_list();
   pdcch.initialize_dmrs_seq();
+
+  // Optionally record the demodulated CORESET grid, so the PDCCH can be re-run with other parameters
+  if(!pdcch_config.grid_recording_path.empty()) {
+    grid_file_header header = {};
+    header.flags = (pdcch_config.grid_recording_half_precision ? grid_flag_half_precision : 0) |
+                   (pdcch_config.extended_prefix ? grid_flag_extended_prefix : 0);
+    header.sample_rate = pdcch_config.sample_rate_time;
+    header.cell_id = phy->get_cell_id();
+    header.coreset_id = pdcch_config.coreset_id;
+    header.numerology = pdcch_config.numerology;
+    header.num_prbs = pdcch_config.num_prbs;
+    header.coreset_duration = pdcch_config.coreset_duration;
+    header.coreset_ofdm_symbol_start = pdcch_config.coreset_ofdm_symbol_start;
+    this->connect(make_shared<grid_sink>(pdcch_config.grid_recording_path, header));
+  }
 }
 
 /** 
@@ -78,7 +109,8 @@ channel_mapper::~channel_mapper() {
 
 }
 
-void channel_mapper::process(shared_ptr<vector<symbol>>& symbols, int64_t metadata) {
+void channel_mapper::process(shared_ptr<vector<symbol>>& symbols, const frame_metadata& metadata) {
+  tracing::trace_scope trace("channel_mapper::process");
   SPDLOG_DEBUG("Got {} symbols", symbols->size());
 
   // Get symbols that belong to PDCCH according to search space set and CORESET config, e.g. duration.
@@ -101,5 +133,9 @@ void channel_mapper::process(shared_ptr<vector<symbol>>& symbols, int64_t metada
     }
   }
 
+  // Pass the CORESET symbols to the grid recorder, if any
+  if(to_process->size() > 0)
+    send_to_next_workers(to_process, metadata);
+
   pdcch.process(to_process, metadata);
 }
\ No newline at end of file
@@ -0,0 +1,162 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include "channelizer.h"
+#include "exceptions.h"
+#include "spdlog/spdlog.h"
+#include <numbers>
+#include <numeric>
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+/**
+ * Constructor for channelizer. Designs the Kaiser prototype filter, with its
+ * cutoff at three quarters of the output Nyquist frequency.
+ *
+ * @param num_channels number of channels, which splits the input band evenly
+ * @param decimation decimation of each channel, at most num_channels
+ * @param taps_per_channel length of the prototype filter, per channel
+ * @param stopband_attenuation stopband attenuation of the prototype filter in dB
+ */
+channelizer::channelizer(uint32_t num_channels, uint32_t decimation, uint32_t taps_per_channel, float stopband_attenuation) :
+  num_channels(num_channels),
+  decimation(decimation),
+  output_phase(0),
+  fft_input(num_channels),
+  fft_output(num_channels) {
+  if(num_channels == 0 || decimation == 0 || decimation > num_channels)
+    throw sniffer_exception("Channelizer decimation must be between 1 and the number of channels");
+
+  // Prototype filter with unit gain at DC
+  prototype.resize(num_channels * taps_per_channel);
+  liquid_firdes_kaiser(prototype.size(), 0.375f / decimation, stopband_attenuation, 0.0f, prototype.data());
+  float gain = std::accumulate(prototype.begin(), prototype.end(), 0.0f);
+  for(auto& tap : prototype)
+    tap /= gain;
+
+  // Start with the filter filled with zeros
+  history.assign(prototype.size() - 1, 0);
+  next_output_position = prototype.size() - 1;
+
+  // The FFT phases are relative to the newest input sample, which advances by decimation samples per output
+  twiddles.resize(num_channels);
+  for(uint32_t i = 0; i < num_channels; i++)
+    twiddles[i] = std::polar(1.0f, (float)(-2 * std::numbers::pi * i / num_channels));
+
+  fft = fft_create_plan(num_channels, fft_input.data(), fft_output.data(), LIQUID_FFT_BACKWARD, 0);
+  SPDLOG_DEBUG("Created channelizer with {} channels, decimation {} and {} taps", num_channels, decimation, prototype.size());
+}
+
+/**
+ * Destructor for channelizer.
+ */
+channelizer::~channelizer() {
+  fft_destroy_plan(fft);
+}
+
+/**
+ * Channelizes the input. Consecutive calls process the input as a single
+ * stream, so the outputs of consecutive calls can be concatenated.
+ *
+ * @param input samples to channelize
+ * @param outputs set to the new samples of each channel
+ */
+void channelizer::execute(span<complex<float>> input, vector<vector<complex<float>>>& outputs) {
+  history.insert(history.end(), input.begin(), input.end());
+  outputs.resize(num_channels);
+  for(auto& output : outputs) {
+    output.clear();
+    output.reserve(input.size() / decimation + 1);
+  }
+
+  size_t num_taps = prototype.size();
+  while(next_output_position < history.size()) {
+    // Fold the filtered window into num_channels polyphase branches
+    const complex<float>* newest = history.data() + next_output_position;
+    for(uint32_t r = 0; r < num_channels; r++) {
+      complex<float> acc = 0;
+      for(size_t tap = r; tap < num_taps; tap += num_channels) {
+        acc += prototype[tap] * *(newest - tap);
+      }
+      fft_input[r] = acc;
+    }
+    fft_execute(fft);
+
+    // Channel k needs a phase correction of exp(-j*2*pi*k*n*decimation/num_channels)
+    uint32_t phase_step = (output_phase * decimation) % num_channels;
+    for(uint32_t k = 0; k < num_channels; k++) {
+      outputs[k].push_back(fft_output[k] * twiddles[(k * phase_step) % num_channels]);
+    }
+
+    output_phase = (output_phase + 1) % num_channels;
+    next_output_position += decimation;
+  }
+
+  // Only keep the samples still needed by the next output
+  size_t num_consumed = next_output_position - (num_taps - 1);
+  history.erase(history.begin(), history.begin() + num_consumed);
+  next_output_position -= num_consumed;
+}
+
+/**
+ * Returns the center frequency of a channel, relative to the center of the input.
+ *
+ * @param channel channel index
+ * @param sample_rate sample rate of the input
+ */
+double channelizer::channel_frequency(uint32_t channel, uint64_t sample_rate) {
+  int64_t index = channel <= num_channels / 2 ? (int64_t)channel : (int64_t)channel - num_channels;
+  return (double)index * sample_rate / num_channels;
+}
+
+/**
+ * Returns the channel whose center is nearest to a frequency.
+ *
+ * @param frequency frequency relative to the center of the input
+ * @param sample_rate sample rate of the input
+ */
+uint32_t channelizer::nearest_channel(double frequency, uint64_t sample_rate) {
+  int64_t index = std::llround(frequency * num_channels / sample_rate);
+  return (uint32_t)(((index % num_channels) + num_channels) % num_channels);
+}
+
+/**
+ * Returns the largest number of channels for a decimation of a quarter of the
+ * number of channels, such that a signal anywhere in the input keeps its
+ * whole band within the passband of its nearest channel.
+ *
+ * @param sample_rate sample rate of the input
+ * @param half_bandwidth half of the bandwidth of the signal in Hz
+ * @param rate_multiple the channel sample rate must be a multiple of this
+ */
+uint32_t channelizer::get_num_channels(uint64_t sample_rate, double half_bandwidth, uint32_t rate_multiple) {
+  // The nearest channel center is up to half a spacing away, and the passband is 1.35 spacings wide on each side
+  double min_spacing = half_bandwidth / 0.85;
+  uint32_t num_channels = 4 * (uint32_t)std::floor(sample_rate / min_spacing / 4);
+  for(; num_channels > 4; num_channels -= 4) {
+    uint32_t decimation = num_channels / 4;
+    if(sample_rate % decimation == 0 && (sample_rate / decimation) % rate_multiple == 0)
+      break;
+  }
+  return std::max(4u, num_channels);
+}
@@ -0,0 +1,237 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <numeric>
+#include <functional>
+#include <spdlog/spdlog.h>
+#include "cost_estimator.h"
+#include "pdcch.h"
+#include "coreset.h"
+#include "dci.h"
+#include "symbol.h"
+
+namespace cost_estimator {
+  /// RNTI list scanned when measuring the repetition optimization
+  static constexpr uint16_t measured_rntis = 256;
+
+  uint64_t workload::total_correlations() const {
+    return std::accumulate(correlations.begin(), correlations.end(), (uint64_t)0);
+  }
+
+  uint64_t workload::total_equalizations() const {
+    return std::accumulate(equalizations.begin(), equalizations.end(), (uint64_t)0);
+  }
+
+  uint64_t workload::total_decodes() const {
+    return std::accumulate(decodes.begin(), decodes.end(), (uint64_t)0);
+  }
+
+  /**
+   * Counts the kernel calls of one slot of a CORESET the way pdcch::process
+   * makes them: one DMRS correlation per scrambling ID and candidate, and in
+   * the worst case one equalization per candidate and DCI size, decoded for
+   * every RNTI of the list. AL 8 and 16 use the repetition optimization
+   * instead, which scans the whole RNTI list for every decode.
+   *
+   * @param pdcch_cfg PDCCH config, as loaded from the config file
+   */
+  workload count_workload(const pdcch_config& pdcch_cfg) {
+    pdcch_config cfg = pdcch_cfg;
+    if (cfg.si_dci_only)
+      cfg.restrict_to_si_dci(0); // Only the ranges matter, not the cell ID
+
+    uint64_t num_scrambling_ids = cfg.scrambling_id_end >= cfg.scrambling_id_start ? cfg.scrambling_id_end - cfg.scrambling_id_start + 1 : 0;
+    uint64_t num_rntis = cfg.rnti_end >= cfg.rnti_start ? cfg.rnti_end - cfg.rnti_start + 1 : 0;
+    uint64_t num_low_al_rntis = std::min<uint64_t>(std::max(cfg.rnti_list_length, 0), num_rntis);
+    uint64_t num_dci_sizes = cfg.dci_sizes_list.size();
+    bool ue_rntis = cfg.rnti_start < 65520 && cfg.rnti_end > 100;
+
+    workload w;
+    for (size_t agg_level = 0; agg_level < NUM_ALs && agg_level < cfg.num_candidates_per_AL.size(); agg_level++) {
+      uint64_t candidates = num_scrambling_ids * cfg.num_candidates_per_AL.at(agg_level);
+      w.correlations[agg_level] = candidates;
+      w.equalizations[agg_level] = candidates * num_dci_sizes;
+      if (agg_level >= 3) {
+        w.decodes[agg_level] = w.equalizations[agg_level] * (ue_rntis ? 1 : num_rntis);
+        w.repetition_rntis[agg_level] = w.decodes[agg_level] * num_rntis;
+      } else {
+        w.decodes[agg_level] = w.equalizations[agg_level] * num_low_al_rntis;
+      }
+    }
+    return w;
+  }
+
+  /**
+   * Seconds per slot when no candidate passes the DMRS threshold.
+   */
+  double idle_seconds_per_slot(const workload& w, const kernel_costs& costs) {
+    double seconds = 0;
+    for (size_t agg_level = 0; agg_level < NUM_ALs; agg_level++)
+      seconds += w.correlations[agg_level] * costs.correlation[agg_level];
+    return seconds;
+  }
+
+  /**
+   * Seconds per slot when every candidate passes the DMRS threshold.
+   */
+  double worst_seconds_per_slot(const workload& w, const kernel_costs& costs) {
+    double seconds = idle_seconds_per_slot(w, costs);
+    for (size_t agg_level = 0; agg_level < NUM_ALs; agg_level++) {
+      seconds += w.equalizations[agg_level] * costs.equalization[agg_level];
+      seconds += w.decodes[agg_level] * costs.decode[agg_level];
+      seconds += w.repetition_rntis[agg_level] * costs.repetition_rnti;
+    }
+    return seconds;
+  }
+
+  /**
+   * Slots per second of the numerology of the CORESET.
+   */
+  uint32_t slots_per_second(const pdcch_config& pdcch_cfg) {
+    return 1000 * (1 << pdcch_cfg.numerology);
+  }
+
+  /**
+   * Number of cells each PDCCH config is searched for. In multi-cell mode,
+   * every PSS index has its own PDCCHs.
+   */
+  uint32_t cells_per_pdcch(const struct config& conf) {
+    if (!conf.multi_cell || conf.nid_2 <= nid_2_max)
+      return 1;
+    return nid_2_max + 1;
+  }
+
+  /**
+   * Average duration of a kernel, called repeatedly for about the given time.
+   */
+  static double time_kernel(const std::function<void()>& kernel, double seconds) {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t calls = 0;
+    std::chrono::duration<double> elapsed;
+    do {
+      kernel();
+      calls++;
+      elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed.count() < seconds);
+    return elapsed.count() / calls;
+  }
+
+  /**
+   * Measures the PDCCH kernels on this host, on noise in a two-symbol, 48 PRB
+   * interleaved CORESET with one candidate per AL.
+   *
+   * @param seconds_per_kernel time spent measuring each kernel and AL
+   */
+  kernel_costs kernel_costs::measure(double seconds_per_kernel) {
+    uint16_t cell_id = 1;
+    nr::pdcch pdcch;
+    pdcch.set_coreset_info(coreset(0, 48, 2, "interleaved", 6, 2, cell_id, cell_id, 0, 14, 10, {1, 1, 1, 1, 1}));
+    pdcch.scrambling_id_start = cell_id;
+    pdcch.scrambling_id_end = cell_id;
+    pdcch.rnti_start = 1000;
+    pdcch.rnti_end = 1000 + measured_rntis - 1;
+    pdcch.dci_sizes_list = {39};
+    pdcch.sample_rate_time = 23040000;
+    pdcch.initialize_RNTI_list();
+    pdcch.initialize_dmrs_seq();
+
+    mt19937 generator(1);
+    normal_distribution<float> distribution(0.0f, sqrt(0.5f));
+    symbol s;
+    s.samples.resize(48 * PRB_RE * 2);
+    for (auto& sample : s.samples)
+      sample = complex<float>(distribution(generator), distribution(generator));
+    frame_metadata metadata = {};
+    srsran_pdcch_nr_res_t res = {};
+
+    kernel_costs costs;
+    for (uint8_t agg_level = 0; agg_level < NUM_ALs; agg_level++) {
+      string key = to_string(cell_id) + to_string(agg_level) + "0" + "0";
+      auto& dmrs_symbols = pdcch.dmrs_seq_table.at(key);
+      auto& dmrs_sc_indices = pdcch.dmrs_sc_indices_table.at(key);
+      costs.correlation[agg_level] = time_kernel([&]() { pdcch.compute_correlation_DMRS(s, dmrs_symbols, dmrs_sc_indices); }, seconds_per_kernel);
+
+      dci candidate;
+      candidate.set_found_aggregation_level(1 << agg_level);
+      candidate.set_found_candidate(0);
+      candidate.set_nof_bits(39);
+      candidate.set_pdcch_scrambling_id(cell_id);
+      candidate.set_n_slot(0);
+      candidate.set_rnti(1000);
+      vector<complex<float>> equalized_symbols;
+      costs.equalization[agg_level] = time_kernel([&]() { equalized_symbols = pdcch.estimate_channel_dci(s, candidate); }, seconds_per_kernel);
+      costs.decode[agg_level] = time_kernel([&]() { pdcch.decode_pdcch(s, equalized_symbols, candidate, &res, false, metadata); }, seconds_per_kernel);
+
+      // AL 16 always repeats, so the extra time of the repetition optimization is spent scanning the RNTI list
+      if (agg_level == NUM_ALs - 1) {
+        double repetition_decode = time_kernel([&]() { pdcch.decode_pdcch(s, equalized_symbols, candidate, &res, true, metadata); }, seconds_per_kernel);
+        costs.repetition_rnti = std::max(repetition_decode - costs.decode[agg_level], 0.0) / measured_rntis;
+      }
+    }
+    return costs;
+  }
+
+  /**
+   * Logs the predicted PDCCH load of a config: the kernel calls per slot, the
+   * real-time factor when idle and in the worst case, and the cores needed.
+   * A real-time factor above 1 means the search falls behind the signal.
+   *
+   * @param conf loaded config
+   */
+  void report(const struct config& conf) {
+    SPDLOG_INFO("Measuring the PDCCH kernels on this host");
+    kernel_costs costs = kernel_costs::measure();
+    for (uint8_t agg_level = 0; agg_level < NUM_ALs; agg_level++) {
+      SPDLOG_INFO("AL {:2}: DMRS correlation {:.2f} us, equalization {:.2f} us, polar decode {:.2f} us",
+        1 << agg_level, costs.correlation[agg_level] * 1e6, costs.equalization[agg_level] * 1e6, costs.decode[agg_level] * 1e6);
+    }
+    SPDLOG_INFO("Repetition optimization: {:.3f} us per RNTI", costs.repetition_rnti * 1e6);
+
+    uint32_t cells = cells_per_pdcch(conf);
+    double idle_load = 0;
+    double worst_load = 0;
+    for (size_t i = 0; i < conf.pdcch_configs.size(); i++) {
+      const pdcch_config& pdcch_cfg = conf.pdcch_configs.at(i);
+      workload w = count_workload(pdcch_cfg);
+      double idle_factor = idle_seconds_per_slot(w, costs) * slots_per_second(pdcch_cfg) * cells;
+      double worst_factor = worst_seconds_per_slot(w, costs) * slots_per_second(pdcch_cfg) * cells;
+      idle_load += idle_factor;
+      worst_load += worst_factor;
+      SPDLOG_INFO("PDCCH {}: {} DMRS correlations per slot, and in the worst case {} equalizations and {} polar decodes per slot",
+        i, w.total_correlations(), w.total_equalizations(), w.total_decodes());
+      SPDLOG_INFO("PDCCH {}: real-time factor {:.3g} idle, {:.3g} in the worst case", i, idle_factor, worst_factor);
+    }
+    if (cells > 1)
+      SPDLOG_INFO("Each PDCCH is searched for {} cells", cells);
+
+    uint32_t cores = std::max(1.0, std::ceil(worst_load));
+    uint32_t host_cores = std::thread::hardware_concurrency();
+    SPDLOG_INFO("Predicted real-time factor {:.3g} idle, {:.3g} in the worst case, {} cores needed ({} available)", idle_load, worst_load, cores, host_cores);
+    if (std::ceil(idle_load) > host_cores)
+      SPDLOG_WARN("This config cannot run in real time on this host even without any DCI");
+    else if (cores > host_cores)
+      SPDLOG_WARN("This config may fall behind in real time on this host when the CORESET is busy");
+  }
+}
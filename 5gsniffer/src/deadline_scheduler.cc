@@ -0,0 +1,158 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <algorithm>
+#include <spdlog/spdlog.h>
+#include "deadline_scheduler.h"
+#include "exceptions.h"
+#include "metrics.h"
+
+/**
+ * Parses the name of a shedding step, as used in the config file.
+ */
+shed_step parse_shed_step(const string& name) {
+  if (name == "low_al")
+    return shed_step::low_al;
+  if (name == "rnti_list")
+    return shed_step::rnti_list;
+  if (name == "scrambling_ids")
+    return shed_step::scrambling_ids;
+  throw config_exception("Unknown shed step " + name + ", expected low_al, rnti_list or scrambling_ids");
+}
+
+const char* shed_step_name(shed_step step) {
+  switch (step) {
+    case shed_step::low_al: return "low_al";
+    case shed_step::rnti_list: return "rnti_list";
+    case shed_step::scrambling_ids: return "scrambling_ids";
+  }
+  return "unknown";
+}
+
+/**
+ * Constructor for deadline_scheduler.
+ *
+ * @param slot_budget compute time allowed for the CORESET of one slot
+ * @param order steps to shed, in the order they are applied
+ * @param hot_rnti_count number of RNTIs decoded while shedding the RNTI list
+ * @param recovery_slots number of slots in a row under half the budget before a step is lifted
+ */
+deadline_scheduler::deadline_scheduler(chrono::nanoseconds slot_budget, vector<shed_step> order, size_t hot_rnti_count, uint32_t recovery_slots) :
+  slot_budget(slot_budget),
+  order(order),
+  hot_rnti_count(std::max<size_t>(hot_rnti_count, 1)),
+  recovery_slots(std::max<uint32_t>(recovery_slots, 1)),
+  level(0),
+  slots_under_budget(0) {
+}
+
+/**
+ * Destructor for deadline_scheduler.
+ */
+deadline_scheduler::~deadline_scheduler() {
+  metrics::add_gauge(metrics::pdcch_shed_level, -(int64_t)level.load());
+}
+
+/**
+ * Number of steps of the order currently applied.
+ */
+uint8_t deadline_scheduler::get_level() const {
+  return level.load(memory_order_relaxed);
+}
+
+bool deadline_scheduler::is_shedding(shed_step step) const {
+  uint8_t applied = get_level();
+  for (uint8_t i = 0; i < applied; i++) {
+    if (order.at(i) == step)
+      return true;
+  }
+  return false;
+}
+
+/**
+ * Whether the candidates of an AL index are skipped. AL 1 and 2 are the most
+ * numerous candidates, and the least likely to carry the DCIs of a cell.
+ */
+bool deadline_scheduler::skip_aggregation_level(uint8_t agg_level) const {
+  return agg_level < 2 && is_shedding(shed_step::low_al);
+}
+
+/**
+ * Number of RNTIs from the front of the RNTI list to decode. As found RNTIs
+ * are moved to the front of the list, the front holds the hot RNTIs.
+ *
+ * @param num_rntis number of RNTIs that would be decoded without shedding
+ */
+size_t deadline_scheduler::rnti_limit(size_t num_rntis) const {
+  if (is_shedding(shed_step::rnti_list))
+    return std::min(num_rntis, hot_rnti_count);
+  return num_rntis;
+}
+
+/**
+ * Scrambling IDs of the configured range DCIs were found with. Until then, the
+ * cell ID, which the SI DCI uses, is searched.
+ */
+vector<uint16_t> deadline_scheduler::get_scrambling_ids(uint16_t scrambling_id_start, uint16_t scrambling_id_end, uint16_t cell_id) {
+  vector<uint16_t> scrambling_ids;
+  {
+    lock_guard<mutex> lock(hot_scrambling_ids_mutex);
+    for (auto it = hot_scrambling_ids.lower_bound(scrambling_id_start); it != hot_scrambling_ids.end() && *it <= scrambling_id_end; it++)
+      scrambling_ids.push_back(*it);
+  }
+  if (scrambling_ids.empty())
+    scrambling_ids.push_back(cell_id >= scrambling_id_start && cell_id <= scrambling_id_end ? cell_id : scrambling_id_start);
+  return scrambling_ids;
+}
+
+void deadline_scheduler::add_hot_scrambling_id(uint16_t scrambling_id) {
+  lock_guard<mutex> lock(hot_scrambling_ids_mutex);
+  hot_scrambling_ids.insert(scrambling_id);
+}
+
+/**
+ * Reports the compute time of a slot, and applies or lifts a step of the
+ * order accordingly.
+ */
+void deadline_scheduler::slot_done(chrono::nanoseconds elapsed) {
+  if (elapsed > slot_budget) {
+    metrics::count(metrics::slots_over_budget);
+    slots_under_budget.store(0, memory_order_relaxed);
+    uint8_t current = level.load();
+    if (current < order.size() && level.compare_exchange_strong(current, current + 1)) {
+      metrics::add_gauge(metrics::pdcch_shed_level, 1);
+      SPDLOG_WARN("PDCCH slot took {} us, over its budget of {} us, shedding {}",
+        chrono::duration_cast<chrono::microseconds>(elapsed).count(), chrono::duration_cast<chrono::microseconds>(slot_budget).count(), shed_step_name(order.at(current)));
+    }
+  } else if (elapsed < slot_budget / 2) {
+    if (slots_under_budget.fetch_add(1, memory_order_relaxed) + 1 >= recovery_slots) {
+      slots_under_budget.store(0, memory_order_relaxed);
+      uint8_t current = level.load();
+      if (current > 0 && level.compare_exchange_strong(current, current - 1)) {
+        metrics::add_gauge(metrics::pdcch_shed_level, -1);
+        SPDLOG_INFO("PDCCH back under budget for {} slots, no longer shedding {}", recovery_slots, shed_step_name(order.at(current - 1)));
+      }
+    }
+  } else {
+    // The slots under half the budget must be in a row
+    slots_under_budget.store(0, memory_order_relaxed);
+  }
+}
@@ -93,11 +93,13 @@ void moving_correlate(vector<complex<float>>& output, span<complex<float>> a, sp
       return;
     }
 
-    int32_t window_size_int = static_cast<int32_t>(window_size);
-    for(int32_t i = 0; i < iterations; i++) {
-      int32_t start = std::max(i+1 - window_size_int, 0);
-      int32_t length = std::min(i+1, window_size_int);
-      volk_32fc_x2_conjugate_dot_prod_32fc(output.data()+i, a.data()+start, b.data()+start, length);
+    // Running sum over the window: add the newest product, subtract the one leaving the window
+    complex<double> sum = 0;
+    for(size_t i = 0; i < iterations; i++) {
+      sum += complex<double>(a[i] * conj(b[i]));
+      if (i >= window_size)
+        sum -= complex<double>(a[i - window_size] * conj(b[i - window_size]));
+      output[i] = complex<float>(sum);
     }
   } else {
     SPDLOG_ERROR("Invalid sizes for correlation: size of a must be == b");
@@ -141,9 +143,67 @@ void magnitude(vector<float>& output, span<complex<float>> input) {
 }
 
 void rotate(vector<complex<float>>& output, span<complex<float>> input, float frequency, uint32_t sample_rate) {
-  float phase_rotation_per_t = (frequency * (2*std::numbers::pi)) / (float)sample_rate;
   complex<float> phase_start(1.0, 0.0);
+  rotate(output, input, frequency, sample_rate, phase_start);
+}
+
+/**
+ * Rotates the input starting from a given phase, and updates the phase so
+ * that consecutive buffers are rotated continuously.
+ */
+void rotate(vector<complex<float>>& output, span<complex<float>> input, float frequency, uint32_t sample_rate, complex<float>& phase) {
+  float phase_rotation_per_t = (frequency * (2*std::numbers::pi)) / (float)sample_rate;
   complex<float> complex_phase_rotation_per_t(std::cos(phase_rotation_per_t), std::sin(phase_rotation_per_t));
 
-  volk_32fc_s32fc_x2_rotator_32fc(output.data(), input.data(), complex_phase_rotation_per_t, &phase_start, input.size()); 
-}
\ No newline at end of file
+  volk_32fc_s32fc_x2_rotator_32fc(output.data(), input.data(), complex_phase_rotation_per_t, &phase, input.size()); 
+}
+
+/**
+ * Filters the input and keeps every decimation-th output, computing only the
+ * kept outputs. Output j is the filter output at input sample j * decimation,
+ * with the filter starting filled with zeros.
+ *
+ * @param output decimated samples
+ * @param input input samples
+ * @param taps filter taps
+ * @param decimation decimation factor
+ */
+void decimate(vector<complex<float>>& output, span<const complex<float>> input, span<const float> taps, size_t decimation) {
+  output.resize((input.size() + decimation - 1) / decimation);
+  for(size_t j = 0; j < output.size(); j++) {
+    size_t n = j * decimation;
+    size_t num_taps = std::min(taps.size(), n + 1);
+    complex<float> sum = 0;
+    for(size_t k = 0; k < num_taps; k++) {
+      sum += input[n - k] * taps[k];
+    }
+    output[j] = sum;
+  }
+}
+
+/**
+ * Correlates samples with themselves delayed by delay samples, summed over a
+ * window of window_size samples ending at each of the requested lags. Samples
+ * before the start are taken as zero, so this gives the same values as
+ * moving_correlate with a zero-padded delayed copy, but only at the lags.
+ *
+ * @param output correlation for each lag
+ * @param samples input samples
+ * @param delay delay in samples, i.e. the useful symbol length
+ * @param window_size length of the window, i.e. the CP length
+ * @param lags indices of the last sample of each window
+ */
+void cp_correlate(vector<complex<float>>& output, span<const complex<float>> samples, size_t delay, size_t window_size, span<const size_t> lags) {
+  output.resize(lags.size());
+  for(size_t i = 0; i < lags.size(); i++) {
+    output[i] = 0;
+    size_t end = lags[i] + 1;
+    if (end > samples.size()) {
+      SPDLOG_ERROR("CP correlation lag {} is outside of {} samples", lags[i], samples.size());
+      continue;
+    }
+    size_t start = std::max(end > window_size ? end - window_size : 0, delay);
+    if (start < end)
+      volk_32fc_x2_conjugate_dot_prod_32fc(&output[i], samples.data() + start, samples.data() + start - delay, end - start);
+  }
+}
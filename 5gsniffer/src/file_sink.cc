@@ -46,7 +46,7 @@ file_sink::~file_sink() {
  *
  * @param samples shared_ptr to sample buffer to write
  */
-void file_sink::process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata) {
+void file_sink::process(shared_ptr<vector<complex<float>>>& samples, const frame_metadata& metadata) {
   size_t size_bytes = samples->size() * sizeof(complex<float>);
   f.write(reinterpret_cast<char*>(samples->data()), size_bytes);
   SPDLOG_DEBUG("Wrote {} samples ({} bytes)", samples->size(), size_bytes);
@@ -22,6 +22,12 @@
 #include "file_source.h"
 #include "spdlog/spdlog.h"
 #include <cstdint>
+#include <thread>
+#include <limits>
+#include <filesystem>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
 
 using namespace std;
 
@@ -30,11 +36,27 @@ using namespace std;
  *
  * @param path path to the file to read
  * @param sample_rate sample rate at which the file was recorded
+ * @param repeat restart from the beginning of the file at EOF
+ * @param realtime pace the samples to sample_rate, as an SDR would deliver them
+ * @param follow at EOF, wait for the file to grow instead of ending
+ * @param follow_timeout seconds without growth after which a followed file ends, 0 to wait forever
  */
-file_source::file_source(uint64_t sample_rate, string path, bool repeat) :
+file_source::file_source(uint64_t sample_rate, string path, bool repeat, bool realtime, bool follow, double follow_timeout) :
+  sample_rate(sample_rate),
+  path(path),
   repeat(repeat),
+  realtime(realtime),
+  follow(follow),
+  follow_timeout(follow_timeout),
+  inotify_fd(-1),
+  next_lag_report(sample_rate),
   f{path, ifstream::binary},
-  size_bytes(0) {
+  size_bytes(0),
+  processing_seconds(0.0),
+  signal_seconds(0.0),
+  min_slack_seconds(std::numeric_limits<double>::max()),
+  num_chunks(0),
+  num_overflows(0) {
   SPDLOG_DEBUG("Opening file_source from {} ({} sps)", path, sample_rate);
   if(f) {
     f.seekg(0, f.end);
@@ -44,6 +66,13 @@ file_source::file_source(uint64_t sample_rate, string path, bool repeat) :
   } else {
     throw sniffer_exception("File could not be opened");
   }
+
+  if(follow) {
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(inotify_fd < 0 || inotify_add_watch(inotify_fd, path.c_str(), IN_MODIFY | IN_CLOSE_WRITE) < 0)
+      throw sniffer_exception("Could not watch file for changes");
+    SPDLOG_INFO("Following {} as it is written", path);
+  }
 }
 
 /** 
@@ -51,6 +80,8 @@ file_source::file_source(uint64_t sample_rate, string path, bool repeat) :
  */
 file_source::~file_source() {
   f.close();
+  if(inotify_fd >= 0)
+    close(inotify_fd);
 }
 
 /** 
@@ -59,16 +90,31 @@ file_source::~file_source() {
  * @param num_samples number of samples to read
  */
 shared_ptr<vector<complex<float>>> file_source::produce_samples(size_t num_samples) {
+  if(realtime)
+    pace(num_samples);
+
   vector<complex<float>> buffer(num_samples);
+  char* data = reinterpret_cast<char*>(buffer.data());
+  size_t requested_bytes = num_samples * sizeof(complex<float>);
 
-  f.read(reinterpret_cast<char*>(buffer.data()), num_samples * sizeof(complex<float>));
+  f.read(data, requested_bytes);
+  size_t read_bytes = f.gcount();
+
+  // When following, wait for the writer to provide the rest of the chunk, so the syncer keeps its state
+  while(follow && f.eof() && read_bytes < requested_bytes && wait_for_data()) {
+    f.clear();
+    f.read(data + read_bytes, requested_bytes - read_bytes);
+    read_bytes += f.gcount();
+  }
 
   if(f.eof()) {
-    buffer.resize(f.gcount() / sizeof(complex<float>)); // Resize buffer to the number of samples that were read successfully
+    buffer.resize(read_bytes / sizeof(complex<float>)); // Resize buffer to the number of samples that were read successfully
 
     if(repeat) {
       f.seekg(0, f.beg);
     } else {
+      if(realtime)
+        report_realtime_stats();
       this->on_end();
     }
   }
@@ -77,5 +123,104 @@ shared_ptr<vector<complex<float>>> file_source::produce_samples(size_t num_sampl
   SPDLOG_DEBUG("Read {} samples ({} bytes)", buffer.size(), size_bytes);
   total_produced_samples += buffer.size();
 
+  if(follow && total_produced_samples >= next_lag_report) {
+    SPDLOG_INFO("Lagging {:.3f} s behind the writer of {}", get_lag_seconds(), path);
+    next_lag_report += sample_rate;
+  }
+
   return make_shared<vector<complex<float>>>(std::move(buffer));
-}
\ No newline at end of file
+}
+
+/** 
+ * Gets the time of a sample relative to the start of the recording.
+ *
+ * @param sample_index index of the sample in the file
+ */
+int64_t file_source::get_timestamp_ns(int64_t sample_index) {
+  return (int64_t)((double)sample_index * 1e9 / sample_rate);
+}
+
+/** 
+ * Waits until the next num_samples samples would have been received by an SDR
+ * running at sample_rate, and keeps track of the processing slack. A chunk
+ * that is requested later than one chunk duration after it became available
+ * is counted as an overflow, i.e. the SDR would have dropped samples. The
+ * schedule is then shifted, as the dropped samples would have reset it.
+ *
+ * @param num_samples number of samples in the next chunk
+ */
+void file_source::pace(size_t num_samples) {
+  auto now = chrono::steady_clock::now();
+  double chunk_seconds = (double)num_samples / sample_rate;
+
+  if(num_chunks == 0) {
+    realtime_start = now;
+  } else {
+    processing_seconds += chrono::duration<double>(now - last_chunk_time).count();
+  }
+
+  // Time since start at which the last sample of the chunk would be received
+  double available_seconds = (double)(total_produced_samples + num_samples) / sample_rate;
+  double elapsed_seconds = chrono::duration<double>(now - realtime_start).count();
+  double slack_seconds = available_seconds - elapsed_seconds;
+  min_slack_seconds = std::min(min_slack_seconds, slack_seconds);
+
+  if(slack_seconds > 0) {
+    std::this_thread::sleep_for(chrono::duration<double>(slack_seconds));
+  } else if(-slack_seconds > chunk_seconds) {
+    num_overflows++;
+    realtime_start += chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(-slack_seconds));
+    SPDLOG_DEBUG("Chunk {} would have overflowed ({:.3f} ms late)", num_chunks, -slack_seconds * 1000);
+  }
+
+  num_chunks++;
+  signal_seconds += chunk_seconds;
+  last_chunk_time = chrono::steady_clock::now();
+}
+
+/** 
+ * Reports the real-time factor, i.e. the fraction of the signal duration spent
+ * processing, and the number of chunks that would have overflowed on an SDR.
+ */
+void file_source::report_realtime_stats() {
+  double real_time_factor = signal_seconds > 0 ? processing_seconds / signal_seconds : 0.0;
+  SPDLOG_INFO("Real-time replay: {} chunks, real-time factor {:.3f}, minimum slack {:.3f} ms, {} overflows",
+              num_chunks, real_time_factor, min_slack_seconds * 1000, num_overflows);
+}
+
+/** 
+ * Blocks until the followed file is modified.
+ *
+ * @return false if the file did not grow within follow_timeout seconds
+ */
+bool file_source::wait_for_data() {
+  SPDLOG_DEBUG("Caught up with the writer of {}, waiting for more samples", path);
+  struct pollfd pfd = {.fd = inotify_fd, .events = POLLIN, .revents = 0};
+  int timeout_ms = follow_timeout > 0 ? (int)(follow_timeout * 1000) : -1;
+
+  int ret = poll(&pfd, 1, timeout_ms);
+  if(ret < 0) {
+    SPDLOG_ERROR("Failed to wait for changes to {}", path);
+    return false;
+  } else if(ret == 0) {
+    SPDLOG_INFO("No new samples in {} for {} s, assuming the recording ended", path, follow_timeout);
+    return false;
+  }
+
+  // Drain the pending events, we only care that the file changed
+  char events[4096];
+  while(read(inotify_fd, events, sizeof(events)) > 0) {}
+  return true;
+}
+
+/** 
+ * Gets how far the reader trails the writer of the file, in seconds of signal.
+ */
+double file_source::get_lag_seconds() {
+  std::error_code ec;
+  uintmax_t written_bytes = std::filesystem::file_size(path, ec);
+  if(ec)
+    return 0.0;
+  double read_bytes = (double)total_produced_samples * sizeof(complex<float>);
+  return std::max(0.0, ((double)written_bytes - read_bytes) / sizeof(complex<float>) / sample_rate);
+}
@@ -21,19 +21,25 @@
 
 #include "flow.h"
 #include "spdlog/spdlog.h"
+#include "tracing.h"
 #include <asm-generic/errno.h>
-#include <unistd.h>
 #include <zmq.hpp>
+#include <cstring>
 
 using namespace std;
 
 /** 
- * Constructor for flow.
+ * Constructor for flow. The thread connects to the pool and says hello, after
+ * which the pool sends it the start message.
  *
- * @param path path to the file to write
+ * @param flow_id index of the flow in its pool
+ * @param send_socket router socket of the pool
+ * @param send_socket_mutex mutex held while using the router socket
+ * @param available_flows semaphore released whenever the flow becomes available
  */
-flow::flow(uint64_t flow_id, zmq::socket_ref send_socket, shared_ptr<counting_semaphore<>> available_flows) :
+flow::flow(uint64_t flow_id, zmq::socket_ref send_socket, shared_ptr<mutex> send_socket_mutex, shared_ptr<counting_semaphore<>> available_flows) :
   flow_id(flow_id),
+  send_socket_mutex(send_socket_mutex),
   available_flows(available_flows) {
   finished = false;
   sniffer_finished = false;
@@ -42,15 +48,11 @@ flow::flow(uint64_t flow_id, zmq::socket_ref send_socket, shared_ptr<counting_se
   stringstream ss;
   ss << "flow_" << flow_id;
   routing_id = ss.str();
-  metadata = 0;
 
   this->send_socket = send_socket;
 
   t = thread(&flow::handle_messages, this);
   SPDLOG_DEBUG("Created flow with thread id {}", std::hash<thread::id>{}(t.get_id()));
-
-  // Block until we receive the start message acknowledgement from the flow thread
-  wait_for_start_message_ack(send_socket);
 }
 
 flow::~flow() {
@@ -66,25 +68,8 @@ void flow::set_available() {
   this->available_flows->release();
 }
 
-void flow::wait_for_start_message_ack(zmq::socket_ref send_socket) {
-  SPDLOG_DEBUG("Waiting for {} start message acknowledgement", routing_id);
-  zmq::message_t identifier(routing_id);
-  zmq::message_t empty;
-
-  bool success = false;
-  do {
-    try {
-      send_socket.send(identifier, zmq::send_flags::sndmore);
-      send_socket.send(empty, zmq::send_flags::none);
-      success = true;
-    } catch(zmq::error_t e) {
-      if (e.num() != EHOSTUNREACH) {
-        SPDLOG_ERROR("ZMQ error: {}", e.what());
-      } else {
-        usleep(1000); // Wait a millisecond before trying to connect to the flow again
-      }
-    }
-  } while(!success);
+thread::native_handle_type flow::native_handle() {
+  return t.native_handle();
 }
 
 void flow::wait_for_start_message(zmq::socket_ref receive_socket) {
@@ -104,6 +89,7 @@ void flow::finish() {
   try {
     zmq::message_t identifier(routing_id);
     zmq::message_t empty;
+    lock_guard<mutex> lock(*send_socket_mutex);
     send_socket.send(std::move(identifier), zmq::send_flags::sndmore);
     auto result = send_socket.send(std::move(empty), zmq::send_flags::none);
   } catch(zmq::error_t e) {  // Ignore stop message that don't arrive because the flow already stopped
@@ -114,22 +100,22 @@ void flow::finish() {
 }
 
 /** 
- * 
+ * Sends the samples to the flow thread. The metadata is sent as a separate
+ * message part, so it stays attached to its samples.
  *
  * @param samples shared_ptr to sample buffer
+ * @param metadata description of the first sample of the buffer
  */
-void flow::process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata_) {
+void flow::process(shared_ptr<vector<complex<float>>>& samples, const frame_metadata& metadata) {
   zmq::message_t identifier(routing_id);
-  zmq::message_t payload(samples->begin(), samples->end()); // I MIGHT HAVE TO ADD THE METADATA HERE.
-  // payload.append(metadata_);
-  metadata = metadata_;
-  // zmq::message_t meta(metadata_);
+  zmq::message_t meta(&metadata, sizeof(metadata));
+  zmq::message_t payload(samples->begin(), samples->end());
   
+  lock_guard<mutex> lock(*send_socket_mutex);
   send_socket.send(std::move(identifier), zmq::send_flags::sndmore);
-  // send_socket.send(std::move(meta), zmq::send_flags::sndmore);
+  send_socket.send(std::move(meta), zmq::send_flags::sndmore);
   auto result = send_socket.send(std::move(payload), zmq::send_flags::none);
-  SPDLOG_DEBUG("Sent {} bytes to {}", *result, routing_id);
-  SPDLOG_DEBUG("Metadata is {}", metadata_);
+  SPDLOG_DEBUG("Sent {} bytes to {} (sample index {})", *result, routing_id, metadata.sample_index);
 }
 
 void flow::handle_messages() {
@@ -140,27 +126,35 @@ void flow::handle_messages() {
   receive_socket.set(zmq::sockopt::linger, 0);
   receive_socket.connect("tcp://127.0.0.1:23501");
 
-  // Wait until we are connected to the sender
+  // Say hello, so the pool knows we are connected, and wait for its start message
+  receive_socket.send(zmq::message_t(), zmq::send_flags::none);
   wait_for_start_message(receive_socket);
 
   while(!sniffer_finished) {
     finished = false;
 
     while(!finished) {
-      // Receive a new message
-      zmq::message_t msg;
-      auto result = receive_socket.recv(msg, zmq::recv_flags::none);
-      SPDLOG_DEBUG("Received {} bytes from {} metadata {}", *result, routing_id, metadata);
+      // Receive a new message, which is either empty (stop) or the metadata followed by the samples
+      zmq::message_t meta;
+      auto result = receive_socket.recv(meta, zmq::recv_flags::none);
       if(*result == 0) {
         finished = true;
         continue;
       }
+      assert(meta.size() == sizeof(frame_metadata));
+      frame_metadata metadata;
+      std::memcpy(&metadata, meta.data(), sizeof(metadata));
+
+      zmq::message_t msg;
+      result = receive_socket.recv(msg, zmq::recv_flags::none);
+      tracing::trace_scope trace("flow::handle_messages");
+      SPDLOG_DEBUG("Received {} bytes from {} (sample index {})", *result, routing_id, metadata.sample_index);
 
       // Convert to vector
       complex<float>* msg_data = reinterpret_cast<complex<float>*>(msg.data());
       auto samples = make_shared<vector<complex<float>>>(msg_data, msg_data + (msg.size() / sizeof(complex<float>)));
       SPDLOG_DEBUG("Going to RoTate");
-      this->send_to_next_workers(samples,metadata);
+      this->send_to_next_workers(samples, metadata);
     }
 
     this->disconnect_all();
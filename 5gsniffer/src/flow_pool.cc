@@ -20,56 +20,126 @@
  */
 
 #include "flow_pool.h"
+#include "affinity.h"
+#include "config.h"
+#include "metrics.h"
 #include <cstdint>
+#include <algorithm>
+#include <thread>
 #include <exception>
 #include <memory>
 #include <spdlog/spdlog.h>
 
+extern struct config config;
+
 namespace nr {
   /** 
   * Constructor for flow_pool.
+  *
+  * @param max_flows maximum number of flows the pool may grow to
+  * @param initial_flows number of flows to start right away, all of them if 0
+  * @param cpus CPUs to pin the flow threads to, round robin, not pinned if empty
   */
-  flow_pool::flow_pool(uint64_t max_flows) :
-    max_flows(max_flows) {
+  flow_pool::flow_pool(uint64_t max_flows, uint64_t initial_flows, vector<int> cpus) :
+    max_flows(max_flows),
+    cpus(cpus) {
     // Create available flows semaphore
     available_flows = make_shared<counting_semaphore<>>(0);
+    zmq_socket_mutex = make_shared<mutex>();
 
     // Create zmq server socket
     zmq_socket = zmq::socket_t(main_ctx, zmq::socket_type::router);
     zmq_socket.set(zmq::sockopt::router_mandatory, 1);
     zmq_socket.bind("tcp://127.0.0.1:23501");
 
+    if (initial_flows == 0 || initial_flows > max_flows)
+      initial_flows = max_flows;
     this->pool.reserve(max_flows);
-    for(uint64_t i = 0; i < max_flows; i++) {
-      this->pool.push_back(make_shared<flow>(i, zmq_socket, available_flows));
-    }
+    add_flows(initial_flows);
   }
 
   flow_pool::~flow_pool() {
-    this->release_flows();
-    
     // Wait for all flows to finish
-    for(uint64_t i = 0; i < max_flows; i++) {
+    for(uint64_t i = 0; i < pool.size(); i++) {
       available_flows->acquire();
     }
 
     // Set sniffer_finished to true so all available flows stop
     SPDLOG_DEBUG("All flows finished. Stopping threads...");
-    for(uint64_t i = 0; i < max_flows; i++) {
-      this->pool.at(i)->sniffer_finished = true;
-      this->pool.at(i)->finish();
+    for(auto& flow : pool) {
+      flow->sniffer_finished = true;
+      flow->finish();
     }
   }
 
+  /**
+  * Creates a pool with the size and CPU pinning set in the config: max_flows
+  * and initial_flows, where 0 initial flows means one per hardware thread, and
+  * flow_cpus or else the CPUs of numa_node.
+  */
+  shared_ptr<flow_pool> flow_pool::from_config() {
+    uint64_t initial_flows = config.initial_flows;
+    if (initial_flows == 0)
+      initial_flows = std::max(1u, std::thread::hardware_concurrency());
+
+    vector<int> cpus;
+    if (!config.flow_cpus.empty())
+      cpus = parse_cpu_list(config.flow_cpus);
+    else if (config.numa_node >= 0)
+      cpus = get_numa_node_cpus(config.numa_node);
+
+    return make_shared<flow_pool>(config.max_flows, std::min<uint64_t>(initial_flows, config.max_flows), cpus);
+  }
+
+  /**
+  * Starts new flows. Their threads are all created first and then started as
+  * they connect, so the connections are set up in parallel.
+  *
+  * @param num_flows number of flows to add
+  */
+  void flow_pool::add_flows(uint64_t num_flows) {
+    for(uint64_t i = 0; i < num_flows; i++) {
+      uint64_t flow_id = pool.size();
+      auto new_flow = make_shared<flow>(flow_id, zmq_socket, zmq_socket_mutex, available_flows);
+      if (!cpus.empty())
+        set_thread_affinity(new_flow->native_handle(), span<const int>(&cpus.at(flow_id % cpus.size()), 1));
+      pool.push_back(new_flow);
+    }
+
+    // Every flow says hello once connected, answer with its start message
+    lock_guard<mutex> lock(*zmq_socket_mutex);
+    for(uint64_t i = 0; i < num_flows; i++) {
+      zmq::message_t identifier;
+      zmq::message_t hello;
+      auto result = zmq_socket.recv(identifier, zmq::recv_flags::none);
+      result = zmq_socket.recv(hello, zmq::recv_flags::none);
+      zmq_socket.send(identifier, zmq::send_flags::sndmore);
+      zmq_socket.send(zmq::message_t(), zmq::send_flags::none);
+    }
+    SPDLOG_DEBUG("Started {} flows, {} in total", num_flows, pool.size());
+  }
+
   shared_ptr<flow> flow_pool::acquire_flow() {
-    // Wait for at least one flow to become available
-    available_flows->acquire();
+    // Grow the pool if no flow is available, otherwise wait for at least one flow to become available
+    if (!available_flows->try_acquire()) {
+      {
+        lock_guard<mutex> lock(pool_mutex);
+        if (pool.size() < max_flows) {
+          add_flows(std::min<uint64_t>(std::max<uint64_t>(pool.size(), 1), max_flows - pool.size()));
+          SPDLOG_INFO("Flow pool grew to {} flows", pool.size());
+        }
+      }
 
-    // Find the first available flow
+      // Not under the pool mutex, so that other callers can still acquire the flows that become available
+      available_flows->acquire();
+    }
+
+    // Find the first available flow. Each semaphore permit stands for one of them.
+    lock_guard<mutex> lock(pool_mutex);
     for (vector<shared_ptr<flow>>::iterator it = this->pool.begin(); it != this->pool.end(); ++it) {
       if((*it)->available) {
         (*it)->available = false;
-        this->acquired_flows.push_back(*it);
+        metrics::add_gauge(metrics::flows_in_use, 1);
         return *it;
       }
     }
@@ -77,22 +147,50 @@ namespace nr {
     throw sniffer_exception("Flow pool semaphore indicated a flow is available, but this was not the case.");
   }
 
-  void flow_pool::release_flows() {
+  /**
+  * Number of flows started so far.
+  */
+  size_t flow_pool::size() {
+    lock_guard<mutex> lock(pool_mutex);
+    return pool.size();
+  }
+
+  /** 
+  * Constructor for flow_set.
+  *
+  * @param pool pool to acquire the flows from
+  */
+  flow_set::flow_set(shared_ptr<flow_pool> pool) :
+    pool(pool) {
+  }
+
+  flow_set::~flow_set() {
+    this->release_flows();
+  }
+
+  shared_ptr<flow> flow_set::acquire_flow() {
+    auto flow = pool->acquire_flow();
+    this->acquired_flows.push_back(flow);
+    return flow;
+  }
+
+  void flow_set::release_flows() {
     for (vector<shared_ptr<flow>>::iterator it = this->acquired_flows.begin(); it != this->acquired_flows.end(); ++it) {
       (*it)->finish();
     }
+    metrics::add_gauge(metrics::flows_in_use, -(int64_t)this->acquired_flows.size());
     this->acquired_flows.clear();
   }
 
   /** 
-  * 
+  * Sends samples to all flows of the set.
   *
   * @param samples shared_ptr to sample buffer
   */
-  void flow_pool::process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata_) {
+  void flow_set::process(shared_ptr<vector<complex<float>>>& samples, const frame_metadata& metadata_) {
     // Send samples to all acquired flows
     for (vector<shared_ptr<flow>>::iterator it = this->acquired_flows.begin(); it != this->acquired_flows.end(); ++it) {
       (*it)->process(samples, metadata_);
     }
   }
-}
\ No newline at end of file
+}
@@ -0,0 +1,85 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include "grid_sink.h"
+#include "spdlog/spdlog.h"
+
+using namespace std;
+
+/**
+ * Constructor for grid_sink. Writes the file header right away.
+ *
+ * @param path path to the file to write
+ * @param header description of the recorded CORESET
+ */
+grid_sink::grid_sink(string path, grid_file_header header) :
+  f{path, ofstream::binary},
+  half_precision(header.flags & grid_flag_half_precision) {
+  SPDLOG_DEBUG("Opening grid_sink to {}", path);
+  if(!f)
+    throw sniffer_exception("Grid recording file could not be opened");
+
+  header.magic = grid_magic;
+  header.version = grid_version;
+  f.write(reinterpret_cast<char*>(&header), sizeof(header));
+}
+
+/**
+ * Destructor for grid_sink.
+ */
+grid_sink::~grid_sink() {
+  f.close();
+}
+
+/**
+ * Writes one frame per CORESET symbol to the recording.
+ *
+ * @param symbols shared_ptr to the CORESET symbols, aggregated over the CORESET duration
+ * @param metadata metadata of the chunk, stored so replays are identical
+ */
+void grid_sink::process(shared_ptr<vector<symbol>>& symbols, const frame_metadata& metadata) {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  for(auto& s : *symbols) {
+    grid_frame_header frame = {
+      .metadata = metadata,
+      .sample_index = s.sample_index,
+      .sfn = s.sfn,
+      .slot_index = s.slot_index,
+      .symbol_index = s.symbol_index,
+      .num_res = static_cast<uint32_t>(s.samples.size())
+    };
+    f.write(reinterpret_cast<char*>(&frame), sizeof(frame));
+
+    if(half_precision) {
+      half_buffer.resize(s.samples.size() * 2);
+      for(size_t i = 0; i < s.samples.size(); i++) {
+        half_buffer[2*i] = float_to_half(s.samples[i].real());
+        half_buffer[2*i+1] = float_to_half(s.samples[i].imag());
+      }
+      f.write(reinterpret_cast<char*>(half_buffer.data()), half_buffer.size() * sizeof(uint16_t));
+    } else {
+      f.write(reinterpret_cast<char*>(s.samples.data()), s.samples.size() * sizeof(complex<float>));
+    }
+  }
+
+  SPDLOG_DEBUG("Wrote {} CORESET grid frames", symbols->size());
+}
@@ -0,0 +1,137 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include "grid_source.h"
+#include "spdlog/spdlog.h"
+
+using namespace std;
+
+/**
+ * Constructor for grid_source. Reads and validates the file header.
+ *
+ * @param path path to the grid recording to read
+ */
+grid_source::grid_source(string path) :
+  f{path, ifstream::binary},
+  has_pending(false) {
+  SPDLOG_DEBUG("Opening grid_source from {}", path);
+  if(!f)
+    throw sniffer_exception("Grid recording file could not be opened");
+
+  f.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if(!f || header.magic != grid_magic)
+    throw sniffer_exception("File is not a grid recording");
+  if(header.version != grid_version)
+    throw sniffer_exception("Unsupported grid recording version");
+
+  half_precision = header.flags & grid_flag_half_precision;
+  SPDLOG_DEBUG("Grid recording of CORESET {} for cell {} ({} PRBs, duration {})", header.coreset_id, header.cell_id, header.num_prbs, header.coreset_duration);
+}
+
+/**
+ * Destructor for grid_source.
+ */
+grid_source::~grid_source() {
+  f.close();
+}
+
+/**
+ * Reads a single frame from the recording.
+ *
+ * @param s symbol to fill with the frame
+ * @param metadata set to the metadata stored with the frame
+ * @return false if there are no more complete frames
+ */
+bool grid_source::read_frame(symbol& s, frame_metadata& metadata) {
+  grid_frame_header frame;
+  if(!f.read(reinterpret_cast<char*>(&frame), sizeof(frame)))
+    return false;
+
+  s.samples.resize(frame.num_res);
+  if(half_precision) {
+    half_buffer.resize(frame.num_res * 2);
+    f.read(reinterpret_cast<char*>(half_buffer.data()), half_buffer.size() * sizeof(uint16_t));
+    for(size_t i = 0; i < frame.num_res; i++) {
+      s.samples[i] = complex<float>(half_to_float(half_buffer[2*i]), half_to_float(half_buffer[2*i+1]));
+    }
+  } else {
+    f.read(reinterpret_cast<char*>(s.samples.data()), frame.num_res * sizeof(complex<float>));
+  }
+
+  if(!f) {
+    SPDLOG_WARN("Ignoring truncated frame at the end of the grid recording");
+    return false;
+  }
+
+  s.sample_index = frame.sample_index;
+  s.sfn = frame.sfn;
+  s.slot_index = frame.slot_index;
+  s.symbol_index = frame.symbol_index;
+  s.is_equalized = false;
+  metadata = frame.metadata;
+  return true;
+}
+
+/**
+ * Produces the CORESET symbols of the next recorded chunk, i.e. all
+ * consecutive frames that were demodulated from the same buffer. Calls on_end
+ * when the recording is exhausted.
+ *
+ * @param num_symbols unused, a whole chunk is always produced
+ */
+shared_ptr<vector<symbol>> grid_source::produce_symbols(size_t num_symbols) {
+  auto symbols = make_shared<vector<symbol>>();
+
+  if(has_pending) {
+    symbols->push_back(std::move(pending));
+    produced_metadata = pending_metadata;
+    has_pending = false;
+  }
+
+  symbol s;
+  frame_metadata metadata;
+  while(read_frame(s, metadata)) {
+    if(!symbols->empty() && metadata.sample_index != produced_metadata.sample_index) {
+      pending = std::move(s);
+      pending_metadata = metadata;
+      has_pending = true;
+      return symbols;
+    }
+    produced_metadata = metadata;
+    symbols->push_back(std::move(s));
+    s = symbol();
+  }
+
+  this->on_end();
+  return symbols;
+}
+
+/**
+ * Replays the next recorded chunk to the next workers with its original
+ * metadata.
+ *
+ * @param num_samples unused, chunks are replayed as they were recorded
+ */
+void grid_source::work(size_t num_samples) {
+  auto symbols = produce_symbols(0);
+  if(symbols->size() > 0)
+    this->send_to_next_workers(symbols, produced_metadata);
+}
@@ -27,12 +27,16 @@
 #include "sniffer.h"
 #include "exceptions.h"
 #include "config.h"
+#include "metrics.h"
+#include "tracing.h"
+#include "cost_estimator.h"
 
 using namespace std;
 extern struct config config;
 
 static void usage() {
-  cout << "Usage: 5g_sniffer <path_to_config.toml>" << endl;
+  cout << "Usage: 5g_sniffer [--estimate] <path_to_config.toml>" << endl;
+  cout << "  --estimate  predict the PDCCH compute load of the config on this host, without sniffing" << endl;
 }
 
 /** 
@@ -43,6 +47,7 @@ static void usage() {
  */
 int main(int argc, char** argv) {
   string config_path;
+  bool estimate = false;
 
   #ifdef DEBUG_BUILD
     SPDLOG_INFO("=== This is a debug mode build ===");
@@ -56,6 +61,11 @@ int main(int argc, char** argv) {
   spdlog::set_pattern("[%^%l%$] [%H:%M:%S.%f thread %t] [%s:%#] %v");
 
   // Get config path from command-line args
+  if (argc > 1 && string(argv[1]) == "--estimate") {
+    estimate = true;
+    argc--;
+    argv++;
+  }
   if (argc == 1) {
     config_path = string("config.toml");
   } else if (argc == 2) {
@@ -68,13 +78,22 @@ int main(int argc, char** argv) {
   try {
     // Load the config
     config = config::load(config_path);
+    if (estimate) {
+      cost_estimator::report(config);
+      return 0;
+    }
+    auto metrics_exporter = metrics::exporter::from_config();
+    auto trace_session = tracing::session::from_config();
 
     // Create sniffer
-    if(config.file_path.compare("") == 0) {
+    if(config.grid_file_path.compare("") != 0) {
+      sniffer sniffer(config.grid_file_path);
+      sniffer.start();
+    } else if(config.file_path.compare("") == 0) {
       sniffer sniffer(config.sample_rate, config.frequency, config.rf_args, config.ssb_numerology);
       sniffer.start();  
     } else {
-      sniffer sniffer(config.sample_rate, config.file_path.data(), config.ssb_numerology);
+      sniffer sniffer(config.sample_rate, config.file_path.data(), config.ssb_numerology, config.realtime, config.follow, config.follow_timeout);
       sniffer.start();
     }
   } catch (sniffer_exception& e) {
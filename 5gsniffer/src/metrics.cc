@@ -0,0 +1,326 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include "metrics.h"
+#include "config.h"
+#include <array>
+#include <vector>
+#include <mutex>
+#include <bit>
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <spdlog/spdlog.h>
+
+extern struct config config;
+
+namespace metrics {
+  static const char* counter_names[num_counters] = {
+    "chunks_in", "samples_in", "symbols_out", "pss_found", "sync_losses", "mibs_decoded", "mibs_predicted",
+    "dmrs_candidates_al1", "dmrs_candidates_al2", "dmrs_candidates_al4", "dmrs_candidates_al8", "dmrs_candidates_al16",
+    "polar_decodes", "crc_passes", "pdcch_slots_over_budget", "pdcch_shed_correlations", "pdcch_shed_decodes"
+  };
+  static const char* stage_names[num_stages] = {
+    "sniffer_work", "syncer_process", "syncer_find_pss", "syncer_find_sss", "ofdm_process", "pdcch_process",
+    "pdcch_correlate_dmrs", "pdcch_decode"
+  };
+  static const char* gauge_names[num_gauges] = {
+    "flows_in_use", "fanout_tasks_pending", "syncer_queued_samples", "pdcch_shed_level", "pdcch_active_rntis"
+  };
+
+  /**
+   * Metrics of a single thread. Only that thread writes them, so relaxed
+   * loads and stores suffice, the atomics only make the scrape well-defined.
+   */
+  struct shard {
+    array<atomic<uint64_t>, num_counters> counters{};
+    array<array<atomic<uint64_t>, num_latency_buckets>, num_stages> latency_buckets{};
+    array<atomic<uint64_t>, num_stages> latency_sum_ns{};
+  };
+
+  /**
+   * All shards, which outlive their threads so no counts are lost.
+   */
+  struct registry {
+    mutex shards_mutex;
+    vector<shared_ptr<shard>> shards;
+    array<atomic<int64_t>, num_gauges> gauges{};
+  };
+
+  static registry& get_registry() {
+    static registry r;
+    return r;
+  }
+
+  static shard& local_shard() {
+    thread_local shared_ptr<shard> s = [] {
+      auto new_shard = make_shared<shard>();
+      registry& r = get_registry();
+      lock_guard<mutex> lock(r.shards_mutex);
+      r.shards.push_back(new_shard);
+      return new_shard;
+    }();
+    return *s;
+  }
+
+  static inline void add(atomic<uint64_t>& value, uint64_t n) {
+    value.store(value.load(memory_order_relaxed) + n, memory_order_relaxed);
+  }
+
+  /**
+   * Adds to a counter of the calling thread.
+   *
+   * @param c counter to increment
+   * @param n amount to add
+   */
+  void count(counter c, uint64_t n) {
+    add(local_shard().counters[c], n);
+  }
+
+  /**
+   * Adds a latency sample to the histogram of a stage, in the power-of-two
+   * microsecond bucket it falls in.
+   *
+   * @param s stage that took the time
+   * @param duration time the stage took
+   */
+  void record_latency(stage s, chrono::nanoseconds duration) {
+    shard& local = local_shard();
+    uint64_t ns = std::max<int64_t>(duration.count(), 0);
+    uint64_t us = (ns + 999) / 1000;
+    size_t bucket = std::min<size_t>(us <= 1 ? 0 : std::bit_width(us - 1), num_latency_buckets - 1);
+    add(local.latency_buckets[s][bucket], 1);
+    add(local.latency_sum_ns[s], ns);
+  }
+
+  /**
+   * Changes a shared gauge, e.g. by the change of a queue length.
+   *
+   * @param g gauge to change
+   * @param delta amount to add, negative to subtract
+   */
+  void add_gauge(gauge g, int64_t delta) {
+    get_registry().gauges[g].fetch_add(delta, memory_order_relaxed);
+  }
+
+  uint64_t get_counter(counter c) {
+    registry& r = get_registry();
+    lock_guard<mutex> lock(r.shards_mutex);
+    uint64_t total = 0;
+    for (auto& s : r.shards) {
+      total += s->counters[c].load(memory_order_relaxed);
+    }
+    return total;
+  }
+
+  uint64_t get_latency_count(stage st) {
+    registry& r = get_registry();
+    lock_guard<mutex> lock(r.shards_mutex);
+    uint64_t total = 0;
+    for (auto& s : r.shards) {
+      for (auto& bucket : s->latency_buckets[st]) {
+        total += bucket.load(memory_order_relaxed);
+      }
+    }
+    return total;
+  }
+
+  int64_t get_gauge(gauge g) {
+    return get_registry().gauges[g].load(memory_order_relaxed);
+  }
+
+  /**
+   * Sums the metrics of all threads into the Prometheus text format.
+   */
+  string to_prometheus() {
+    registry& r = get_registry();
+    array<uint64_t, num_counters> counters{};
+    array<array<uint64_t, num_latency_buckets>, num_stages> buckets{};
+    array<uint64_t, num_stages> sums{};
+    {
+      lock_guard<mutex> lock(r.shards_mutex);
+      for (auto& s : r.shards) {
+        for (size_t c = 0; c < num_counters; c++)
+          counters[c] += s->counters[c].load(memory_order_relaxed);
+        for (size_t st = 0; st < num_stages; st++) {
+          for (size_t b = 0; b < num_latency_buckets; b++)
+            buckets[st][b] += s->latency_buckets[st][b].load(memory_order_relaxed);
+          sums[st] += s->latency_sum_ns[st].load(memory_order_relaxed);
+        }
+      }
+    }
+
+    string out;
+    for (size_t c = 0; c < num_counters; c++) {
+      out += fmt::format("# TYPE sniffer_{}_total counter\nsniffer_{}_total {}\n", counter_names[c], counter_names[c], counters[c]);
+    }
+    for (size_t g = 0; g < num_gauges; g++) {
+      out += fmt::format("# TYPE sniffer_{} gauge\nsniffer_{} {}\n", gauge_names[g], gauge_names[g], r.gauges[g].load(memory_order_relaxed));
+    }
+    out += "# TYPE sniffer_stage_latency_seconds histogram\n";
+    for (size_t st = 0; st < num_stages; st++) {
+      uint64_t cumulative = 0;
+      for (size_t b = 0; b < num_latency_buckets; b++) {
+        cumulative += buckets[st][b];
+        string le = b == num_latency_buckets - 1 ? "+Inf" : fmt::format("{:g}", (1 << b) * 1e-6);
+        out += fmt::format("sniffer_stage_latency_seconds_bucket{{stage=\"{}\",le=\"{}\"}} {}\n", stage_names[st], le, cumulative);
+      }
+      out += fmt::format("sniffer_stage_latency_seconds_sum{{stage=\"{}\"}} {:.9f}\n", stage_names[st], sums[st] * 1e-9);
+      out += fmt::format("sniffer_stage_latency_seconds_count{{stage=\"{}\"}} {}\n", stage_names[st], cumulative);
+    }
+    return out;
+  }
+
+  /**
+   * Constructor for exporter. Failing to listen only logs a warning, as the
+   * sniffer works without.
+   *
+   * @param port local TCP port of the HTTP endpoint, 0 for any free port, -1 for none
+   * @param file_path file to write the metrics to, empty for none
+   * @param interval seconds between writes of the file
+   */
+  exporter::exporter(int port, string file_path, double interval) :
+    listen_fd(-1),
+    port(port),
+    file_path(file_path),
+    interval(interval),
+    stopping(false) {
+    if (port >= 0) {
+      listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+      int reuse = 1;
+      setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+      sockaddr_in addr = {};
+      addr.sin_family = AF_INET;
+      addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      addr.sin_port = htons(port);
+      socklen_t addr_len = sizeof(addr);
+      if (listen_fd < 0 || bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listen_fd, 4) != 0 ||
+          getsockname(listen_fd, reinterpret_cast<sockaddr*>(&addr), &addr_len) != 0) {
+        SPDLOG_WARN("Could not serve metrics on port {}: {}", port, strerror(errno));
+        if (listen_fd >= 0)
+          close(listen_fd);
+        listen_fd = -1;
+      } else {
+        this->port = ntohs(addr.sin_port);
+        SPDLOG_INFO("Serving metrics on http://127.0.0.1:{}/metrics", this->port);
+      }
+    }
+
+    if (listen_fd >= 0 || !file_path.empty())
+      t = thread(&exporter::run, this);
+  }
+
+  exporter::~exporter() {
+    stopping = true;
+    if (t.joinable())
+      t.join();
+    if (listen_fd >= 0)
+      close(listen_fd);
+  }
+
+  /**
+   * Port the HTTP endpoint listens on, useful if it was created on port 0.
+   */
+  int exporter::get_port() {
+    return listen_fd >= 0 ? port : -1;
+  }
+
+  /**
+   * Creates an exporter for metrics_port and metrics_file, or nullptr if
+   * neither is set.
+   */
+  unique_ptr<exporter> exporter::from_config() {
+    if (config.metrics_port == 0 && config.metrics_file.empty())
+      return nullptr;
+    return make_unique<exporter>(config.metrics_port == 0 ? -1 : config.metrics_port, config.metrics_file, config.metrics_interval);
+  }
+
+  void exporter::run() {
+    auto next_write = chrono::steady_clock::now();
+    while (!stopping) {
+      if (!file_path.empty() && chrono::steady_clock::now() >= next_write) {
+        write_file();
+        next_write += chrono::duration_cast<chrono::steady_clock::duration>(interval);
+      }
+
+      // Wake up regularly to notice stopping
+      pollfd fd = {listen_fd, POLLIN, 0};
+      if (listen_fd >= 0 && poll(&fd, 1, 200) > 0 && (fd.revents & POLLIN)) {
+        serve_request();
+      } else if (listen_fd < 0) {
+        this_thread::sleep_for(chrono::milliseconds(200));
+      }
+    }
+    if (!file_path.empty())
+      write_file();
+  }
+
+  /**
+   * Answers a single request with the metrics, whatever the path.
+   */
+  void exporter::serve_request() {
+    int fd = accept(listen_fd, nullptr, nullptr);
+    if (fd < 0)
+      return;
+
+    // Read, and ignore, the request so the client does not see a reset
+    char request[1024];
+    pollfd request_fd = {fd, POLLIN, 0};
+    if (poll(&request_fd, 1, 100) > 0)
+      recv(fd, request, sizeof(request), 0);
+
+    string body = to_prometheus();
+    string response = fmt::format("HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: {}\r\nConnection: close\r\n\r\n", body.size()) + body;
+    size_t sent = 0;
+    while (sent < response.size()) {
+      ssize_t n = send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+      if (n <= 0)
+        break;
+      sent += n;
+    }
+    close(fd);
+  }
+
+  /**
+   * Writes the metrics to a temporary file and renames it, so readers never
+   * see a partial file.
+   */
+  void exporter::write_file() {
+    string tmp_path = file_path + ".tmp";
+    {
+      ofstream f(tmp_path, ios::trunc);
+      f << to_prometheus();
+      if (!f) {
+        SPDLOG_WARN("Could not write metrics to {}", tmp_path);
+        return;
+      }
+    }
+    if (std::rename(tmp_path.c_str(), file_path.c_str()) != 0)
+      SPDLOG_WARN("Could not write metrics to {}: {}", file_path, strerror(errno));
+  }
+}
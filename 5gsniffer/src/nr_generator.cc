@@ -0,0 +1,348 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <cmath>
+#include <bit>
+#include <fstream>
+#include <spdlog/spdlog.h>
+#include "nr_generator.h"
+#include "exceptions.h"
+#include "phy_params_common.h"
+#include "srsran_exports.h"
+#include "pss.h"
+#include "sss.h"
+#include "pbch.h"
+#include "dmrs.h"
+#include "coreset.h"
+#include "dsp.h"
+
+namespace nr {
+  /**
+   * Creates the 15 kHz bandwidth part spanning the whole sample rate, which
+   * must fit at least the SSB.
+   */
+  static shared_ptr<bandwidth_part> make_generator_bwp(uint64_t sample_rate) {
+    if(sample_rate % subcarrier_spacing_15khz != 0 || sample_rate / subcarrier_spacing_15khz < ssb_sc)
+      throw config_exception("The generator sample rate must be a multiple of 15 kHz of at least 3.6 MHz");
+    return make_shared<bandwidth_part>(sample_rate, 0, ssb_rb);
+  }
+
+  /**
+   * Constructor for nr_generator. The [[pdcch]] configs are adjusted the same
+   * way the sniffer adjusts them, so that a config file drives both.
+   *
+   * @param sample_rate sample rate of the generated signal, a multiple of 15 kHz
+   * @param pdcch_configs CORESETs the DCIs are sent on
+   * @param cfg generator config
+   */
+  nr_generator::nr_generator(uint64_t sample_rate, vector<pdcch_config> pdcch_configs, generator_config cfg) :
+    sample_rate(sample_rate),
+    samples_per_frame(sample_rate * seconds_per_frame),
+    pdcch_configs(pdcch_configs),
+    cfg(cfg),
+    bwp(make_generator_bwp(sample_rate)),
+    modulator(bwp),
+    pbch_nr{},
+    rng(cfg.seed),
+    noise_stddev(std::sqrt(std::pow(10.0f, -(float)cfg.snr_db / 10.0f) / 2.0f)),
+    cfo_phase(1.0f, 0.0f) {
+    for(pdcch_config& pdcch_cfg : this->pdcch_configs) {
+      if(pdcch_cfg.use_config_from_mib) {
+        std::array<uint8_t, 4> coreset0_config = bwp->get_pdcch_coreset0(5, bwp->scs, bwp->scs, cfg.coreset0_idx);
+        pdcch_cfg.num_prbs = coreset0_config.at(1);
+        pdcch_cfg.coreset_duration = coreset0_config.at(2);
+        pdcch_cfg.subcarrier_offset = cfg.ssb_offset + (pdcch_cfg.num_prbs/2);
+        pdcch_cfg.numerology = 0;
+        pdcch_cfg.extended_prefix = false;
+      }
+      if(pdcch_cfg.si_dci_only)
+        pdcch_cfg.restrict_to_si_dci(cfg.cell_id);
+    }
+
+    for(const generator_dci_config& dci_cfg : cfg.dcis) {
+      const pdcch_config& pdcch_cfg = this->pdcch_configs.at(dci_cfg.pdcch);
+      if(pdcch_cfg.numerology != 0 || pdcch_cfg.extended_prefix)
+        throw config_exception("The generator only supports CORESETs with 15 kHz subcarrier spacing and normal CP");
+      if(!std::has_single_bit(dci_cfg.aggregation_level) || dci_cfg.aggregation_level > AL_16)
+        throw config_exception("Generator DCI aggregation_level must be 1, 2, 4, 8 or 16");
+      if(dci_cfg.candidate >= pdcch_cfg.num_candidates_per_AL.at(std::bit_width(dci_cfg.aggregation_level) - 1))
+        throw config_exception("Generator DCI candidate is not in the search space of its PDCCH");
+      int64_t lowest_sc = (int64_t)bwp->fft_size/2 - pdcch_cfg.num_prbs*PRB_RE/2 - pdcch_cfg.subcarrier_offset;
+      if(lowest_sc < 0 || lowest_sc + pdcch_cfg.num_prbs*PRB_RE > (int64_t)bwp->fft_size)
+        throw config_exception("Generator CORESET does not fit in the sample rate");
+      if(pdcch_cfg.coreset_ofdm_symbol_start + pdcch_cfg.coreset_duration > bwp->symbols_per_slot)
+        throw config_exception("Generator CORESET does not fit in a slot");
+    }
+
+    srsran_pbch_nr_args_t args = {};
+    args.enable_encode         = true;
+    args.enable_decode         = false;
+    if (srsran_pbch_nr_init(&pbch_nr, &args) < SRSRAN_SUCCESS)
+      throw sniffer_exception("Error init NR PBCH encoder");
+  }
+
+  /**
+   * Destructor for nr_generator.
+   */
+  nr_generator::~nr_generator() {
+    srsran_pbch_nr_free(&pbch_nr);
+  }
+
+  /**
+   * Generates one noiseless frame. The SSB is sent in slot 0 of even frames.
+   *
+   * @param sfn system frame number of the frame
+   * @param dcis DCIs sent in the frame are appended here, with sample indices relative to the frame
+   * @return time-domain samples of the frame, scaled so that snr_db is the SNR per resource element once impair adds noise
+   */
+  vector<complex<float>> nr_generator::modulate_frame(uint16_t sfn, vector<generated_dci>& dcis) {
+    vector<complex<float>> frame;
+    frame.reserve(samples_per_frame);
+
+    for(uint8_t slot_index = 0; slot_index < bwp->slots_per_frame; slot_index++) {
+      vector<symbol> slot(bwp->symbols_per_slot);
+      for(uint8_t symbol_index = 0; symbol_index < slot.size(); symbol_index++) {
+        slot[symbol_index].samples.assign(bwp->fft_size, 0);
+        slot[symbol_index].symbol_index = symbol_index;
+        slot[symbol_index].slot_index = slot_index;
+        slot[symbol_index].sfn = sfn;
+      }
+
+      bool ssb_slot = slot_index == 0 && sfn % 2 == 0;
+      if(ssb_slot)
+        map_ssb(slot, sfn);
+
+      uint64_t slot_count = (uint64_t)sfn * bwp->slots_per_frame + slot_index;
+      for(const generator_dci_config& dci_cfg : cfg.dcis) {
+        if(slot_count % dci_cfg.slot_period != dci_cfg.slot_offset)
+          continue;
+        const pdcch_config& pdcch_cfg = pdcch_configs.at(dci_cfg.pdcch);
+        // Symbols 2 to 5 carry the SSB
+        if(ssb_slot && pdcch_cfg.coreset_ofdm_symbol_start < 6 && pdcch_cfg.coreset_ofdm_symbol_start + pdcch_cfg.coreset_duration > 2) {
+          SPDLOG_DEBUG("Skipping DCI for RNTI {} overlapping the SSB in SFN {}", dci_cfg.rnti, sfn);
+          continue;
+        }
+
+        generated_dci dci;
+        dci.sample_index = frame.size();
+        for(uint8_t symbol_index = 0; symbol_index < pdcch_cfg.coreset_ofdm_symbol_start; symbol_index++)
+          dci.sample_index += bwp->samples_per_symbol(symbol_index);
+        dci.sfn = sfn;
+        dci.slot_index = slot_index;
+        map_dci(slot, slot_index, dci_cfg, dci);
+        dcis.push_back(std::move(dci));
+      }
+
+      auto samples = modulator.modulate(slot);
+      frame.insert(frame.end(), samples.begin(), samples.end());
+    }
+
+    float scale = 1.0f / std::sqrt((float)bwp->fft_size);
+    for(auto& sample : frame)
+      sample *= scale;
+    return frame;
+  }
+
+  /**
+   * Maps the SSB of the cell to symbols 2 to 5 of a slot, centered at DC.
+   */
+  void nr_generator::map_ssb(vector<symbol>& slot, uint16_t sfn) {
+    uint16_t cell_id = cfg.cell_id;
+    size_t first_sc = bwp->fft_size/2 - ssb_sc/2;
+    vector<complex<float>> ssb_grid(ssb_sc * 4, 0);
+
+    // PSS and SSS on subcarriers 56 to 182 of the first and third SSB symbols
+    pss pss_(cell_id % 3);
+    auto pss_seq = pss_.get_pss_seq_f();
+    std::copy(pss_seq.begin(), pss_seq.end(), ssb_grid.begin() + 56);
+    sss sss_;
+    auto sss_seq = sss_.generate_sss_seq(cell_id / 3, cell_id % 3);
+    std::copy(sss_seq.begin(), sss_seq.end(), ssb_grid.begin() + 2*ssb_sc + 56);
+
+    // PBCH, with the same parameters the sniffer decodes it with
+    srsran_mib_nr_t mib = {};
+    mib.sfn = sfn;
+    mib.ssb_idx = 0;
+    mib.hrf = false;
+    mib.scs_common = srsran_subcarrier_spacing_15kHz;
+    mib.ssb_offset = cfg.ssb_offset;
+    mib.dmrs_typeA_pos = cfg.dmrs_typeA_pos ? srsran_dmrs_sch_typeA_pos_3 : srsran_dmrs_sch_typeA_pos_2;
+    mib.coreset0_idx = cfg.coreset0_idx;
+    mib.ss0_idx = cfg.ss0_idx;
+    srsran_pbch_msg_nr_t msg = {};
+    srsran_pbch_msg_nr_mib_pack(&mib, &msg);
+
+    srsran_pbch_nr_cfg_t pbch_cfg = {};
+    pbch_cfg.N_id = cell_id;
+    pbch_cfg.n_hf = 0;
+    pbch_cfg.ssb_idx = 0;
+    pbch_cfg.Lmax = 8;
+    pbch_cfg.beta = 1.0f;
+    vector<complex<float>> pbch_grid(ssb_sc * 4, 0);
+    if (srsran_pbch_nr_encode(&pbch_nr, &pbch_cfg, &msg, (cf_t*)pbch_grid.data()) < SRSRAN_SUCCESS)
+      throw sniffer_exception("Error encoding PBCH");
+    for(size_t i = 0; i < ssb_grid.size(); i++)
+      ssb_grid[i] += pbch_grid[i];
+
+    // PBCH DMRS
+    dmrs dmrs_pbch;
+    auto dmrs_symbols = dmrs_pbch.generate_pbch_dmrs_symb(0, 0, cell_id);
+    auto next = dmrs_symbols.begin();
+    for(uint8_t symbol_index = 1; symbol_index <= 3; symbol_index++) {
+      for(auto dmrs_index : pbch::get_dmrs_indices(symbol_index, cell_id))
+        ssb_grid[symbol_index*ssb_sc + dmrs_index] = *next++;
+    }
+
+    for(uint8_t symbol_index = 0; symbol_index < 4; symbol_index++) {
+      std::copy(ssb_grid.begin() + symbol_index*ssb_sc, ssb_grid.begin() + (symbol_index + 1)*ssb_sc, slot.at(2 + symbol_index).samples.begin() + first_sc);
+    }
+  }
+
+  /**
+   * Encodes a random DCI payload and maps it with its DMRS to the candidate
+   * of the CORESET. The CORESET is centered subcarrier_offset subcarriers
+   * below DC, as the sniffer rotates it up by that much before demodulating.
+   */
+  void nr_generator::map_dci(vector<symbol>& slot, uint8_t slot_index, const generator_dci_config& dci_cfg, generated_dci& dci) {
+    const pdcch_config& pdcch_cfg = pdcch_configs.at(dci_cfg.pdcch);
+    nr::pdcch& pdcch = get_pdcch(dci_cfg.pdcch, dci_cfg.scrambling_id);
+
+    dci.symbol_index = pdcch_cfg.coreset_ofdm_symbol_start;
+    dci.pdcch = dci_cfg.pdcch;
+    dci.rnti = dci_cfg.rnti;
+    dci.scrambling_id = dci_cfg.scrambling_id;
+    dci.aggregation_level = dci_cfg.aggregation_level;
+    dci.candidate = dci_cfg.candidate;
+    dci.payload.resize(dci_cfg.dci_size);
+    for(auto& bit : dci.payload)
+      bit = rng() & 1;
+
+    auto data_symbols = pdcch.encode_pdcch(dci.payload, dci.rnti, dci.scrambling_id, dci.aggregation_level);
+
+    std::string key = std::to_string(dci.scrambling_id) + std::to_string(std::bit_width(dci.aggregation_level) - 1) + std::to_string(slot_index) + std::to_string(dci.candidate);
+    const auto& data_indices = pdcch.data_sc_indices_table.at(key);
+    const auto& dmrs_indices = pdcch.dmrs_sc_indices_table.at(key);
+    const auto& dmrs_symbols = pdcch.dmrs_seq_table.at(key);
+
+    // Indices run over the subcarriers of the CORESET symbols one after another
+    uint64_t coreset_sc = pdcch_cfg.num_prbs * PRB_RE;
+    uint64_t first_sc = bwp->fft_size/2 - coreset_sc/2 - pdcch_cfg.subcarrier_offset;
+    auto put = [&](uint64_t index, complex<float> value) {
+      slot.at(dci.symbol_index + index / coreset_sc).samples.at(first_sc + index % coreset_sc) = value;
+    };
+    for(size_t i = 0; i < data_indices.size(); i++)
+      put(data_indices[i], data_symbols.at(i));
+    for(size_t i = 0; i < dmrs_indices.size(); i++)
+      put(dmrs_indices[i], dmrs_symbols.at(i));
+  }
+
+  /**
+   * Returns the PDCCH holding the DMRS tables and encoder of a CORESET for one
+   * scrambling ID, building it on first use.
+   */
+  nr::pdcch& nr_generator::get_pdcch(size_t pdcch_index, uint16_t scrambling_id) {
+    auto& entry = pdcchs[{pdcch_index, scrambling_id}];
+    if(!entry) {
+      const pdcch_config& pdcch_cfg = pdcch_configs.at(pdcch_index);
+      entry = make_unique<nr::pdcch>();
+      entry->scrambling_id_start = scrambling_id;
+      entry->scrambling_id_end = scrambling_id;
+      entry->set_coreset_info(coreset(pdcch_cfg.coreset_id,
+                                      pdcch_cfg.num_prbs,
+                                      pdcch_cfg.coreset_duration,
+                                      pdcch_cfg.coreset_interleaving_pattern,
+                                      pdcch_cfg.coreset_reg_bundle_size,
+                                      pdcch_cfg.coreset_interleaver_size,
+                                      pdcch_cfg.coreset_nshift,
+                                      cfg.cell_id,
+                                      pdcch_cfg.coreset_ofdm_symbol_start,
+                                      bwp->symbols_per_slot,
+                                      bwp->slots_per_frame,
+                                      pdcch_cfg.num_candidates_per_AL));
+      entry->initialize_dmrs_seq();
+    }
+    return *entry;
+  }
+
+  /**
+   * Applies the configured CFO and adds white Gaussian noise in place. The
+   * CFO phase carries over from one call to the next.
+   */
+  void nr_generator::impair(vector<complex<float>>& samples) {
+    if(cfg.cfo != 0.0)
+      rotate(samples, samples, cfg.cfo, sample_rate, cfo_phase);
+
+    normal_distribution<float> noise(0.0f, noise_stddev);
+    for(auto& sample : samples)
+      sample += complex<float>(noise(rng), noise(rng));
+  }
+
+  /**
+   * Writes duration seconds of impaired signal, preceded by timing_offset
+   * noise-only samples, and the list of DCIs it carries.
+   *
+   * @param output_path IQ file, interleaved 32-bit float I/Q as read by the sniffer
+   * @param truth_path CSV file with one line per DCI
+   * @return number of samples written
+   */
+  uint64_t nr_generator::write(const string& output_path, const string& truth_path) {
+    ofstream iq(output_path, ios::binary);
+    if(!iq)
+      throw sniffer_exception("Could not open generator output " + output_path);
+    ofstream truth(truth_path);
+    if(!truth)
+      throw sniffer_exception("Could not open generator ground truth " + truth_path);
+    truth << "sample_index,sfn,slot,symbol,pdcch,rnti,scrambling_id,aggregation_level,candidate,dci_size,payload\n";
+
+    auto write_samples = [&](const vector<complex<float>>& samples) {
+      iq.write(reinterpret_cast<const char*>(samples.data()), samples.size() * sizeof(complex<float>));
+    };
+
+    vector<complex<float>> leading_noise(cfg.timing_offset, 0);
+    impair(leading_noise);
+    write_samples(leading_noise);
+    uint64_t num_samples = leading_noise.size();
+
+    uint64_t num_frames = std::ceil(cfg.duration / seconds_per_frame);
+    uint64_t num_dcis = 0;
+    for(uint64_t frame_index = 0; frame_index < num_frames; frame_index++) {
+      uint16_t sfn = (cfg.sfn_start + frame_index) % frames_per_hyperframe;
+      vector<generated_dci> dcis;
+      auto frame = modulate_frame(sfn, dcis);
+      impair(frame);
+      write_samples(frame);
+
+      for(const generated_dci& dci : dcis) {
+        string payload;
+        for(auto bit : dci.payload)
+          payload += bit ? '1' : '0';
+        truth << num_samples + dci.sample_index << "," << dci.sfn << "," << (int)dci.slot_index << "," << (int)dci.symbol_index << ","
+              << dci.pdcch << "," << dci.rnti << "," << dci.scrambling_id << "," << (int)dci.aggregation_level << ","
+              << (int)dci.candidate << "," << dci.payload.size() << "," << payload << "\n";
+      }
+      num_samples += frame.size();
+      num_dcis += dcis.size();
+    }
+
+    SPDLOG_INFO("Generated {} frames ({} samples) with {} DCIs for cell ID {}", num_frames, num_samples, num_dcis, cfg.cell_id);
+    return num_samples;
+  }
+}
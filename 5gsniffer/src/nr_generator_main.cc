@@ -0,0 +1,78 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <iostream>
+#include <cstdlib>
+
+#include "spdlog/spdlog.h"
+#include "spdlog/cfg/env.h"
+#include "nr_generator.h"
+#include "exceptions.h"
+#include "config.h"
+
+using namespace std;
+extern struct config config;
+
+static void usage() {
+  cout << "Usage: 5g_nr_generator <path_to_config.toml>" << endl;
+}
+
+/** 
+ * Main function of the synthetic NR downlink generator. Writes the IQ file
+ * and ground truth described by the [generator] table of the config, using
+ * the same [[pdcch]] configs as the sniffer.
+ *
+ * @param argc 
+ * @param argv 
+ */
+int main(int argc, char** argv) {
+  string config_path;
+
+  spdlog::cfg::load_env_levels();
+  spdlog::set_pattern("[%^%l%$] [%H:%M:%S.%f thread %t] [%s:%#] %v");
+
+  if (argc == 1) {
+    config_path = string("config.toml");
+  } else if (argc == 2) {
+    config_path = string(argv[1]);
+  } else {
+    usage();
+    exit(1);
+  }
+
+  try {
+    config = config::load(config_path);
+    if(config.generator.output_path.empty())
+      throw config_exception("Set [generator] output_path to generate a signal");
+
+    nr::nr_generator generator(config.sample_rate, config.pdcch_configs, config.generator);
+    generator.write(config.generator.output_path, config.generator.truth_path);
+    SPDLOG_INFO("Wrote {} and {}", config.generator.output_path, config.generator.truth_path);
+  } catch (sniffer_exception& e) {
+    SPDLOG_ERROR(e.what());
+    return 1;
+  } catch (const toml::parse_error& err) {
+    std::cerr << "Error parsing configuration file '" << *err.source().path << "':\n" << err.description() << "\n  (" << err.source().begin << ")\n";
+    return 1;
+  }
+
+  return 0;
+}
@@ -27,15 +27,17 @@
 #include "ofdm.h"
 #include "utils.h"
 #include "symbol.h"
+#include "metrics.h"
+#include "tracing.h"
 
 /** 
  * Constructor for ofdm.
  */
 ofdm::ofdm(shared_ptr<bandwidth_part> bwp, float cyclic_prefix_fraction) :
   cyclic_prefix_fraction(cyclic_prefix_fraction),
-  samples_processed(0),
   symbol_index(0),
-  slot_index(0) {
+  slot_index(0),
+  sfn(0) {
   this->bwp = bwp;
   leftover_samples.reserve((bwp->samples_per_symbol(1)) - 1); // Worst case scenario, almost 1 symbol with extended CP
   SPDLOG_DEBUG("Creating OFDM block with nfft={}", bwp->fft_size);
@@ -55,9 +57,11 @@ ofdm::~ofdm() {
 //  * Transform samples into OFDM symbols. More efficient implementation. Does not support fractional CP removal.
 //  *
 //  * @param samples shared_ptr to sample buffer to process
-//  * @param metadata for future work
+//  * @param metadata description of the first sample, used to stamp each symbol with its absolute sample index
 //  */
-void ofdm::process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata) {
+void ofdm::process(shared_ptr<vector<complex<float>>>& samples, const frame_metadata& metadata) {
+  metrics::stage_timer timer(metrics::ofdm_process);
+  tracing::trace_scope trace("ofdm::process");
   SPDLOG_DEBUG("Starting OFDM demodulation");
 
   vector<symbol> produced_symbols;
@@ -76,6 +80,7 @@ void ofdm::process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata
   while (samples->size() - symbol_ctr >= bwp->samples_per_symbol(symbol_index)) {
     // Keep track of OFDM symbol start, and copy new symbol
     int curr_position = symbol_ctr + bwp->samples_per_cp(symbol_index);
+    int64_t symbol_start = leftover_samples.size() > 0 ? -num_leftover_samp : symbol_ctr; // Relative to the first sample of this buffer
     vector<complex<float>> symbol_fft;
     symbol_fft.reserve(bwp->num_subcarriers);
 
@@ -96,10 +101,11 @@ void ofdm::process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata
 
     // Create symbol class and add to vector
     symbol s;
-    s.sample_index = this->samples_processed;
+    s.sample_index = metadata.sample_index + symbol_start;
     s.samples = std::move(symbol_fft);
     s.symbol_index = symbol_index;
     s.slot_index = slot_index;
+    s.sfn = sfn;
     produced_symbols.push_back(std::move(s));
 
     // Counter for OFDM symbol and slot number
@@ -108,11 +114,10 @@ void ofdm::process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata
     symbol_index += 1;
     if(symbol_index == bwp->symbols_per_slot) {
       slot_index = (slot_index + 1) % bwp->slots_per_frame;
+      if(slot_index == 0)
+        sfn = (sfn + 1) % frames_per_hyperframe;
     }
     symbol_index %= bwp->symbols_per_slot;
-
-    // Keep track of the total number of samples processed.
-    samples_processed += bwp->samples_per_symbol(symbol_index);
   }
   
   // Keeping leftover samples for next input
@@ -120,6 +125,7 @@ void ofdm::process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata
   leftover_samples.resize((*samples).size() - symbol_ctr);
   // Pass produced symbols on to symbol workers
   fft_destroy_plan(q);
+  metrics::count(metrics::symbols_out, produced_symbols.size());
 
   if (produced_symbols.size() > 0)
     send_to_next_workers(make_shared<vector<symbol>>(std::move(produced_symbols)), metadata);
@@ -29,45 +29,64 @@
 
 namespace nr {
   /** 
-  * Constructor for pbch.
+  * Constructor for pbch. The srsRAN PBCH decoder is set up once here and
+  * reused for every SSB.
   */
-  pbch::pbch(shared_ptr<nr::phy> phy) {
+  pbch::pbch(shared_ptr<nr::phy> phy) :
+    pbch_nr{},
+    pbch_nr_initialized(false) {
     this->phy = phy;
+
+    srsran_pbch_nr_args_t args = {};
+    args.enable_encode         = false;
+    args.enable_decode         = true;
+    args.disable_simd          = false;
+    if (srsran_pbch_nr_init(&pbch_nr, &args) < SRSRAN_SUCCESS) {
+      SPDLOG_ERROR("Error init NR PBCH");
+    } else {
+      pbch_nr_initialized = true;
+    }
+    pbch_symbols.reserve(PBCH_NR_M);
   }
 
   /** 
   * Destructor for pbch.
   */
   pbch::~pbch() {
-
+    if (pbch_nr_initialized)
+      srsran_pbch_nr_free(&pbch_nr);
   }
 
   /** 
-  * Initializes all PBCH DMRS sequences
+  * Initializes all PBCH DMRS sequences and subcarrier indices for the current
+  * cell ID. Does nothing if they were already built for this cell ID.
   */
   void pbch::initialize_dmrs_seq(){
-    // Find ibar_ssb
+    uint16_t cell_id = phy->get_cell_id();
+    if (table_cell_id == cell_id)
+      return;
+
+    for(uint8_t symbol_index = 1; symbol_index <= 3; symbol_index++) {
+      dmrs_sc_indices_table[symbol_index - 1] = pbch::get_dmrs_indices(symbol_index, cell_id);
+      data_sc_indices_table[symbol_index - 1] = pbch::get_data_indices(symbol_index, cell_id);
+    }
+
     dmrs tmp;
     for(uint8_t i_ssb = 0; i_ssb <= 4; i_ssb++) {
       for(uint8_t n_hf = 0; n_hf <= 1; n_hf++) {
-        auto dmrs_reference_all = tmp.generate_pbch_dmrs_symb(i_ssb, n_hf, phy->get_cell_id());
-        uint64_t count = 0;
+        auto dmrs_reference_all = tmp.generate_pbch_dmrs_symb(i_ssb, n_hf, cell_id);
+        auto next = dmrs_reference_all.begin();
         for(uint8_t symbol_index = 1; symbol_index <= 3; symbol_index++) {
-          // Get DMRS indices
-          auto dmrs_indices = pbch::get_dmrs_indices(symbol_index, phy->get_cell_id());
           // Get subset of the DMRS sequence for corresponding to the current symbol
-          vector<complex<float>> dmrs_reference;
-          dmrs_reference.reserve(60);
-          for(uint64_t i = 0; i < dmrs_indices.size(); i++) {
-            dmrs_reference.push_back(dmrs_reference_all.at(count));
-            count += 1;
-          }
-          std::string key = std::to_string(symbol_index) + std::to_string(i_ssb) + std::to_string(n_hf);      
-          this->dmrs_seq_table.emplace(key, dmrs_reference);
-          this->dmrs_sc_indices_table.emplace(key, dmrs_indices);
+          auto count = dmrs_sc_indices_table[symbol_index - 1].size();
+          dmrs_seq_table[i_ssb][n_hf][symbol_index - 1].assign(next, next + count);
+          next += count;
         }
       }
     }
+
+    table_cell_id = cell_id;
+    SPDLOG_DEBUG("Built PBCH DMRS tables for cell id {}", cell_id);
   }
 
   /** 
@@ -75,18 +94,9 @@ namespace nr {
   * TODO clean this up and ultimately remove srsRAN dependency.
   */
   void pbch::decode(vector<complex<float>>& soft_symbols) {
-    srsran_ssb_t ssb = {};
-    
-    srsran_pbch_nr_args_t args = {};
-    args.enable_encode         = false;
-    args.enable_decode         = true;
-    args.disable_simd          = false;
-    srsran_pbch_nr_t* q = &ssb.pbch;
-
-    if (srsran_pbch_nr_init(q, &args) < SRSRAN_SUCCESS) {
-      ERROR("Error init NR PBCH");
+    if (!pbch_nr_initialized)
       return;
-    }
+    srsran_pbch_nr_t* q = &pbch_nr;
 
     srsran_pbch_nr_cfg_t cfg = {};
     srsran_pbch_msg_nr_t msg = {};
@@ -145,15 +155,14 @@ namespace nr {
       srsran_mib_nr_t mib = {};
       this->on_mib_found(mib,false);
     }
-
-    srsran_pbch_nr_free(q);
   }
 
   /** 
   * Demodulate the PBCH symbols.
   */
-  void pbch::process(shared_ptr<vector<symbol>>& symbols, int64_t metadata) {
+  void pbch::process(shared_ptr<vector<symbol>>& symbols, const frame_metadata& metadata) {
     SPDLOG_DEBUG("Processing PBCH symbols for cell id {}", phy->get_cell_id());
+    initialize_dmrs_seq();
     uint8_t best_i_ssb = 0;
     uint8_t best_n_hf = 0;
     float best_snr = -1000.0;
@@ -183,10 +192,9 @@ namespace nr {
 
 
     // Collect the PBCH data symbols
-    vector<complex<float>> pbch_symbols;
+    pbch_symbols.clear();
     for(uint8_t symbol_index = 1; symbol_index <= 3; symbol_index++) {
-      auto data_indices = pbch::get_data_indices(symbol_index, phy->get_cell_id());
-      for(auto data_index : data_indices) {
+      for(auto data_index : data_sc_indices_table[symbol_index - 1]) {
         pbch_symbols.push_back(symbols->at(symbol_index).samples_eq[data_index]);
       }
     }
@@ -198,14 +206,16 @@ namespace nr {
   }
 
   /** 
-  * Channel estimate on a copy of symbols and return the obtained SNR.
+  * Channel estimate the symbols in place and return the obtained SNR. Only the
+  * estimate of the symbols changes, not their samples, so hypotheses can be
+  * tried one after another on the same symbols without copying them.
   *
   * @param i_ssb SSB index
   * @param n_hf Half-frame
-  * @param symbols Symbol vector to copy
+  * @param symbols Symbol vector to estimate
   * @return SNR after channel estimation with the specified parameters
   */
-  float pbch::get_ibar_ssb_snr(uint8_t i_ssb, uint8_t n_hf, vector<symbol> symbols) {
+  float pbch::get_ibar_ssb_snr(uint8_t i_ssb, uint8_t n_hf, vector<symbol>& symbols) {
     return channel_estimate(i_ssb, n_hf, symbols);
   }
 
@@ -214,7 +224,7 @@ namespace nr {
   *
   * @param i_ssb SSB index
   * @param n_hf Half-frame
-  * @param symbols Symbol vector to copy
+  * @param symbols Symbol vector to estimate
   * @return SNR after channel estimation with the specified parameters
   */
   float pbch::channel_estimate(uint8_t i_ssb, uint8_t n_hf, vector<symbol>& symbols) {
@@ -224,10 +234,8 @@ namespace nr {
 
     for(uint8_t symbol_index = 1; symbol_index <= 3; symbol_index++) {
       // Get DMRS indices and sequence per symbol
-      std::string key = std::to_string(symbol_index) + std::to_string(i_ssb) + std::to_string(n_hf);
-      
-      auto dmrs_indices = dmrs_sc_indices_table[key];
-      auto dmrs_reference = dmrs_seq_table[key];
+      const auto& dmrs_indices = dmrs_sc_indices_table[symbol_index - 1];
+      const auto& dmrs_reference = dmrs_seq_table[i_ssb][n_hf][symbol_index - 1];
 
       // Get signal power
       // float signal_power = pow(symbols.at(symbol_index).get_average_magnitude(), 2);
@@ -23,15 +23,17 @@
 #include "coreset.h"
 #include "dsp.h"
 #include "utils.h"
+#include "metrics.h"
+#include "tracing.h"
+#include "exceptions.h"
 #include <cstdint>
 #include <spdlog/spdlog.h>
 #include <string>
+#include <bit>
 #include <numeric>
 #include <execution>
 #include <unordered_map>
 
-std::binary_semaphore rnti_list_mutex(1);
-
 namespace nr {
   pdcch::pdcch(){
     RNTI = 0;
@@ -44,7 +46,7 @@ namespace nr {
     sc_power_decision = false;
     max_rnti_queue_size = 65535;
     AL_corr_thresholds = {0.9, 0.8, 0.7, 0.15, 0.15};
-    found_RNTI_list.reserve(1<<15);
+    learned_rntis_only = false;
   }
 
   pdcch::pdcch(uint16_t RNTI_, coreset coreset_info_) : pdcch() {
@@ -122,51 +124,85 @@ namespace nr {
 
   // We initialize the list of RNTI with no specific order, just ascending RNTIs
   void pdcch::initialize_RNTI_list(){
-    for (int i = rnti_start; i<=rnti_end; i++ ){
-      found_RNTI_list.push_back(i);
-    }
+    rnti_list.assign(rnti_start, rnti_end);
     SPDLOG_DEBUG("Initialized RNTI list between {} and {}", rnti_start, rnti_end);
   }
 
-  // Once we find an RNTI, we reorder the list of RNTIs to put that RNTI first in the vector.
+  // Once we find an RNTI, we move it to the front of the list of RNTIs. False if it is not in the list, which might happen for SI-RNTI, 65535.
   bool pdcch::update_RNTI_list(uint16_t found_RNTI){
-    bool rnti_in_list = false;
-
-    rnti_list_mutex.acquire();
-    std::vector<uint16_t>::iterator position = std::find(found_RNTI_list.begin(), found_RNTI_list.end(), found_RNTI);
-    if (position != found_RNTI_list.end()){ // element not found, this might happen for SI-RNTI, 65535.
-      found_RNTI_list.erase(position);
-      found_RNTI_list.insert(found_RNTI_list.begin(), found_RNTI);
-      rnti_in_list = true;
-    }
-    rnti_list_mutex.release();
-    
-    return rnti_in_list;
+    return rnti_list.promote(found_RNTI);
+  }
+
+  /**
+   * Number of RNTIs from the front of the RNTI list decoded at AL 1 to 4. With
+   * an active RNTI table, only the active RNTIs of the list are: as found RNTIs are moved
+   * to the front, they are the front of the list. RNTIs that are not active
+   * yet are found at AL 8 and 16 by the repetition optimization, which scans
+   * the whole list, so the table only limits ranges that are searched that way.
+   */
+  int pdcch::get_rnti_list_length(){
+    if (active_rntis && rnti_start < 65520 && rnti_end > 100)
+      return std::min<int64_t>(rnti_list_length, active_rntis->listed_size());
+    return rnti_list_length;
+  }
+
+  // Time of the symbol, from the timestamp of the buffer it was demodulated from
+  double pdcch::get_symbol_time(const symbol& symbol, const frame_metadata& metadata){
+    return (metadata.timestamp_ns + (double)((int64_t)symbol.sample_index - metadata.sample_index) * 1e9 / sample_rate_time) / 1e9;
   }
 
   /* Look for DCIs across the whole PDCCH region. CORESET duration indicates how many OFDM symbols contain 
   PDCCH and starting OFDM symbol in CORESET indicates where does the PDCCH region start within a slot.
   The DMRS Sequence depends on the OFDM symbol, slot number, scramblingID,  and number of symbols per slot */
 
-  void pdcch::process(shared_ptr<vector<symbol>>& symbols, int64_t metadata) {
+  void pdcch::process(shared_ptr<vector<symbol>>& symbols, const frame_metadata& metadata) {
     coreset_info.set_num_symbols_per_slot(14);
     srsran_pdcch_nr_res_t res        = {};
 
     bool user_search_space = false;
     bool found_possible_dci = false;
-    int symbol_in_chunk = 0;
+
+    // Number of RNTIs to decode, once the deadline scheduler shed the cold ones
+    auto shed_rntis = [this](size_t num_rntis) {
+      if (!scheduler)
+        return num_rntis;
+      size_t limit = scheduler->rnti_limit(num_rntis);
+      if (limit < num_rntis)
+        metrics::count(metrics::shed_decodes, num_rntis - limit);
+      return limit;
+    };
+
     for (symbol& symbol: *symbols) {
-      symbol_in_chunk++;
       auto process_symbol_time = time_profile_start();
+      auto slot_start = chrono::steady_clock::now();
+      metrics::stage_timer process_symbol_timer(metrics::pdcch_process);
     
       std::vector<dci> found_dci_list;
 
       auto correlate_dmrs_t0 = time_profile_start();
-      found_possible_dci = correlate_DMRS(symbol, found_dci_list);
+      {
+        metrics::stage_timer correlate_dmrs_timer(metrics::pdcch_correlate_dmrs);
+        found_possible_dci = correlate_DMRS(symbol, found_dci_list);
+      }
+      for (dci& candidate : found_dci_list) {
+        metrics::count((metrics::counter)(metrics::dmrs_candidates_al1 + std::bit_width((unsigned)candidate.get_found_aggregation_level()) - 1));
+      }
 
       time_profile_end(correlate_dmrs_t0, "pdcch::correlate_DMRS (correlations for one symbol)");
 
+      if (active_rntis) {
+        double symbol_time = get_symbol_time(symbol, metadata);
+        for (uint16_t rnti : active_rntis->expire(symbol_time)) {
+          SPDLOG_INFO("RNTI {} expired at {:.6f} s, no longer decoded below AL 8", rnti, symbol_time);
+          // A new RRC connection with the RNTI may use another scrambling ID
+          learned_scrambling_ids.forget(rnti);
+        }
+        active_rntis->request_write(symbol_time);
+      }
+
       if (found_possible_dci) {
+        // Snapshot of the RNTI order, which other flows may change while this symbol is decoded
+        auto rntis = rnti_list.get_snapshot();
         srsran_pdcch_nr_res_t res = {};
         dci aux_dci;
         uint8_t dci_size;
@@ -188,6 +224,7 @@ namespace nr {
               // The dci size will determine which ALs will have repetition, with K, E and N variables.
               // If the rate matched output is longer than the data, there will be repetition. In this case, we can infer the RNTI without decoding. 
               auto decode_pdcch_t0 = time_profile_start();
+              metrics::stage_timer decode_pdcch_timer(metrics::pdcch_decode);
     
               bool found_dci_ = false;
               if (AL>3 ){
@@ -195,12 +232,13 @@ namespace nr {
                 // SI or RA
                 if (rnti_start < 65520 & rnti_end > 100){
                   aux_dci.set_rnti(0);
-                  outp = decode_pdcch(symbol, equalized_symbols, aux_dci, &res, true, metadata, symbol_in_chunk);  
+                  outp = decode_pdcch(symbol, equalized_symbols, aux_dci, &res, true, metadata);  
                 }else{
-                  for (int rnti_i = 0; rnti_i < (int)found_RNTI_list.size(); rnti_i++){
-                    auto rnti = found_RNTI_list.at(rnti_i);
+                  int num_rntis = shed_rntis(rntis->size());
+                  for (int rnti_i = 0; rnti_i < num_rntis; rnti_i++){
+                    auto rnti = rntis->at(rnti_i);
                     aux_dci.set_rnti(rnti);
-                    outp = decode_pdcch(symbol, equalized_symbols, aux_dci, &res, true, metadata, symbol_in_chunk);
+                    outp = decode_pdcch(symbol, equalized_symbols, aux_dci, &res, true, metadata);
                   }
                 }     
                 if (outp == 1 && (aux_dci.get_found_aggregation_level() > 1)){
@@ -213,10 +251,9 @@ namespace nr {
                 // int rnti_list_length = 100;
                 // if (AL<=3)
                 //   rnti_list_length = max_rnti_queue_size;
-                for (int rnti_i = 0; rnti_i < std::min(rnti_list_length,(int)found_RNTI_list.size()); rnti_i++){
-                  auto rnti = found_RNTI_list.at(rnti_i);
+                auto try_rnti = [&](uint16_t rnti){
                   aux_dci.set_rnti(rnti);
-                  int outp = decode_pdcch(symbol, equalized_symbols, aux_dci, &res, false, metadata, symbol_in_chunk);
+                  int outp = decode_pdcch(symbol, equalized_symbols, aux_dci, &res, false, metadata);
                   // If the decoding succeeds, delete from the list of Possible DCIs the ones that that have a lower AL and correspond to the DCI just decoded.
                   // To check this, we check that its the same scrambling_id, slot number, and symbol index, and the candidate_idx is a subset of the decoded candidate
                   // Also, break after finding a correct RNTI, no need to explore the same DCI for other RNTIs or dci sizes.
@@ -225,13 +262,41 @@ namespace nr {
                     SPDLOG_DEBUG("deleted {} DCIs", deleted_dcis);
                     // Do not look for more RNTIs in this found_DCI
                     found_dci_ = true; // Flag to break also dci_size.
-                    break;
                   }
+                  return found_dci_;
+                };
+
+                // The RNTIs learned with the scrambling ID of the candidate are the most likely, try them first
+                auto learned_rntis = learned_scrambling_ids.get_rntis(aux_dci.get_pdcch_scrambling_id());
+                int num_listed = 0;
+                if (!(learned_rntis_only && !learned_rntis->rntis.empty()))
+                  num_listed = std::min(get_rnti_list_length(),(int)rntis->size());
+
+                // The deadline scheduler limits the learned and listed RNTIs together, learned ones first
+                size_t num_rntis = learned_rntis->rntis.size();
+                for (int rnti_i = 0; rnti_i < num_listed; rnti_i++){
+                  if (!learned_rntis->contains(rntis->at(rnti_i)))
+                    num_rntis++;
+                }
+                num_rntis = shed_rntis(num_rntis);
+
+                size_t num_tried = 0;
+                for (size_t rnti_i = 0; rnti_i < learned_rntis->rntis.size() && num_tried < num_rntis; rnti_i++){
+                  num_tried++;
+                  if (try_rnti(learned_rntis->rntis.at(rnti_i)))
+                    break;
+                }
+                for (int rnti_i = 0; !found_dci_ && rnti_i < num_listed && num_tried < num_rntis; rnti_i++){
+                  auto rnti = rntis->at(rnti_i);
+                  if (learned_rntis->contains(rnti))
+                    continue;
+                  num_tried++;
+                  if (try_rnti(rnti))
+                    break;
                 }
               }
 
-              string decode_pdcch_profile_msg = "pdcch::decode_pdcch (decode of " + to_string(found_RNTI_list.size()) + " RNTIs)";
-              time_profile_end(decode_pdcch_t0, decode_pdcch_profile_msg);
+              time_profile_end(decode_pdcch_t0, "pdcch::decode_pdcch (decode of all RNTIs)");
 
               // Do not look for more DCI sizes in this found_DCI if one was already found
               if (found_dci_)
@@ -244,6 +309,9 @@ namespace nr {
 
       found_dci_list.clear(); // Do not process the same DCIs next time
 
+      if (scheduler)
+        scheduler->slot_done(chrono::steady_clock::now() - slot_start);
+
       time_profile_end(process_symbol_time, "pdcch::process (for one symbol)");
     }
 
@@ -311,8 +379,9 @@ namespace nr {
   }
 
 
-  int pdcch::decode_pdcch(symbol& symbol, std::vector<std::complex<float>>& pdcch_symbols, dci dci_, srsran_pdcch_nr_res_t* res, bool rep_opt, int64_t metadata, int symbol_in_chunk)
+  int pdcch::decode_pdcch(symbol& symbol, std::vector<std::complex<float>>& pdcch_symbols, dci dci_, srsran_pdcch_nr_res_t* res, bool rep_opt, const frame_metadata& metadata)
   {
+    tracing::trace_scope trace("pdcch::decode_pdcch");
     bool user_search_space = false;
 
     srsran_pdcch_nr_args_t args = {};
@@ -360,8 +429,17 @@ namespace nr {
         int8_t* llr_aux = (int8_t*)malloc(q.E * sizeof(int8_t));  
         auto rep_opt_t0 = time_profile_start();
 
+        // The deadline scheduler may restrict the scan to the hot RNTIs at the front of the list
+        auto rntis = rnti_list.get_snapshot();
+        size_t num_scanned = rntis->size();
+        if (scheduler) {
+          num_scanned = scheduler->rnti_limit(num_scanned);
+          metrics::count(metrics::shed_decodes, rntis->size() - num_scanned);
+        }
+
         // This could be parallelized
-        for (auto N_RNTI : found_RNTI_list){
+        for (size_t rnti_i = 0; rnti_i < num_scanned; rnti_i++){
+          auto N_RNTI = rntis->at(rnti_i);
           srsran_sequence_apply_c(llr, llr_aux, q.E, pdcch_nr_c_init_scrambler(N_RNTI, dci_.get_pdcch_scrambling_id()));   
           // Adding up repetition
           int sum = 0;      
@@ -375,8 +453,8 @@ namespace nr {
             max_pos = N_RNTI;
           }
         }
-        if (max_value > 1.05 * (total_sum/(found_RNTI_list.size()))){
-          SPDLOG_DEBUG("Possible Repetition optimized max value {}, RNTI {}, average {}", max_value, max_pos, (total_sum/(found_RNTI_list.size())));
+        if (max_value > 1.05 * (total_sum/num_scanned)){
+          SPDLOG_DEBUG("Possible Repetition optimized max value {}, RNTI {}, average {}", max_value, max_pos, (total_sum/num_scanned));
             dci_.set_rnti(max_pos);
         }
 
@@ -399,6 +477,7 @@ namespace nr {
     }
 
     // Decode
+    metrics::count(metrics::polar_decodes);
     if (srsran_polar_decoder_decode_c(&q.decoder, d, q.allocated, q.code.n, q.code.F_set, q.code.F_set_size) < SRSRAN_SUCCESS) {
       SPDLOG_ERROR("Polar decoder failed");
     }
@@ -430,6 +509,7 @@ namespace nr {
     res->crc           = checksum1 == checksum2;
 
     if (res->crc){
+      metrics::count(metrics::crc_passes);
       srsran_vec_fprint_hex(stdout, c, dci_.get_nof_bits());
       char dci_msg_bin[dci_.get_nof_bits() + 1];
       srsran_vec_sprint_bin(dci_msg_bin, dci_.get_nof_bits()+1, c,dci_.get_nof_bits());
@@ -437,14 +517,21 @@ namespace nr {
       if (!update_RNTI_list(dci_.get_rnti())){
         SPDLOG_ERROR("Failed to update RNTI list");
       }
+      if (scheduler)
+        scheduler->add_hot_scrambling_id(dci_.get_pdcch_scrambling_id());
+      if (rnti_scrambling_map::is_learnable(dci_.get_rnti(), dci_.get_pdcch_scrambling_id(), coreset_info.get_cell_id()) &&
+          learned_scrambling_ids.learn(dci_.get_rnti(), dci_.get_pdcch_scrambling_id()))
+        SPDLOG_INFO("RNTI {} uses scrambling ID {}", dci_.get_rnti(), dci_.get_pdcch_scrambling_id());
       // Copy DCI message
       std::vector<uint8_t> dci_payload(c, c + dci_.get_nof_bits());
       dci_.set_payload(dci_payload);
       std::string dci_string = dci_msg_bin;
 
-      float sample_time = ((float) metadata )/sample_rate_time;
-      SPDLOG_INFO("Found DCI PDCCH DCI: RNTI = {}, AL = {}, DCI size {}, Time = {}, Samples from start = {}, Slots from samples from start = {} Slot within frame = {}, Symbol within slot = {}, binary dci is {}, correlation is {}",
-      dci_.get_rnti(), dci_.get_found_aggregation_level(), dci_.get_nof_bits(), sample_time + symbol_in_chunk* 0.001, sample_time, symbol_in_chunk, symbol.slot_index, symbol.symbol_index, dci_string, dci_.get_correlation());
+      double symbol_time = get_symbol_time(symbol, metadata);
+      if (active_rntis && active_rntis->update(dci_.get_rnti(), symbol_time, dci_.get_found_aggregation_level(), dci_.get_nof_bits(), dci_.get_pdcch_scrambling_id()))
+        SPDLOG_INFO("RNTI {} is active", dci_.get_rnti());
+      SPDLOG_INFO("Found DCI PDCCH DCI: Cell ID = {}, RNTI = {}, AL = {}, DCI size {}, Time = {:.6f}, Sample index = {}, SFN.slot = {}.{}, Symbol within slot = {}, binary dci is {}, correlation is {}",
+      coreset_info.get_cell_id(), dci_.get_rnti(), dci_.get_found_aggregation_level(), dci_.get_nof_bits(), symbol_time, symbol.sample_index, symbol.sfn, symbol.slot_index, symbol.symbol_index, dci_string, dci_.get_correlation());
 
     }
       srsran_pdcch_nr_free(&q);
@@ -452,6 +539,65 @@ namespace nr {
   }
 
 
+  /**
+   * Encodes a DCI payload into PDCCH data symbols, mirroring decode_pdcch: CRC
+   * attachment with 24 leading ones, RNTI masking, interleaving, polar coding,
+   * rate matching, scrambling and QPSK modulation, as in srsRAN.
+   *
+   * @param payload DCI bits, one per byte
+   * @param rnti RNTI used to mask the CRC and scramble the symbols
+   * @param pdcch_scrambling_id scrambling ID of the PDCCH
+   * @param aggregation_level aggregation level of the candidate the DCI is sent on
+   * @return aggregation_level * 54 QPSK symbols, in the order of get_data_sc_indices
+   */
+  std::vector<std::complex<float>> pdcch::encode_pdcch(const std::vector<uint8_t>& payload, uint16_t rnti, uint16_t pdcch_scrambling_id, uint8_t aggregation_level)
+  {
+    srsran_pdcch_nr_args_t args = {};
+    srsran_pdcch_nr_t q = {};
+    if (srsran_pdcch_nr_init_tx(&q, &args) < SRSRAN_SUCCESS) {
+      throw sniffer_exception("Error init pdcch_tx");
+    }
+
+    q.K = payload.size() + 24U;
+    q.M = aggregation_level * (PRB_RE - 3U) * CCE_REG;
+    q.E = q.M * 2;
+    if (srsran_polar_code_get(&q.code, q.K, q.E, 9U) < SRSRAN_SUCCESS) {
+      srsran_pdcch_nr_free(&q);
+      throw sniffer_exception("No polar code for a DCI of " + std::to_string(payload.size()) + " bits at AL " + std::to_string(aggregation_level));
+    }
+
+    // Set first L bits to ones, followed by the payload, then append the CRC over both
+    uint8_t* c = q.c;
+    srsran_bit_unpack(UINT32_MAX, &c, 24U);
+    std::copy(payload.begin(), payload.end(), c);
+    srsran_crc_attach(&q.crc24c, q.c, q.K);
+
+    // Scramble CRC with RNTI
+    uint8_t  unpacked_rnti[16] = {};
+    uint8_t* ptr               = unpacked_rnti;
+    srsran_bit_unpack(rnti, &ptr, 16);
+    srsran_vec_xor_bbb(unpacked_rnti, &c[q.K - 16], &c[q.K - 16], 16);
+
+    // Interleave, allocate channel, encode and rate match
+    uint8_t c_prime[164];
+    srsran_polar_interleaver_run(c, c_prime, (uint32_t)sizeof(uint8_t), q.K, true);
+    srsran_polar_chanalloc_tx(c_prime, q.allocated, q.code.N, q.code.K, q.code.nPC, q.code.K_set, q.code.PC_set);
+    srsran_polar_encoder_encode(&q.encoder, q.allocated, q.d, q.code.n);
+    srsran_polar_rm_tx(&q.rm, q.d, q.f, q.code.n, q.E, q.K, 0);
+
+    // Scrambling, with the same RNTI and scrambling ID rule as the decoder (TS 38.211 7.3.2.3)
+    if((rnti < 65520 && rnti > 100) && (pdcch_scrambling_id != get_coreset_info().get_cell_id())){
+      srsran_sequence_apply_bit(q.f, q.f, q.E, pdcch_nr_c_init_scrambler(rnti, pdcch_scrambling_id));
+    }else{
+      srsran_sequence_apply_bit(q.f, q.f, q.E, pdcch_nr_c_init_scrambler(0, get_coreset_info().get_cell_id()));
+    }
+
+    std::vector<std::complex<float>> pdcch_symbols(q.M);
+    srsran_mod_modulate(&q.modem_table, q.f, (cf_t*)pdcch_symbols.data(), q.E);
+    srsran_pdcch_nr_free(&q);
+    return pdcch_symbols;
+  }
+
   float pdcch::compute_correlation_DMRS(symbol& symbol, std::vector<std::complex<float>>& pdcch_dmrs_symbols, std::vector<uint64_t>& pdcch_dmrs_sc_indices){
 
     std::vector<float> correlation_outputs;
@@ -473,6 +619,7 @@ namespace nr {
 
 
   bool pdcch::correlate_DMRS(symbol& symbol, std::vector<dci>& found_dci_list){
+    tracing::trace_scope trace("pdcch::correlate_DMRS");
 
     dmrs dmrs_pdcch;  
 
@@ -490,12 +637,29 @@ namespace nr {
     std::vector<std::complex<float>> pdcch_dmrs_symbols;
     std::vector<uint64_t> pdcch_dmrs_sc_indices;
 
+    /* When over budget, the deadline scheduler may narrow the search to the scrambling IDs DCIs were found with*/
+    uint32_t num_scrambling_ids = scrambling_id_end >= scrambling_id_start ? scrambling_id_end - scrambling_id_start + 1 : 0;
+    std::vector<uint16_t> hot_scrambling_ids;
+    bool narrow_scrambling_ids = num_scrambling_ids > 0 && scheduler && scheduler->is_shedding(shed_step::scrambling_ids);
+    if (narrow_scrambling_ids) {
+      hot_scrambling_ids = scheduler->get_scrambling_ids(scrambling_id_start, scrambling_id_end, coreset_info.get_cell_id());
+      auto search_space = coreset_info.get_candidates_search_space();
+      uint64_t candidates_per_id = std::accumulate(search_space.begin(), search_space.end(), (uint64_t)0);
+      metrics::count(metrics::shed_correlations, (num_scrambling_ids - hot_scrambling_ids.size()) * candidates_per_id);
+      num_scrambling_ids = hot_scrambling_ids.size();
+    }
+
     /* Compute correlation for all possible scrambling IDs*/
-    for (uint32_t pdcch_scrambling_id = scrambling_id_start; pdcch_scrambling_id <= scrambling_id_end; pdcch_scrambling_id++){
+    for (uint32_t id_idx = 0; id_idx < num_scrambling_ids; id_idx++){
+      uint32_t pdcch_scrambling_id = narrow_scrambling_ids ? hot_scrambling_ids.at(id_idx) : scrambling_id_start + id_idx;
       /* For all possible Aggregation levels*/
       for (int agg_level = 0; agg_level < NUM_ALs; agg_level++){
       /* For all possible candidates*/
         max_num_candidate = coreset_info.get_candidates_search_space().at(agg_level);
+        if (scheduler && scheduler->skip_aggregation_level(agg_level)) {
+          metrics::count(metrics::shed_correlations, max_num_candidate);
+          continue;
+        }
         for (int candidate_idx = 0; candidate_idx < max_num_candidate; candidate_idx++){
           std::string key = std::to_string(pdcch_scrambling_id) + std::to_string(agg_level) + std::to_string(symbol.slot_index) + std::to_string(candidate_idx);
           pdcch_dmrs_sc_indices = dmrs_sc_indices_table[key];
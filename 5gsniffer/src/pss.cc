@@ -19,7 +19,11 @@
  *
  */
 
+#include <algorithm>
+#include <numeric>
 #include "pss.h"
+#include "dsp.h"
+#include "exceptions.h"
 
 /* Default Constructor */
 pss::pss(){
@@ -159,5 +163,103 @@ std::array <std::complex<float>,ssb_nfft>  pss::convert_pss_t(std::array <std::c
   return pss_seq_t;
 }
 
+/* Constructor for pss_detector. The coarse templates are the PSS passed through the same decimation filter as the signal, including the filter tails.
+  A refine window of 0 searches +- decimation samples around each candidate. */
+pss_detector::pss_detector(uint16_t decimation_, uint16_t num_candidates_, uint16_t refine_window_){
+  if (decimation_ == 0 || num_candidates_ == 0)
+    throw sniffer_exception("PSS detector decimation and number of candidates must be at least 1");
+  decimation = decimation_;
+  num_candidates = num_candidates_;
+  refine_window = refine_window_ > 0 ? refine_window_ : decimation_;
 
+  // Lowpass filter spanning 4 decimated samples on each side
+  taps.resize(8 * decimation + 1);
+  liquid_firdes_kaiser(taps.size(), 0.5f / decimation, 60.0f, 0.0f, taps.data());
+  float gain = std::accumulate(taps.begin(), taps.end(), 0.0f);
+  for (auto& tap : taps)
+    tap /= gain;
 
+  pss generator;
+  for (int i = 0; i <= nid_2_max; i++){
+    templates.at(i) = generator.convert_pss_t(generator.generate_pss_seq(i));
+    std::vector<std::complex<float>> padded(templates.at(i).begin(), templates.at(i).end());
+    padded.resize(ssb_nfft + taps.size() - 1);
+    decimate(coarse_templates.at(i), padded, taps, decimation);
+  }
+}
+
+/* Finds the PSS with the highest correlation among the candidates of the coarse pass.
+  Position is the sample index at which the PSS starts and correlation its correlation magnitude.
+  Returns false if no candidate is above the threshold, in the coarse pass or once refined. */
+bool pss_detector::search(std::span<std::complex<float>> samples, uint8_t nid_2_start, uint8_t nid_2_end, int64_t& position, float& correlation, uint8_t& nid_2){
+  if (samples.size() < ssb_nfft)
+    return false;
+
+  // Coarse pass, keeping the strongest local maxima above the threshold
+  decimate(decimated, samples, taps, decimation);
+  candidates.clear();
+  for (uint8_t i = nid_2_start; i <= nid_2_end; i++){
+    auto& coarse_template = coarse_templates.at(i);
+    if (decimated.size() < coarse_template.size())
+      break;
+    correlate_magnitude(correlations, decimated, coarse_template);
+
+    float average = std::accumulate(correlations.begin(), correlations.end(), 0.0f) / correlations.size();
+    float threshold = pss_sss_times_avg_threshold * average;
+    for (size_t j = 0; j < correlations.size(); j++){
+      float value = correlations[j];
+      if (value <= threshold || (j > 0 && correlations[j-1] > value) || (j + 1 < correlations.size() && correlations[j+1] >= value))
+        continue;
+      if (candidates.size() == num_candidates && value <= candidates.back().correlation)
+        continue;
+      if (candidates.size() == num_candidates)
+        candidates.pop_back();
+      auto it = std::find_if(candidates.begin(), candidates.end(), [value](const candidate& c){ return c.correlation < value; });
+      candidates.insert(it, {value, (int64_t)j * decimation, i});
+    }
+  }
+
+  // Refine around the candidates at full rate. The refined peak must pass the threshold of an exhaustive
+  // search, whose average is estimated from the full PSS correlation at average_lags lags spread over the samples.
+  correlation = 0.0f;
+  bool found = false;
+  int64_t last_lag = samples.size() - ssb_nfft;
+  std::array<float,nid_2_max + 1> thresholds;
+  thresholds.fill(-1.0f);
+  for (auto& c : candidates){
+    int64_t start = std::max(int64_t(0), c.position - refine_window);
+    int64_t end = std::min(last_lag, c.position + refine_window);
+    if (start > end)
+      continue;
+    float& threshold = thresholds.at(c.nid_2);
+    if (threshold < 0.0f){
+      int step_size = std::max<int64_t>(1, (last_lag + 1) / average_lags);
+      correlate_magnitude(correlations, samples, templates.at(c.nid_2), step_size);
+      threshold = pss_sss_times_avg_threshold * std::accumulate(correlations.begin(), correlations.end(), 0.0f) / correlations.size();
+    }
+    correlate_magnitude(correlations, {samples.data() + start, (size_t)(end - start) + ssb_nfft}, templates.at(c.nid_2));
+    auto max_it = std::max_element(correlations.begin(), correlations.end());
+    if (*max_it > threshold && *max_it > correlation){
+      correlation = *max_it;
+      position = start + (max_it - correlations.begin());
+      nid_2 = c.nid_2;
+      found = true;
+    }
+  }
+  return found;
+}
+
+/* Approximate number of complex multiply-accumulates of a search over num_samples samples */
+uint64_t pss_detector::get_cost(uint64_t num_samples, uint8_t num_nid_2) const{
+  uint64_t num_decimated = num_samples / decimation;
+  uint64_t filter = num_decimated * taps.size();
+  uint64_t coarse = num_nid_2 * num_decimated * coarse_templates.at(0).size();
+  uint64_t refine = num_candidates * (2 * refine_window + 1) * ssb_nfft;
+  uint64_t average = std::min<uint64_t>(num_candidates, num_nid_2) * average_lags * ssb_nfft;
+  return filter + coarse + refine + average;
+}
+
+/* Number of complex multiply-accumulates of correlating every sample with the full PSS */
+uint64_t pss_detector::get_exhaustive_cost(uint64_t num_samples, uint8_t num_nid_2){
+  return num_nid_2 * num_samples * ssb_nfft;
+}
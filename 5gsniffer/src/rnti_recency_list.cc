@@ -0,0 +1,226 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include "rnti_recency_list.h"
+
+/**
+ * Constructor for rnti_recency_list. The list starts empty.
+ */
+rnti_recency_list::rnti_recency_list() :
+  count(0),
+  members{},
+  version(0),
+  published(make_shared<published_snapshot>()) {
+}
+
+/**
+ * Destructor for rnti_recency_list.
+ */
+rnti_recency_list::~rnti_recency_list() {
+
+}
+
+/**
+ * Replaces the list with a range of RNTIs, in ascending order.
+ */
+void rnti_recency_list::assign(uint16_t rnti_start, uint16_t rnti_end) {
+  lock_guard<mutex> lock(write_mutex);
+  for (auto& word : members)
+    word.store(0, memory_order_relaxed);
+  auto fresh = make_shared<published_snapshot>();
+  for (int32_t rnti = rnti_start; rnti <= rnti_end; rnti++) {
+    set_member(rnti, true);
+    fresh->rntis.push_back(rnti);
+  }
+  count.store(fresh->rntis.size(), memory_order_relaxed);
+  changes.clear();
+  fresh->version = version.fetch_add(1, memory_order_acq_rel) + 1;
+  published.store(fresh, memory_order_release);
+}
+
+/**
+ * Moves an RNTI of the list to the front.
+ *
+ * @return false if the RNTI is not in the list, e.g. the SI-RNTI
+ */
+bool rnti_recency_list::promote(uint16_t rnti) {
+  if (!contains(rnti))
+    return false;
+  bool full;
+  {
+    lock_guard<mutex> lock(write_mutex);
+    if (!contains(rnti))
+      return false;
+    full = log_change(rnti, true);
+  }
+  if (full)
+    rebuild(true);
+  return true;
+}
+
+/**
+ * Adds an RNTI at the front of the list, or moves it there if it is already
+ * in the list.
+ *
+ * @return true if the RNTI was added
+ */
+bool rnti_recency_list::push_front(uint16_t rnti) {
+  bool added;
+  bool full;
+  {
+    lock_guard<mutex> lock(write_mutex);
+    added = !contains(rnti);
+    if (added) {
+      set_member(rnti, true);
+      count.fetch_add(1, memory_order_relaxed);
+    }
+    full = log_change(rnti, true);
+  }
+  if (full)
+    rebuild(true);
+  return added;
+}
+
+/**
+ * Removes an RNTI from the list.
+ *
+ * @return false if the RNTI is not in the list
+ */
+bool rnti_recency_list::remove(uint16_t rnti) {
+  bool full;
+  {
+    lock_guard<mutex> lock(write_mutex);
+    if (!contains(rnti))
+      return false;
+    set_member(rnti, false);
+    count.fetch_sub(1, memory_order_relaxed);
+    full = log_change(rnti, false);
+  }
+  if (full)
+    rebuild(true);
+  return true;
+}
+
+bool rnti_recency_list::contains(uint16_t rnti) const {
+  return members[rnti / 64].load(memory_order_acquire) & (uint64_t(1) << (rnti % 64));
+}
+
+size_t rnti_recency_list::size() const {
+  return count.load(memory_order_relaxed);
+}
+
+/**
+ * Returns the order of the list as of its last change. The snapshot is
+ * immutable and stays valid as long as the caller holds it.
+ */
+shared_ptr<const rnti_recency_list::snapshot> rnti_recency_list::get_snapshot() {
+  auto current = published.load(memory_order_acquire);
+  if (current->version != version.load(memory_order_acquire))
+    current = rebuild(false);
+  return shared_ptr<const snapshot>(current, &current->rntis);
+}
+
+/**
+ * Logs a change, under the write lock. A promotion of the RNTI already at the
+ * front is dropped. The changes already merged by a reader are trimmed first,
+ * so the log only grows while nobody reads the list.
+ *
+ * @return true if the log grew as large as the list can be, and should be
+ * merged once the lock is released
+ */
+bool rnti_recency_list::log_change(uint16_t rnti, bool to_front) {
+  auto current = published.load(memory_order_acquire);
+  while (!changes.empty() && changes.front().version <= current->version)
+    changes.pop_front();
+
+  if (to_front) {
+    if (!changes.empty() && changes.back().to_front && changes.back().rnti == rnti)
+      return false;
+    if (changes.empty() && !current->rntis.empty() && current->rntis.front() == rnti)
+      return false;
+  }
+  changes.push_back({version.fetch_add(1, memory_order_acq_rel) + 1, rnti, to_front});
+  return changes.size() >= num_rntis;
+}
+
+/**
+ * Merges the logged changes into the published snapshot and publishes the
+ * result. The RNTIs moved to the front come first, newest first, followed by
+ * the previous order without the RNTIs that changed. Only the copy of the log
+ * is made under the write lock, so writers never wait for a merge. Merging a
+ * change twice gives the same order, so concurrent merges only need to keep
+ * the newest result.
+ *
+ * @param wait wait for the write lock, otherwise return the published snapshot if it is taken
+ * @return the published snapshot, at least as new as the log when it was copied
+ */
+shared_ptr<const rnti_recency_list::published_snapshot> rnti_recency_list::rebuild(bool wait) {
+  shared_ptr<const published_snapshot> current;
+  vector<change> pending;
+  {
+    unique_lock<mutex> lock(write_mutex, defer_lock);
+    if (wait)
+      lock.lock();
+    else if (!lock.try_lock())
+      return published.load(memory_order_acquire);
+
+    current = published.load(memory_order_acquire);
+    for (auto& c : changes) {
+      if (c.version > current->version)
+        pending.push_back(c);
+    }
+  }
+  if (pending.empty())
+    return current;
+
+  vector<uint64_t> changed(num_rntis / 64, 0);
+  auto fresh = make_shared<published_snapshot>();
+  fresh->version = pending.back().version;
+  fresh->rntis.reserve(current->rntis.size() + pending.size());
+  for (auto it = pending.rbegin(); it != pending.rend(); it++) {
+    uint64_t bit = uint64_t(1) << (it->rnti % 64);
+    if (changed[it->rnti / 64] & bit)
+      continue;
+    changed[it->rnti / 64] |= bit;
+    if (it->to_front)
+      fresh->rntis.push_back(it->rnti);
+  }
+  for (uint16_t rnti : current->rntis) {
+    if (!(changed[rnti / 64] & (uint64_t(1) << (rnti % 64))))
+      fresh->rntis.push_back(rnti);
+  }
+
+  // Publish, unless a newer snapshot was published in the meantime
+  shared_ptr<const published_snapshot> expected = current;
+  while (!published.compare_exchange_weak(expected, fresh, memory_order_acq_rel, memory_order_acquire)) {
+    if (expected->version >= fresh->version)
+      return expected;
+  }
+  return fresh;
+}
+
+void rnti_recency_list::set_member(uint16_t rnti, bool member) {
+  uint64_t bit = uint64_t(1) << (rnti % 64);
+  if (member)
+    members[rnti / 64].fetch_or(bit, memory_order_release);
+  else
+    members[rnti / 64].fetch_and(~bit, memory_order_release);
+}
@@ -0,0 +1,135 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <algorithm>
+#include "rnti_scrambling_map.h"
+
+bool rnti_scrambling_map::rnti_set::contains(uint16_t rnti) const {
+  return std::binary_search(sorted.begin(), sorted.end(), rnti);
+}
+
+/**
+ * Constructor for rnti_scrambling_map. Nothing is learned yet.
+ */
+rnti_scrambling_map::rnti_scrambling_map() :
+  no_rntis(make_shared<rnti_set>()) {
+}
+
+/**
+ * Destructor for rnti_scrambling_map.
+ */
+rnti_scrambling_map::~rnti_scrambling_map() {
+
+}
+
+/**
+ * Whether a DCI tells the scrambling ID of its RNTI. SI, RA and other
+ * reserved RNTIs are shared by all UEs, and the cell ID is the scrambling ID
+ * used when pdcch-DMRS-ScramblingID is not configured, both for CSS DCIs and
+ * UEs without one (TS 38.211 7.3.2.3).
+ */
+bool rnti_scrambling_map::is_learnable(uint16_t rnti, uint16_t scrambling_id, uint16_t cell_id) {
+  return rnti > 100 && rnti < 65520 && scrambling_id != cell_id;
+}
+
+/**
+ * Associates an RNTI with the scrambling ID it was found with, replacing the
+ * scrambling ID it was associated with before, if any.
+ *
+ * @return true if the association is new
+ */
+bool rnti_scrambling_map::learn(uint16_t rnti, uint16_t scrambling_id) {
+  lock_guard<mutex> lock(map_mutex);
+  auto [it, added] = scrambling_ids.try_emplace(rnti, scrambling_id);
+  if (!added) {
+    if (it->second == scrambling_id)
+      return false;
+    remove_locked(rnti, it->second);
+    it->second = scrambling_id;
+  }
+
+  auto learned = make_shared<rnti_set>();
+  auto previous = rntis.find(scrambling_id);
+  if (previous != rntis.end())
+    *learned = *previous->second;
+  learned->rntis.insert(learned->rntis.begin(), rnti);
+  learned->sorted.insert(std::upper_bound(learned->sorted.begin(), learned->sorted.end(), rnti), rnti);
+  rntis[scrambling_id] = learned;
+  return true;
+}
+
+/**
+ * Drops the association of an RNTI, e.g. once it is no longer active.
+ *
+ * @return false if the RNTI was not associated with a scrambling ID
+ */
+bool rnti_scrambling_map::forget(uint16_t rnti) {
+  lock_guard<mutex> lock(map_mutex);
+  auto it = scrambling_ids.find(rnti);
+  if (it == scrambling_ids.end())
+    return false;
+  remove_locked(rnti, it->second);
+  scrambling_ids.erase(it);
+  return true;
+}
+
+/**
+ * RNTIs associated with a scrambling ID, empty if none is. The set is
+ * immutable and stays valid as long as the caller holds it.
+ */
+shared_ptr<const rnti_scrambling_map::rnti_set> rnti_scrambling_map::get_rntis(uint16_t scrambling_id) const {
+  lock_guard<mutex> lock(map_mutex);
+  auto it = rntis.find(scrambling_id);
+  return it != rntis.end() ? it->second : no_rntis;
+}
+
+bool rnti_scrambling_map::get_scrambling_id(uint16_t rnti, uint16_t& scrambling_id) const {
+  lock_guard<mutex> lock(map_mutex);
+  auto it = scrambling_ids.find(rnti);
+  if (it == scrambling_ids.end())
+    return false;
+  scrambling_id = it->second;
+  return true;
+}
+
+/**
+ * Number of RNTIs associated with a scrambling ID.
+ */
+size_t rnti_scrambling_map::size() const {
+  lock_guard<mutex> lock(map_mutex);
+  return scrambling_ids.size();
+}
+
+/**
+ * Removes an RNTI from the set of a scrambling ID. The caller holds the lock.
+ */
+void rnti_scrambling_map::remove_locked(uint16_t rnti, uint16_t scrambling_id) {
+  auto it = rntis.find(scrambling_id);
+  if (it == rntis.end())
+    return;
+  auto remaining = make_shared<rnti_set>(*it->second);
+  remaining->rntis.erase(std::remove(remaining->rntis.begin(), remaining->rntis.end(), rnti), remaining->rntis.end());
+  remaining->sorted.erase(std::remove(remaining->sorted.begin(), remaining->sorted.end(), rnti), remaining->sorted.end());
+  if (remaining->rntis.empty())
+    rntis.erase(it);
+  else
+    it->second = remaining;
+}
@@ -39,7 +39,7 @@ rotator::rotator(uint32_t sample_rate, float frequency) :
  * Rotate the input samples.
  * @param samples shared_ptr to sample buffer
  */
-void rotator::process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata) {
+void rotator::process(shared_ptr<vector<complex<float>>>& samples, const frame_metadata& metadata) {
   rotate(*samples, *samples, frequency, sample_rate);
   send_to_next_workers(samples, metadata);
 }
\ No newline at end of file
@@ -99,6 +99,7 @@ shared_ptr<vector<complex<float>>> sdr::receive(size_t num_samples) {
   } catch(sdr_exception& e) {
     SPDLOG_ERROR(e.what());
   }
+  total_produced_samples += num_samples;
 
   return p;
 }
@@ -106,3 +107,12 @@ shared_ptr<vector<complex<float>>> sdr::receive(size_t num_samples) {
 shared_ptr<vector<complex<float>>> sdr::produce_samples(size_t num_samples) {
   return this->receive(num_samples);
 }
+
+/** 
+ * Gets the SDR time of the first sample of the last received buffer.
+ *
+ * @param sample_index unused, the last received buffer is always the one being described
+ */
+int64_t sdr::get_timestamp_ns(int64_t sample_index) {
+  return (int64_t)secs_prev * 1'000'000'000 + (int64_t)(frac_secs_prev * 1e9);
+}
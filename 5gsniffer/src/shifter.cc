@@ -38,7 +38,7 @@ shifter::shifter(int64_t num_samples) :
  * Shift the input samples.
  * @param samples shared_ptr to sample buffer
  */
-void shifter::process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata) {
+void shifter::process(shared_ptr<vector<complex<float>>>& samples, const frame_metadata& metadata) {
   auto result = make_shared<vector<complex<float>>>(std::move(*samples));
 
   if(num_samples < 0) {
@@ -48,7 +48,10 @@ void shifter::process(shared_ptr<vector<complex<float>>>& samples, int64_t metad
     vector<complex<float>> tmp(num_samples, 0);
     result->insert(result->begin(), tmp.begin(), tmp.end());
   }
-  SPDLOG_DEBUG("Shifer block, shifting {} samples by num samples {}, metadata {}",samples->size(),num_samples, metadata);
+  SPDLOG_DEBUG("Shifer block, shifting {} samples by num samples {}, sample index {}",samples->size(),num_samples, metadata.sample_index);
 
-  send_to_next_workers(result, metadata);
+  // The first sample moved by the shift
+  frame_metadata shifted_metadata = metadata;
+  shifted_metadata.sample_index -= num_samples;
+  send_to_next_workers(result, shifted_metadata);
 }
\ No newline at end of file
@@ -24,13 +24,21 @@
 #include "sdr.h"
 #include "file_source.h"
 #include "file_sink.h"
+#include "grid_source.h"
+#include "carrier_splitter.h"
+#include "channel_mapper.h"
+#include "config.h"
 #include "spdlog/spdlog.h"
 #include "phy_params_common.h"
 #include "utils.h"
+#include "affinity.h"
+#include "metrics.h"
 #include <memory>
 
 using namespace std;
 
+extern struct config config;
+
 /** 
  * Constructor for sniffer when using SDR.
  *
@@ -52,32 +60,161 @@ sniffer::sniffer(uint64_t sample_rate, uint64_t frequency, string rf_args, uint1
  * @param sample_rate
  * @param path
  * @param ssb_numerology
+ * @param realtime pace the file to the sample rate
+ * @param follow keep reading the file as it is being written
+ * @param follow_timeout seconds without new samples after which a followed file ends
  */
-sniffer::sniffer(uint64_t sample_rate, string path, uint16_t ssb_numerology) :
+sniffer::sniffer(uint64_t sample_rate, string path, uint16_t ssb_numerology, bool realtime, bool follow, double follow_timeout) :
   sample_rate(sample_rate),
   ssb_numerology(ssb_numerology),
-  device(make_unique<file_source>(sample_rate, path)) {
+  device(make_unique<file_source>(sample_rate, path, false, realtime, follow, follow_timeout)) {
   init();
 }
 
+/** 
+ * Constructor for sniffer when replaying a CORESET grid recording.
+ *
+ * @param grid_path path to a recording made by grid_sink
+ */
+sniffer::sniffer(string grid_path) :
+  sample_rate(0),
+  ssb_numerology(0),
+  device(make_unique<grid_source>(grid_path)) {
+  init_grid_replay();
+}
+
 /** 
  * Common initializer helper function shared amongst constructors.
  */
 void sniffer::init() {
-  // Create blocks
-  auto phy = make_shared<nr::phy>();  
-  phy->ssb_bwp = make_unique<bandwidth_part>(3'840'000 * (1<<ssb_numerology), ssb_numerology, ssb_rb); // Default bandwidth part that captures at least 256 subcarriers (240 needed for SSB).
-  auto syncer = make_shared<class syncer>(sample_rate, phy);
+  // A real-time ingest thread only receives the samples, the blocks after it
+  // run on a task pool so that they can never starve the rest of the system
+  bool realtime_ingest = config.sdr_realtime_priority > 0 && dynamic_cast<sdr*>(device.get());
+  size_t ingest_queue_depth = realtime_ingest ? std::max<size_t>(config.fanout_queue_depth, 1) : config.fanout_queue_depth;
+
+  // Create blocks. All syncers share a single pool of flows
+  auto flow_pool = nr::flow_pool::from_config();
+  if (config.carriers.size() > 0) {
+    auto splitter = make_shared<carrier_splitter>(sample_rate, config.frequency, config.carriers);
+    for (uint8_t carrier = 0; carrier < config.carriers.size(); carrier++) {
+      for (auto& syncer : create_syncers(splitter->carrier_sample_rate, flow_pool, carrier)) {
+        splitter->connect_carrier(carrier, syncer);
+      }
+    }
+    device->connect(splitter);
+    if (config.parallel_fanout)
+      splitter->set_parallel_fanout(task_pool::from_config(), config.fanout_queue_depth);
+    if (realtime_ingest)
+      device->set_parallel_fanout(task_pool::from_config(), ingest_queue_depth, true);
+  } else {
+    for (auto& syncer : create_syncers(sample_rate, flow_pool, 0)) {
+      device->connect(syncer);
+    }
+    if (realtime_ingest || (config.parallel_fanout && device->num_next_workers() > 1))
+      device->set_parallel_fanout(task_pool::from_config(), ingest_queue_depth, realtime_ingest);
+  }
 
   // Callbacks
   device->on_end = std::bind(&sniffer::stop, this);
+}
 
-  device->connect(syncer);
+/** 
+ * Creates the syncers of a carrier. In multi-cell mode, there is one syncer
+ * per PSS index, each with its own PHY-layer state, so that every cell of the
+ * carrier is tracked and decoded independently.
+ *
+ * @param sample_rate sample rate of the carrier
+ * @param flow_pool pool of flows shared by all syncers
+ * @param carrier index of the carrier
+ */
+vector<shared_ptr<syncer>> sniffer::create_syncers(uint64_t sample_rate, shared_ptr<nr::flow_pool> flow_pool, uint8_t carrier) {
+  vector<shared_ptr<syncer>> syncers;
+  auto create_syncer = [&](optional<uint8_t> nid2) {
+    auto phy = make_shared<nr::phy>();
+    phy->ssb_bwp = make_unique<bandwidth_part>(3'840'000 * (1<<ssb_numerology), ssb_numerology, ssb_rb); // Default bandwidth part that captures at least 256 subcarriers (240 needed for SSB).
+    syncers.push_back(make_shared<class syncer>(sample_rate, phy, flow_pool, nid2, carrier));
+  };
+
+  if (!config.multi_cell) {
+    create_syncer(nullopt);
+    return syncers;
+  }
+
+  uint8_t nid2_start = 0;
+  uint8_t nid2_end = nid_2_max;
+  if (config.nid_2 <= nid_2_max) {
+    nid2_start = config.nid_2;
+    nid2_end = config.nid_2;
+  }
+  for (uint8_t nid2 = nid2_start; nid2 <= nid2_end; nid2++) {
+    create_syncer(nid2);
+  }
+  SPDLOG_INFO("Sniffing up to {} cells", syncers.size());
+  return syncers;
+}
+
+/** 
+ * Initializer for grid replays. Synchronization is skipped: the recorded CORESET
+ * symbols are passed straight to the PDCCH of every configured CORESET with
+ * the recorded CORESET ID.
+ */
+void sniffer::init_grid_replay() {
+  auto& header = static_cast<grid_source*>(device.get())->header;
+  sample_rate = header.sample_rate;
+
+  auto phy = make_shared<nr::phy>();
+  phy->nid1 = header.cell_id / 3;
+  phy->nid2 = header.cell_id % 3;
+  phy->in_synch = true;
+
+  for(pdcch_config pdcch_cfg : config.pdcch_configs) {
+    if(pdcch_cfg.coreset_id != header.coreset_id)
+      continue;
+
+    // The recorded geometry takes precedence, as it may have been derived from the MIB
+    pdcch_cfg.numerology = header.numerology;
+    pdcch_cfg.num_prbs = header.num_prbs;
+    pdcch_cfg.coreset_duration = header.coreset_duration;
+    pdcch_cfg.coreset_ofdm_symbol_start = header.coreset_ofdm_symbol_start;
+    pdcch_cfg.extended_prefix = header.flags & grid_flag_extended_prefix;
+    pdcch_cfg.sample_rate_time = sample_rate;
+    pdcch_cfg.grid_recording_path = ""; // Don't record the replay
+    if (pdcch_cfg.si_dci_only) {
+      pdcch_cfg.restrict_to_si_dci(phy->get_cell_id());
+    }
+
+    auto new_bwp = make_shared<bandwidth_part>(sample_rate, pdcch_cfg.numerology, pdcch_cfg.num_prbs, pdcch_cfg.extended_prefix);
+    phy->bandwidth_parts.push_back(new_bwp);
+    auto mapper = make_shared<channel_mapper>(phy, pdcch_cfg);
+    phy->channel_mappers.push_back(mapper);
+
+    // Connect to the PDCCH of the mapper, sharing ownership with the mapper
+    device->connect(shared_ptr<nr::pdcch>(mapper, &mapper->pdcch));
+  }
+
+  if(phy->channel_mappers.size() == 0)
+    throw config_exception("No [[pdcch]] config matches the CORESET ID of the grid recording");
+
+  // Callbacks
+  device->on_end = std::bind(&sniffer::stop, this);
 }
 
 void sniffer::start() {
   running = true;
   float seconds_per_chunk = 0.0080;
+
+  // This thread ingests the samples, and runs the syncers unless they were moved to a task pool
+  vector<int> ingest_cpus;
+  if (config.ingest_cpu >= 0)
+    ingest_cpus.push_back(config.ingest_cpu);
+  else if (config.numa_node >= 0)
+    ingest_cpus = get_numa_node_cpus(config.numa_node);
+  if (set_thread_affinity(pthread_self(), ingest_cpus))
+    SPDLOG_INFO("Pinned ingest thread to {} CPUs", ingest_cpus.size());
+  if (config.sdr_realtime_priority > 0 && dynamic_cast<sdr*>(device.get())) {
+    // Only safe because init queues every buffer of the device, even to a lone splitter or syncer
+    set_thread_realtime(pthread_self(), config.sdr_realtime_priority);
+  }
     
   uint32_t num_samples_per_chunk = static_cast<uint32_t>(sample_rate * seconds_per_chunk);
 
@@ -85,9 +222,11 @@ void sniffer::start() {
     SPDLOG_DEBUG("Calling device work for SDR");
 
     auto sniffer_work_t0 = time_profile_start();
+    metrics::stage_timer timer(metrics::sniffer_work);
     device->work(num_samples_per_chunk);
     time_profile_end(sniffer_work_t0, "sniffer::work");
   }
+  device->join_next_workers();
 
   SPDLOG_DEBUG("Terminating sniffer");
 }
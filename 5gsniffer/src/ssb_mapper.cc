@@ -22,6 +22,8 @@
 #include <complex>
 #include <cstddef>
 #include <cstdint>
+#include <algorithm>
+#include <numeric>
 #include <liquid/liquid.h>
 #include "ssb_mapper.h"
 #include "spdlog/spdlog.h"
@@ -34,9 +36,14 @@ using namespace std;
 
 /** 
  * Constructor for ssb_mapper.
+ *
+ * @param phy
+ * @param sss_fast_transform detect the SSS with the m-sequence transform instead of the matrix-vector product
  */
-ssb_mapper::ssb_mapper(shared_ptr<nr::phy> phy) :
-  pbch(phy) {
+ssb_mapper::ssb_mapper(shared_ptr<nr::phy> phy, bool sss_fast_transform) :
+  pbch(phy),
+  predicting_mib(false),
+  sss_detector(sss_fast_transform) {
   this->phy = phy;
 }
 
@@ -51,53 +58,28 @@ ssb_mapper::~ssb_mapper() {
  * Processes input OFDM symbols, looking for SSS and sending symbols to PBCH.
  * @param symbols contains OFDM symbols
  */
-void ssb_mapper::process(shared_ptr<vector<symbol>>& symbols, int64_t metadata) {
+void ssb_mapper::process(shared_ptr<vector<symbol>>& symbols, const frame_metadata& metadata) {
   SPDLOG_DEBUG("Got {} symbols", symbols->size());
 
-  auto ssss = phy->ssss;
-
   if(symbols->size() >= 4) {
-    if (phy->in_synch){
+    uint16_t nid1;
+    if (phy->in_synch && predicting_mib){
+      // The MIB is only predicted while the SSS of the tracked cell is still there, otherwise the PBCH is decoded
+      if (detect_sss(*symbols, nid1) && nid1 == phy->nid1) {
+        this->on_mib_predictable();
+      } else {
+        SPDLOG_DEBUG("SSS of cell ID {} not found while predicting the MIB, decoding the PBCH", phy->get_cell_id());
+        pbch.work(symbols, metadata);
+      }
+    } else if (phy->in_synch){
       // No need to re-find SSS. fine time synch with SSS is performed in syncer.cc.
-      auto pbch_symbols = make_shared<vector<symbol>>(symbols->begin(), symbols->begin()+4);
-      pbch.initialize_dmrs_seq();
-      pbch.work(pbch_symbols);
+      pbch.work(symbols, metadata);
     } else {
-      assert(symbols->at(2).symbol_index == 4); // Assert SSS is the 5th symbol (index 4)
-
-      // Extract SSS
-      span<complex<float>> sss_res = symbols->at(2).get_res(56, 182);
-      assert(sss_res.size() == sss_length);
-      
-      // Find SSS through correlation
-      float max_corr = 0.0f;
-      uint16_t max_nid = 0;
-      float avg_corr = 0.0f;
-      for(uint16_t nid1 = 0; nid1 <= 335; nid1++) {
-        auto sss_ref = ssss.at(nid1*3 + phy->nid2);
-        vector<float> out(1);
-
-        correlate_magnitude(out, sss_ref, sss_res);
-
-        float corr = out.at(0);
-        avg_corr += corr;
-        if(corr > max_corr) {
-          max_corr = corr;
-          max_nid = nid1;
-        }
-      }
-      avg_corr /= 355;
-
-      SPDLOG_DEBUG("SSS max corr: {} ({} avg)", max_corr, avg_corr);
-
-      if (max_corr > pss_sss_times_avg_threshold * avg_corr) {
-        SPDLOG_DEBUG("NID1: {}, corr {} avg {} ratio {}", max_nid, max_corr, avg_corr, max_corr / avg_corr);
-        this->on_sss_found(max_nid);
+      if (detect_sss(*symbols, nid1)) {
+        this->on_sss_found(nid1);
 
-        // PBCH processing TODO can happen in parallel
-        auto pbch_symbols = make_shared<vector<symbol>>(symbols->begin(), symbols->begin()+4);
-        pbch.initialize_dmrs_seq();
-        pbch.work(pbch_symbols);
+        // PBCH processing TODO can happen in parallel. PBCH only uses the first 4 symbols and estimates them in place.
+        pbch.work(symbols, metadata);
       } else {
         this->on_sss_not_found();
       }
@@ -106,3 +88,31 @@ void ssb_mapper::process(shared_ptr<vector<symbol>>& symbols, int64_t metadata)
     SPDLOG_ERROR("Need at least 4 symbols to be able to process SSB.");
   }
 }
+
+/**
+ * Finds the SSS through correlation with all SSS of the PSS index.
+ *
+ * @param symbols SSB symbols, the SSS in the third one
+ * @param nid1 set to the NID1 of the strongest SSS
+ * @return whether the strongest SSS is over the threshold
+ */
+bool ssb_mapper::detect_sss(vector<symbol>& symbols, uint16_t& nid1) {
+  assert(symbols.at(2).symbol_index == 4); // Assert SSS is the 5th symbol (index 4)
+
+  // Extract SSS
+  span<complex<float>> sss_res = symbols.at(2).get_res(56, 182);
+  assert(sss_res.size() == sss_length);
+
+  sss_detector.correlate(sss_res, phy->nid2, sss_correlations);
+  auto max_it = std::max_element(sss_correlations.begin(), sss_correlations.end());
+  float max_corr = *max_it;
+  nid1 = max_it - sss_correlations.begin();
+  float avg_corr = std::accumulate(sss_correlations.begin(), sss_correlations.end(), 0.0f) / sss_correlations.size();
+
+  SPDLOG_DEBUG("SSS max corr: {} ({} avg)", max_corr, avg_corr);
+  if (max_corr > pss_sss_times_avg_threshold * avg_corr) {
+    SPDLOG_DEBUG("NID1: {}, corr {} avg {} ratio {}", nid1, max_corr, avg_corr, max_corr / avg_corr);
+    return true;
+  }
+  return false;
+}
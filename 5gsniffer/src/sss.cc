@@ -20,6 +20,8 @@
  */
 
 #include "sss.h"
+#include <cassert>
+#include <cmath>
 
 /* Default Constructor */
 sss::sss(){
@@ -179,5 +181,114 @@ std::array <std::complex<float>,ssb_nfft>  sss::convert_sss_t(std::array <std::c
   return sss_seq_t;
 }
 
+/* Returns one of the two m-sequences of the SSS as +1/-1 values, x_0 if feedback_tap is 4 and x_1 if it is 1 (3GPP TS 38.211 7.4.2.3.1) */
+static std::array<float,sss_length> generate_m_sequence(uint8_t feedback_tap){
+  std::array<int,sss_length> x = {1, 0, 0, 0, 0, 0, 0};
+  for (int i = 0; i < sss_length - 7; i++) {
+    x.at(i+7) = (x.at(i+feedback_tap) + x.at(i))%2;
+  }
+
+  std::array<float,sss_length> m_sequence;
+  for (int i = 0; i < sss_length; i++) {
+    m_sequence.at(i) = 1 - 2*x.at(i);
+  }
+  return m_sequence;
+}
+
+/* Constructor for sss_detector. The fast transform needs FFT plans of length 127 and the FFT of x_1. */
+sss_detector::sss_detector(bool fast_transform_){
+  fast_transform = fast_transform_;
+  x_0 = generate_m_sequence(4);
+
+  std::array<float,sss_length> x_1 = generate_m_sequence(1);
+  std::copy(x_1.begin(), x_1.end(), z.begin());
+  forward = fft_create_plan(sss_length, z.data(), z_fft.data(), LIQUID_FFT_FORWARD, 0);
+  backward = fft_create_plan(sss_length, z_fft.data(), c.data(), LIQUID_FFT_BACKWARD, 0);
+  fft_execute(forward);
+  x_1_fft = z_fft;
+}
+
+sss_detector::~sss_detector(){
+  fft_destroy_plan(forward);
+  fft_destroy_plan(backward);
+}
+
+/* Returns the reference matrix of all SSS, generated once and shared by all detectors */
+const sss_reference_matrix& sss_detector::get_reference_matrix(){
+  static const std::unique_ptr<sss_reference_matrix> matrix = [](){
+    auto matrix = std::make_unique<sss_reference_matrix>();
+    sss generator;
+    for (int nid_2 = 0; nid_2 <= nid_2_max; nid_2++){
+      for (int nid_1 = 0; nid_1 <= nid_1_max; nid_1++){
+        auto sequence = generator.generate_sss_seq(nid_1, nid_2);
+        for (int i = 0; i < sss_length; i++){
+          (*matrix)[nid_2][nid_1][i] = sequence[i].real();
+        }
+      }
+    }
+    return matrix;
+  }();
+  return *matrix;
+}
+
+/* Correlates the received SSS with all SSS of a PSS index. correlations[nid_1] is set to the correlation magnitude with the SSS of nid_1. */
+void sss_detector::correlate(std::span<const std::complex<float>> sss_res, uint8_t nid_2, std::array<float,nid_1_max+1>& correlations){
+  assert(sss_res.size() == sss_length);
+  if (fast_transform){
+    correlate_m_sequences(sss_res, nid_2, correlations);
+  } else {
+    correlate_matrix(sss_res, nid_2, correlations);
+  }
+}
+
+/* Matrix-vector product of the reference matrix with the received SSS, computed for blocks of rows so the received SSS is read once per block */
+void sss_detector::correlate_matrix(std::span<const std::complex<float>> sss_res, uint8_t nid_2, std::array<float,nid_1_max+1>& correlations){
+  constexpr int block_size = 8;
+  static_assert((nid_1_max+1) % block_size == 0);
+  const auto& rows = get_reference_matrix()[nid_2];
+
+  // Separate I and Q so the inner loop only has real multiply-adds
+  std::array<float,sss_length> res_i;
+  std::array<float,sss_length> res_q;
+  for (int n = 0; n < sss_length; n++){
+    res_i[n] = sss_res[n].real();
+    res_q[n] = sss_res[n].imag();
+  }
+
+  for (int nid_1 = 0; nid_1 <= nid_1_max; nid_1 += block_size){
+    float acc_i[block_size] = {};
+    float acc_q[block_size] = {};
+    for (int n = 0; n < sss_length; n++){
+      for (int b = 0; b < block_size; b++){
+        acc_i[b] += rows[nid_1+b][n] * res_i[n];
+        acc_q[b] += rows[nid_1+b][n] * res_q[n];
+      }
+    }
+    for (int b = 0; b < block_size; b++){
+      correlations[nid_1+b] = std::sqrt(acc_i[b]*acc_i[b] + acc_q[b]*acc_q[b]);
+    }
+  }
+}
+
+/* Correlation through the m-sequence structure: d(n) = x_0((n+m_0) mod 127) * x_1((n+m_1) mod 127), where
+   m_0 = 15*floor(nid_1/112) + 5*nid_2 and m_1 = nid_1 mod 112. For each of the 3 values of m_0, the received SSS
+   is multiplied by x_0 and cyclically correlated with x_1 through FFTs, giving the correlations for all m_1 at once. */
+void sss_detector::correlate_m_sequences(std::span<const std::complex<float>> sss_res, uint8_t nid_2, std::array<float,nid_1_max+1>& correlations){
+  for (int group = 0; group < 3; group++){
+    int m_0 = 15*group + 5*nid_2;
 
+    // c(m_1) = sum_n z(n) x_1(n+m_1) is the circular convolution of x_1 with z reversed
+    for (int n = 0; n < sss_length; n++){
+      z[(sss_length - n) % sss_length] = sss_res[n] * x_0[(n + m_0) % sss_length];
+    }
+    fft_execute(forward);
+    for (int k = 0; k < sss_length; k++){
+      z_fft[k] *= x_1_fft[k];
+    }
+    fft_execute(backward);
 
+    for (int m_1 = 0; m_1 < 112; m_1++){
+      correlations[112*group + m_1] = std::abs(c[m_1]) / sss_length;
+    }
+  }
+}
@@ -30,6 +30,7 @@
  */
 symbol::symbol() {
   SPDLOG_TRACE("Construct {}", (uint64_t)this);
+  sfn = 0;
   is_equalized = false;
 }
 
@@ -51,6 +52,7 @@ symbol::symbol(const symbol& other) {
   noise = other.noise;
   symbol_index = other.symbol_index;
   slot_index = other.slot_index;
+  sfn = other.sfn;
   channel_filter = other.channel_filter;
   is_equalized = other.is_equalized;
 };
@@ -66,6 +68,7 @@ symbol::symbol(symbol&& other) {
   noise = std::move(other.noise);
   symbol_index = other.symbol_index;
   slot_index = other.slot_index;
+  sfn = other.sfn;
   channel_filter = std::move(other.channel_filter);
   is_equalized = other.is_equalized;
 };
@@ -99,6 +102,7 @@ void symbol::swap(symbol& other) {
   std::swap(noise, other.noise);
   std::swap(symbol_index, other.symbol_index);
   std::swap(slot_index, other.slot_index);
+  std::swap(sfn, other.sfn);
   std::swap(channel_filter, other.channel_filter);
   std::swap(is_equalized, other.is_equalized);
 };
@@ -129,13 +133,9 @@ void symbol::channel_estimate(
 
   uint64_t ref_index = 0;
   uint64_t prev = subcarrier_start;
-  vector<complex<float>> test_channel_noninterp; // For testing purposes only; temp buffer to write to file
-  vector<complex<float>> test_dmrs_reference;
   for(auto dmrs_index : dmrs_indices) {
     // Determine the channel filter
     channel_filter[dmrs_index] = samples[dmrs_index] * conj(dmrs_reference[ref_index]);
-    test_channel_noninterp.push_back(channel_filter[dmrs_index]);
-    test_dmrs_reference.push_back(dmrs_reference[ref_index]);
     SPDLOG_TRACE("Setting channel_filter[{}] = ({}, {})", dmrs_index, real(channel_filter[dmrs_index]), imag(channel_filter[dmrs_index]));
     assert(prev <= dmrs_index);
 
@@ -41,6 +41,8 @@
 #include "file_sink.h"
 #include "channel_mapper.h"
 #include "config.h"
+#include "metrics.h"
+#include "tracing.h"
 #include <fstream>
 
 extern struct config config;
@@ -49,21 +51,25 @@ using namespace std;
 
 /** 
  * Constructor for syncer.
+ *
+ * @param sample_rate
+ * @param phy PHY-layer state of the cell to synchronize to
+ * @param flow_pool pool of flows shared with other syncers, a private pool is created if null
+ * @param nid2 only look for this PSS index, overriding the config
+ * @param carrier index of the carrier, only the PDCCH configs of this carrier are decoded
  */
-syncer::syncer(uint64_t sample_rate, shared_ptr<nr::phy> phy) :
+syncer::syncer(uint64_t sample_rate, shared_ptr<nr::phy> phy, shared_ptr<nr::flow_pool> flow_pool, optional<uint8_t> nid2, uint8_t carrier) :
   sample_rate(sample_rate),
-  phy(phy) {
-  // Reserve some space for the processing queue
-  processing_queue.reserve(1024*1024);
+  phy(phy),
+  carrier(carrier) {
+  // Reserve space for an SSB period of samples in the processing queue
+  processing_queue.reserve(sample_rate / 50);
 
   // Generate all needed PSS and SSS signals
   psss.push_back(pss(0));
   psss.push_back(pss(1));
   psss.push_back(pss(2));
 
-  sss sss_ref(0,0);
-  std::array <std::array<std::complex<float>,sss_length>,nid_max+1> ssss = sss_ref.generate_all_sss_seq();
-  phy->ssss = ssss;
   // Setup resampler
   unsigned int h_len = 51;                               // Filter semi-length (filter delay)
   resampling_rate = (float)phy->ssb_bwp->sample_rate / (float)sample_rate; // Resampling rate (output/input)
@@ -73,8 +79,12 @@ syncer::syncer(uint64_t sample_rate, shared_ptr<nr::phy> phy) :
   unsigned int npfb = 16;                                // Number of filters in bank (timing resolution)
   resampler = resamp_crcf_create(resampling_rate, h_len, bw, slsl, npfb);
 
-  // Look for a given PSS index as specified in the config file
-  if (config.nid_2 < 3){
+  // Look for a given PSS index as specified by the caller or in the config file
+  if (nid2.has_value()){
+    pss_start = nid2.value();
+    pss_end = nid2.value();
+  }
+  else if (config.nid_2 < 3){
     pss_start = config.nid_2;
     pss_end = config.nid_2;
   }
@@ -84,25 +94,58 @@ syncer::syncer(uint64_t sample_rate, shared_ptr<nr::phy> phy) :
     pss_end = 2;
   }
   
+  // Optionally speed up initial acquisition with a coarse-to-fine PSS search
+  if (config.pss_coarse_decimation > 1) {
+    coarse_pss = make_unique<pss_detector>(config.pss_coarse_decimation, config.pss_coarse_candidates, config.pss_refine_window);
+    uint64_t chunk = sample_rate / 100 * resampling_rate; // Roughly the downsampled samples searched per 10 ms
+    SPDLOG_INFO("Coarse-to-fine PSS search with decimation {}: {} instead of {} complex MACs per 10 ms of samples",
+      config.pss_coarse_decimation, coarse_pss->get_cost(chunk, pss_end - pss_start + 1), pss_detector::get_exhaustive_cost(chunk, pss_end - pss_start + 1));
+  }
+
+  // Optionally search integer-subcarrier CFOs during initial acquisition
+  if (config.cfo_hypotheses.size() > 1 || (config.cfo_hypotheses.size() == 1 && config.cfo_hypotheses[0] != 0)) {
+    cfo_bank = make_unique<cfo_hypothesis_bank>(config.cfo_hypotheses, sample_rate / 100 * resampling_rate);
+  }
+
   state = syncer::state::find_pss;
   cfo = 0.0f;
+  cfo_integer = 0.0f;
 
   waiting_for_pss = 0;
-  counting_samples = 0;      
+  sync_generation = 0;
+  anchored = false;
+  anchor_sample_index = 0;
+  anchor_sfn = 0;
+  anchor_slot = 0;
   bool in_synch;
   ssb_period = 0.02; // SSB periodicity is 20 ms for initial access.
   // Window size to look for PSS after we are already sync. 8 OFDM symbols 
   pss_window_size = std::floor((float)sample_rate /(float)(phy->ssb_bwp->scs) * 8);
  
-  // Create pool of 64 flows that can process samples in parallel after synchronization
-  flow_pool = make_shared<nr::flow_pool>(64);
-  this->connect(flow_pool);
+  // Create pool of flows that can process samples in parallel after synchronization, unless it is shared
+  if (!flow_pool)
+    flow_pool = nr::flow_pool::from_config();
+  flows = make_shared<nr::flow_set>(flow_pool);
+  this->connect(flows);
+
+  // The SSB mapper keeps its PBCH decoder and DMRS tables across SSBs
+  ssb_mapper = make_shared<class ssb_mapper>(phy, config.sss_fast_transform);
+  ssb_mapper->on_sss_found = std::bind(&syncer::on_sss_found, this, std::placeholders::_1);
+  ssb_mapper->on_sss_not_found = std::bind(&syncer::on_sync_lost, this);
+  ssb_mapper->on_mib_predictable = std::bind(&syncer::on_mib_predictable, this);
+  ssb_mapper->pbch.on_mib_found = std::bind(&syncer::on_mib_found, this, std::placeholders::_1,std::placeholders::_2);
+  last_mib = {};
+  last_mib_valid = false;
+  predicting_mib = false;
+  mibs_predicted = 0;
+  reported_queue_size = 0;
 }
 
 /** 
  * Destructor for syncer.
  */
 syncer::~syncer() {
+  metrics::add_gauge(metrics::syncer_queued_samples, -reported_queue_size);
   resamp_crcf_destroy(resampler);
 }
 
@@ -112,15 +155,18 @@ syncer::~syncer() {
  *
  * @param samples shared_ptr to sample buffer to process
  */
-void syncer::process(shared_ptr<vector<complex<float>>>& samples, int64_t metadata) {
+void syncer::process(shared_ptr<vector<complex<float>>>& samples, const frame_metadata& metadata) {
+  metrics::stage_timer timer(metrics::syncer_process);
+  tracing::trace_scope trace("syncer::process");
   SPDLOG_DEBUG("Received {} samples", samples.get()->size());
+  queue_metadata = metadata;
 
   // Apply frequency correction to new samples
   SPDLOG_DEBUG("Applying CFO {} to new samples coming to the processing queue counter", -cfo);
 
-  rotate(*samples.get(), *samples.get(), -cfo, sample_rate);   
-  // Add the samples to the processing queue
-  processing_queue = std::move(*samples.get());
+  // Add the samples to the processing queue. The input is left untouched, as other syncers may share it
+  processing_queue.resize(samples->size());
+  rotate(processing_queue, *samples.get(), -cfo, sample_rate);
 
   if (state == state::reset) {
     // Clear processing queues
@@ -133,6 +179,8 @@ void syncer::process(shared_ptr<vector<complex<float>>>& samples, int64_t metada
 
     // Reset sync
     cfo = 0.0f;
+    cfo_integer = 0.0f;
+    last_mib_valid = false;
 
     // Look for PSS again
     state = state::find_pss;
@@ -142,6 +190,7 @@ void syncer::process(shared_ptr<vector<complex<float>>>& samples, int64_t metada
    if (waiting_for_pss > sample_rate * ssb_period){ // We missed the SSB
     waiting_for_pss = 0;
     phy->in_synch = false;
+    metrics::count(metrics::sync_losses);
     SPDLOG_DEBUG("PSS tracking failed resetting");
    } else {
     waiting_for_pss += processing_queue.size();
@@ -152,10 +201,8 @@ void syncer::process(shared_ptr<vector<complex<float>>>& samples, int64_t metada
      if ((waiting_for_pss > sample_rate * ssb_period) & (waiting_for_pss - processing_queue.size() < sample_rate * ssb_period)){ // We have to account for the previous chunk of 8 ms where we found SSB and we send already and then we started counting after that.
       state = state::find_pss;
      } else {
-      int sent_samples_size = processing_queue.size();
       shared_ptr<vector<complex<float>>> processing_queue_ptr = make_shared<vector<complex<float>>>(std::move(processing_queue)); // TODO allocate processing_queue on the heap in the first place so we don't need to do this copy
-      send_to_next_workers(processing_queue_ptr, counting_samples);
-      counting_samples = counting_samples + sent_samples_size;
+      send_queue_front(processing_queue_ptr);
       processing_queue.clear();
      }
   }
@@ -163,6 +210,7 @@ void syncer::process(shared_ptr<vector<complex<float>>>& samples, int64_t metada
   if (state == state::find_pss) {
     SPDLOG_DEBUG("Looking for PSS");
     auto find_pss_t0 = time_profile_start();
+    metrics::stage_timer find_pss_timer(metrics::syncer_find_pss);
     find_pss();
     time_profile_end(find_pss_t0, "syncer::find_pss");
   } 
@@ -175,20 +223,22 @@ void syncer::process(shared_ptr<vector<complex<float>>>& samples, int64_t metada
   if(state == state::find_sss) {
     SPDLOG_DEBUG("Looking for SSS");
     auto find_sss_t0 = time_profile_start();
+    metrics::stage_timer find_sss_timer(metrics::syncer_find_sss);
     find_sss();
     time_profile_end(find_sss_t0, "syncer::find_sss");
   } 
   
   if(state == state::relay) {
     waiting_for_pss = processing_queue.size();
-    int sent_samples_size = processing_queue.size();
     shared_ptr<vector<complex<float>>> processing_queue_ptr = make_shared<vector<complex<float>>>(std::move(processing_queue)); // TODO allocate processing_queue on the heap in the first place so we don't need to do this copy
-    send_to_next_workers(processing_queue_ptr, counting_samples);
-    counting_samples = counting_samples + sent_samples_size;
+    send_queue_front(processing_queue_ptr);
 
     processing_queue.clear();
     state = state::wait;
   }
+
+  metrics::add_gauge(metrics::syncer_queued_samples, (int64_t)processing_queue.size() - reported_queue_size);
+  reported_queue_size = processing_queue.size();
 }
 
 /**
@@ -241,34 +291,51 @@ void syncer::find_pss() {
     int64_t timing_error_downsampled_offset = 0;
     float max_corr = 0.0;
     uint8_t nid2 = 0;
-    for(uint8_t pss_idx = pss_start; pss_idx <= pss_end; pss_idx++) {
-      vector<float> correlation_magnitudes;
-      // Correlate
-      int step_size = 1;
-      correlate_magnitude(correlation_magnitudes, downsampled_samples, {psss[pss_idx].get_pss_seq_t().data(), psss[pss_idx].get_pss_seq_t().size()}, step_size);
-
-      // Get the average
-      float avg_correlation = 0.0f;
-      volk_32f_accumulator_s32f(&avg_correlation, correlation_magnitudes.data(), correlation_magnitudes.size());
-      avg_correlation /= (float)correlation_magnitudes.size();
-
-      // Find a point larger than x correlation. 0.1 for normalized often appears to sync to other cells but is still a reliable indicator of PSS being present, so kept it for now.
-      float threshold = pss_sss_times_avg_threshold*avg_correlation;
-      for(int64_t i = 0; i < correlation_magnitudes.size(); i++) {
-        float abs_correlation = std::abs(correlation_magnitudes.at(i)); // We allow correlation to be negative since we are not synchronized at this point. 
-        if(abs_correlation > threshold) {
-          if (abs_correlation > max_corr) {
-            timing_error = i*step_size;
-            pss_found = true;
-            max_corr = abs_correlation;
-            nid2 = pss_idx;
-            timing_error_downsampled_offset = i + downsampled_offset;
+    int32_t subcarrier_offset = 0;
+    if (cfo_bank && !phy->in_synch) {
+      // Initial acquisition under each integer CFO hypothesis
+      cfo_hypothesis_bank::result best;
+      pss_found = cfo_bank->search(downsampled_samples, pss_start, pss_end, best);
+      timing_error = best.position;
+      max_corr = best.correlation;
+      nid2 = best.nid_2;
+      subcarrier_offset = best.subcarrier_offset;
+      timing_error_downsampled_offset = timing_error + downsampled_offset;
+    } else if (coarse_pss && !phy->in_synch) {
+      // Initial acquisition over the whole chunk: coarse pass, then refinement around the candidates
+      pss_found = coarse_pss->search(downsampled_samples, pss_start, pss_end, timing_error, max_corr, nid2);
+      timing_error_downsampled_offset = timing_error + downsampled_offset;
+    } else {
+      for(uint8_t pss_idx = pss_start; pss_idx <= pss_end; pss_idx++) {
+        vector<float> correlation_magnitudes;
+        // Correlate
+        int step_size = 1;
+        correlate_magnitude(correlation_magnitudes, downsampled_samples, {psss[pss_idx].get_pss_seq_t().data(), psss[pss_idx].get_pss_seq_t().size()}, step_size);
+
+        // Get the average
+        float avg_correlation = 0.0f;
+        volk_32f_accumulator_s32f(&avg_correlation, correlation_magnitudes.data(), correlation_magnitudes.size());
+        avg_correlation /= (float)correlation_magnitudes.size();
+
+        // Find a point larger than x correlation. 0.1 for normalized often appears to sync to other cells but is still a reliable indicator of PSS being present, so kept it for now.
+        float threshold = pss_sss_times_avg_threshold*avg_correlation;
+        for(int64_t i = 0; i < correlation_magnitudes.size(); i++) {
+          float abs_correlation = std::abs(correlation_magnitudes.at(i)); // We allow correlation to be negative since we are not synchronized at this point. 
+          if(abs_correlation > threshold) {
+            if (abs_correlation > max_corr) {
+              timing_error = i*step_size;
+              pss_found = true;
+              max_corr = abs_correlation;
+              nid2 = pss_idx;
+              timing_error_downsampled_offset = i + downsampled_offset;
+            }
           }
         }
       }
     }
 
     if (pss_found) {
+      metrics::count(metrics::pss_found);
       // Set PHY NID2
       phy->nid2 = nid2;
       SPDLOG_DEBUG("PSS found max corr {} Setting PHY NID2 to {:}",max_corr, phy->nid2);
@@ -285,6 +352,16 @@ void syncer::find_pss() {
       downsampled_samples.erase(downsampled_samples.begin() + ssb_num_samples_downsampled, downsampled_samples.end());
       assert(downsampled_samples.size() == ssb_num_samples_downsampled);
 
+      // Correct the integer CFO before fine sync, which only resolves half a subcarrier
+      if (subcarrier_offset != 0) {
+        float integer_cfo = (float)subcarrier_offset * phy->ssb_bwp->scs;
+        SPDLOG_DEBUG("Integer CFO of {} subcarriers ({} Hz)", subcarrier_offset, integer_cfo);
+        rotate(downsampled_samples, downsampled_samples, -integer_cfo, phy->ssb_bwp->sample_rate);
+        rotate(processing_queue, processing_queue, -integer_cfo, sample_rate);
+        cfo_integer += integer_cfo;
+        cfo += integer_cfo;
+      }
+
       // Determine approximate location of SSS in full-rate signal. This will be
       // used by fine_time_sync to find the exact location of the SSS.
       uint64_t sss_start_offset = phy->ssb_bwp->samples_per_symbol(2) + phy->ssb_bwp->samples_per_symbol(3) + phy->ssb_bwp->samples_per_cp(4);
@@ -293,8 +370,6 @@ void syncer::find_pss() {
       state = state::fine_sync;
     } else {
       SPDLOG_DEBUG("PSS Not Found, sending to next worker all except a window at the end in case PSS is in between chunks");
-      counting_samples = counting_samples + processing_queue.size();
-
     }
   }
 } 
@@ -307,19 +382,16 @@ void syncer::fine_sync() {
   uint16_t useful_length = phy->ssb_bwp->fft_size;
   uint16_t cp_length = phy->ssb_bwp->samples_per_cp(1); // Get normal CP length
   uint16_t symbol_length = useful_length + cp_length;
-  vector<complex<float>> correlations;
-
-  vector<complex<float>> delayed_samples(downsampled_samples);
-  vector<complex<float>> zeros(useful_length);
-  delayed_samples.insert(delayed_samples.begin(), zeros.begin(), zeros.end());
-  
-  moving_correlate(correlations, {downsampled_samples.data(), downsampled_samples.size()}, {delayed_samples.data(), downsampled_samples.size()}, cp_length);
 
-  // Since we are aligned to the PSS, the locations of normal cyclic
-  // prefixes will be at symbol length *1,*2,*3, and *4 after correlation with
-  // the delayed samples. Sum these to get the average angle. Division is not 
-  // needed because we are not interested in their magnitudes.
-  complex<float> average = correlations[symbol_length*1] + correlations[symbol_length*2] + correlations[symbol_length*3] + correlations[symbol_length*4];
+  // Since we are aligned to the PSS, the windows covering the normal cyclic
+  // prefixes end at symbol length *1,*2,*3, and *4 when correlating with the
+  // samples delayed by the useful symbol length. Only these lags are
+  // evaluated. Sum them to get the average angle. Division is not needed
+  // because we are not interested in their magnitudes.
+  const std::array<size_t, 4> lags = {symbol_length*1u, symbol_length*2u, symbol_length*3u, symbol_length*4u};
+  vector<complex<float>> correlations;
+  cp_correlate(correlations, downsampled_samples, useful_length, cp_length, lags);
+  complex<float> average = correlations[0] + correlations[1] + correlations[2] + correlations[3];
 
   new_cfo_fine = phy->ssb_bwp->scs * (std::arg(average) / (2*std::numbers::pi));
   SPDLOG_DEBUG("NEW CFO fine (Hz): {}", new_cfo_fine);
@@ -332,22 +404,33 @@ void syncer::fine_sync() {
 }
 
 void syncer::find_sss() {
+  // While tracking is healthy, only decode the PBCH of one SSB per pbch_decode_interval and predict the MIB of the
+  // others. The SSS of predicted SSBs is still checked, and the PBCH decoded if it is not found.
+  ssb_mapper->predicting_mib = phy->in_synch && anchored && last_mib_valid && mibs_predicted + 1 < config.pbch_decode_interval;
+  if (!ssb_mapper->predicting_mib)
+    mibs_predicted = 0;
+
   // Create blocks for demodulating SSB
   ofdm ofdm(phy->ssb_bwp);
   ofdm.symbol_index = 2; // We are aligned to the PSS, which is the 3rd symbol in the SSB.
-  auto ssb_mapper = make_shared<class ssb_mapper>(phy);
-
-  // Set block callbacks
-  ssb_mapper->on_sss_found = std::bind(&syncer::on_sss_found, this, std::placeholders::_1);
-  ssb_mapper->on_sss_not_found = std::bind(&syncer::on_sync_lost, this);
-  ssb_mapper->pbch.on_mib_found = std::bind(&syncer::on_mib_found, this, std::placeholders::_1,std::placeholders::_2);
 
   // Make connections
   ofdm.connect(ssb_mapper);
 
   // Process downsampled SSB block
   auto downsampled_samples_ptr = make_shared<vector<complex<float>>>(downsampled_samples);  // TODO allocate downsampled_samples on the heap in the first place so we don't need to do this copy
-  ofdm.process(downsampled_samples_ptr, 0);
+  ofdm.process(downsampled_samples_ptr, frame_metadata());
+}
+
+/**
+ * Predicts the MIB of an SSB whose SSS shows the cell is still tracked.
+ */
+void syncer::on_mib_predictable() {
+  mibs_predicted++;
+  srsran_mib_nr_t mib = last_mib;
+  predicting_mib = true;
+  on_mib_found(mib, true);
+  predicting_mib = false;
 }
 
 void syncer::on_sss_found(uint16_t nid1) {
@@ -359,24 +442,42 @@ void syncer::on_sync_lost() {
   SPDLOG_DEBUG("Lost sync! Retrying to find PSS.");
   state = state::find_pss; // TODO if it failed multiple times, do a full reset?
   //state = state::reset;
-  counting_samples = counting_samples + processing_queue.size();
 }
 
 void syncer::on_mib_found(srsran_mib_nr_t& mib, bool found) {
   if (found == false){
+    last_mib_valid = false;
     on_sync_lost();
   }else{
-  SPDLOG_INFO("Got MIB\nSSB \n Cell ID: {} \n MIB: SFN: {}, SCS: {} ", phy->get_cell_id(), mib.sfn, (int)mib.scs_common);
+  if (predicting_mib) {
+    metrics::count(metrics::mibs_predicted);
+    SPDLOG_DEBUG("Predicting MIB for cell ID {} instead of decoding PBCH", phy->get_cell_id());
+  } else {
+    mibs_predicted = 0;
+    metrics::count(metrics::mibs_decoded);
+    SPDLOG_INFO("Got MIB\nSSB \n Cell ID: {} \n MIB: SFN: {}, SCS: {} ", phy->get_cell_id(), mib.sfn, (int)mib.scs_common);
+  }
+
+  // A predicted MIB takes its SFN and half frame from the previous anchor, before it is reported. The
+  // middle of the SSB slot is labeled, so small timing corrections can't move it into another slot.
+  if (predicting_mib) {
+    frame_metadata ssb_timing = queue_metadata;
+    ssb_timing.sample_index += (int64_t)(sample_rate * seconds_per_frame) / phy->ssb_bwp->slots_per_frame / 2;
+    label_frame_timing(ssb_timing);
+    mib.sfn = ssb_timing.sfn;
+    mib.hrf = ssb_timing.slot_index >= phy->ssb_bwp->slots_per_frame / 2;
+  }
   mib_id++;
   char mib_str[512] = {};
   srsran_pbch_msg_nr_mib_info(&mib, mib_str, sizeof(mib_str));
   SPDLOG_DEBUG("{}", mib_str);
 
   // Update the total CFO so it is applied next time
-  cfo = new_cfo_fine;
+  cfo = cfo_integer + new_cfo_fine;
   rotate(processing_queue, processing_queue, -new_cfo_fine, sample_rate);
 
   SPDLOG_DEBUG("CFO fine (Hz) applied after finding MIB: {}", cfo);
+  on_cell_found(mib, cfo);
 
   // If the initial downlink bandwidth part doesn't exist yet, create it
   // Also create any other bandwidth parts specified in the config file
@@ -384,6 +485,10 @@ void syncer::on_mib_found(srsran_mib_nr_t& mib, bool found) {
     uint32_t flow_index = 0;
 
     for(pdcch_config pdcch_cfg : config.pdcch_configs) {
+      if(pdcch_cfg.carrier != carrier)
+        continue;
+      pdcch_cfg.sample_rate_time = this->sample_rate;
+
       // Override config with MIB
       if(pdcch_cfg.use_config_from_mib) {
         assert(mib.scs_common <= max_numerology);
@@ -395,17 +500,14 @@ void syncer::on_mib_found(srsran_mib_nr_t& mib, bool found) {
         pdcch_cfg.extended_prefix = false;
       }
 
+      // Each cell records its own CORESET grid when sniffing multiple cells
+      if (config.multi_cell && !pdcch_cfg.grid_recording_path.empty()) {
+        pdcch_cfg.grid_recording_path += "." + to_string(phy->get_cell_id());
+      }
+
       // Simplify brute force if we are looking only for SI DCI
       if (pdcch_cfg.si_dci_only) {
-        pdcch_cfg.scrambling_id_start = phy->get_cell_id(); // Scrambling ID for SI DCI is always the cell ID
-        pdcch_cfg.scrambling_id_end = phy->get_cell_id();
-        pdcch_cfg.rnti_start = 65535; // SI-RNTI is always 65535
-        pdcch_cfg.rnti_end = 65535;
-        pdcch_cfg.coreset_interleaving_pattern = "interleaved";
-        pdcch_cfg.coreset_reg_bundle_size = 6;
-        pdcch_cfg.coreset_interleaver_size = 2;
-        pdcch_cfg.coreset_nshift = phy->get_cell_id();
-
+        pdcch_cfg.restrict_to_si_dci(phy->get_cell_id());
       }
 
       auto new_bwp = make_shared<bandwidth_part>(this->sample_rate, pdcch_cfg.numerology, pdcch_cfg.num_prbs, pdcch_cfg.extended_prefix);
@@ -421,15 +523,24 @@ void syncer::on_mib_found(srsran_mib_nr_t& mib, bool found) {
     fine_time_sync();
   }
 
+  last_mib = mib;
+  last_mib_valid = true;
+
+  // The processing queue now starts at the slot carrying the SSB, so the MIB tells us its frame timing
+  anchor_frame_timing(mib);
+
   // Now that we are synced, create a processing flow for each BWP
-  
+  sync_generation++;
+
   assert(phy->bandwidth_parts.size() == phy->channel_mappers.size());
   for(int i = 0; i < phy->bandwidth_parts.size(); i++) {
       auto bwp = phy->bandwidth_parts.at(i);
       auto mapper = phy->channel_mappers.at(i);
-      auto flow = flow_pool->acquire_flow();
+      auto flow = flows->acquire_flow();
       auto rotator = make_shared<class rotator>(this->sample_rate, (float)mapper->pdcch.subcarrier_offset*(float)bwp->scs);
       auto ofdm = make_shared<class ofdm>(bwp);
+      ofdm->sfn = anchor_sfn;
+      ofdm->slot_index = anchor_slot * bwp->slots_per_frame / phy->ssb_bwp->slots_per_frame;
       flow->connect(rotator);
       rotator->connect(ofdm);
       ofdm->connect(mapper); // Connect OFDM block to the shared PHY-layer channel mapper
@@ -451,7 +562,7 @@ void syncer::fine_time_sync() {
   uint64_t start_offset = num_zeros / 2;
 
   // TODO this is actually OFDM modulation. Make OFDM modulator block and add PSS / PBCH DMRS as well to improve correlation
-  auto sss_samples_f = phy->ssss.at((phy->nid1)*3 + phy->nid2);
+  auto sss_samples_f = ssss.generate_sss_seq(phy->nid1, phy->nid2);
   sss_full_rate.insert(sss_full_rate.begin()+start_offset, sss_samples_f.begin(), sss_samples_f.end());
   sss_full_rate.resize(initial_bwp->fft_size);
   
@@ -499,12 +610,10 @@ void syncer::fine_time_sync() {
 
     // Send the part that will be erased from the processing queue to any existing flows, so they can still process these samples
     shared_ptr<vector<complex<float>>> processing_queue_remainder = make_shared<vector<complex<float>>>(std::move(queue_remainder));
-    send_to_next_workers(processing_queue_remainder, counting_samples);
-    counting_samples = counting_samples + processing_queue_remainder->size();
-      
+    send_queue_front(processing_queue_remainder);
 
     // Tell all currently existing flows to finish processing after the workload they received now
-    this->flow_pool->release_flows();
+    this->flows->release_flows();
 
     // Cut the processing queue
     processing_queue.erase(processing_queue.begin(), processing_queue.begin()+timing_error);
@@ -513,5 +622,59 @@ void syncer::fine_time_sync() {
     for(int i = 0; i < abs(timing_error); i++) {
       processing_queue.insert(processing_queue.begin(), complex<float>(0));
     }
+    queue_metadata.sample_index -= abs(timing_error);
   }
 }
+
+/**
+ * Sends samples taken from the front of the processing queue to the next
+ * workers, and advances the metadata of the queue past them.
+ *
+ * @param samples shared_ptr to the samples that were at the front of the queue
+ */
+void syncer::send_queue_front(shared_ptr<vector<complex<float>>> samples) {
+  queue_metadata.cfo = cfo;
+  queue_metadata.sync_generation = sync_generation;
+  label_frame_timing(queue_metadata);
+  send_to_next_workers(samples, queue_metadata);
+  queue_metadata.sample_index += samples->size();
+}
+
+/**
+ * Anchors the frame timing at the start of the processing queue, which fine
+ * time sync aligned to the start of the slot carrying the decoded SSB. SSBs
+ * start at symbols {2, 8} + 14n of the half frame (TS 38.213 4.1, cases A
+ * and C), and the syncer aligns the PSS to symbol 2.
+ *
+ * @param mib decoded MIB, providing the SFN and half frame
+ */
+void syncer::anchor_frame_timing(srsran_mib_nr_t& mib) {
+  if(phy->i_ssb % 2 != 0)
+    SPDLOG_WARN("SSB index {} starts at symbol 8 of its slot, slot labels assume symbol 2", phy->i_ssb);
+
+  anchor_sample_index = queue_metadata.sample_index;
+  anchor_sfn = mib.sfn % frames_per_hyperframe;
+  anchor_slot = (mib.hrf ? phy->ssb_bwp->slots_per_frame / 2 : 0) + phy->i_ssb / 2;
+  anchored = true;
+  SPDLOG_DEBUG("Anchored frame timing at sample {}: SFN {}, SSB slot {}", anchor_sample_index, anchor_sfn, anchor_slot);
+}
+
+/**
+ * Labels metadata with the SFN and slot (in the SSB numerology) of its first
+ * sample, counted from the last frame timing anchor.
+ *
+ * @param metadata metadata to label
+ */
+void syncer::label_frame_timing(frame_metadata& metadata) {
+  if(!anchored)
+    return;
+
+  int64_t samples_per_frame = sample_rate * seconds_per_frame;
+  int64_t samples_per_slot = samples_per_frame / phy->ssb_bwp->slots_per_frame;
+  int64_t offset = anchor_slot * samples_per_slot + (metadata.sample_index - anchor_sample_index);
+  int64_t frames = offset >= 0 ? offset / samples_per_frame : -((-offset + samples_per_frame - 1) / samples_per_frame);
+  int64_t offset_in_frame = offset - frames * samples_per_frame;
+
+  metadata.sfn = ((anchor_sfn + frames) % frames_per_hyperframe + frames_per_hyperframe) % frames_per_hyperframe;
+  metadata.slot_index = offset_in_frame / samples_per_slot;
+}
@@ -0,0 +1,181 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include "task_pool.h"
+#include "config.h"
+#include "metrics.h"
+#include <spdlog/spdlog.h>
+
+extern struct config config;
+
+/**
+ * Constructor for task_pool.
+ *
+ * @param num_threads number of threads, one per hardware thread if 0
+ */
+task_pool::task_pool(size_t num_threads) :
+  stopping(false) {
+  if (num_threads == 0)
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+  for (size_t i = 0; i < num_threads; i++) {
+    threads.emplace_back(&task_pool::run, this);
+  }
+  SPDLOG_DEBUG("Started task pool with {} threads", num_threads);
+}
+
+/**
+ * Destructor for task_pool. Runs the remaining tasks before the threads stop.
+ */
+task_pool::~task_pool() {
+  {
+    lock_guard<mutex> lock(tasks_mutex);
+    stopping = true;
+  }
+  tasks_available.notify_all();
+  for (auto& t : threads) {
+    t.join();
+  }
+}
+
+/**
+ * Creates a pool with fanout_threads threads.
+ */
+shared_ptr<task_pool> task_pool::from_config() {
+  return make_shared<task_pool>(config.fanout_threads);
+}
+
+/**
+ * Schedules a task on the first free thread.
+ *
+ * @param task function to run
+ */
+void task_pool::submit(function<void()> task) {
+  {
+    lock_guard<mutex> lock(tasks_mutex);
+    tasks.push_back(std::move(task));
+  }
+  tasks_available.notify_one();
+}
+
+size_t task_pool::size() {
+  return threads.size();
+}
+
+void task_pool::run() {
+  while (true) {
+    function<void()> task;
+    {
+      unique_lock<mutex> lock(tasks_mutex);
+      tasks_available.wait(lock, [this] { return stopping || !tasks.empty(); });
+      if (tasks.empty())
+        return;
+      task = std::move(tasks.front());
+      tasks.pop_front();
+    }
+    task();
+  }
+}
+
+/**
+ * Constructor for task_queue.
+ *
+ * @param pool pool whose threads run the tasks
+ */
+task_queue::task_queue(shared_ptr<task_pool> pool) :
+  pool(pool),
+  num_pending(0),
+  running(false) {
+}
+
+/**
+ * Destructor for task_queue. Waits for the pending tasks, as they may refer
+ * to the queue owner.
+ */
+task_queue::~task_queue() {
+  unique_lock<mutex> lock(tasks_mutex);
+  tasks_done.wait(lock, [this] { return num_pending == 0; });
+}
+
+/**
+ * Appends a task to the queue. A pool thread is only claimed while the queue
+ * has tasks, so idle queues cost nothing.
+ *
+ * @param task function to run after all previously pushed tasks
+ */
+void task_queue::push(function<void()> task) {
+  lock_guard<mutex> lock(tasks_mutex);
+  tasks.push_back(std::move(task));
+  num_pending++;
+  metrics::add_gauge(metrics::fanout_tasks_pending, 1);
+  if (!running) {
+    running = true;
+    pool->submit([this] { run_tasks(); });
+  }
+}
+
+/**
+ * Blocks until at most max_pending tasks are queued or running. Must not be
+ * called from a task of the same pool, which could then wait on itself.
+ *
+ * @param max_pending number of tasks that may still be pending, 0 to wait for all
+ */
+void task_queue::wait(size_t max_pending) {
+  unique_lock<mutex> lock(tasks_mutex);
+  tasks_done.wait(lock, [&] { return num_pending <= max_pending; });
+  if (error) {
+    exception_ptr e = error;
+    error = nullptr;
+    rethrow_exception(e);
+  }
+}
+
+/**
+ * Number of tasks queued or running.
+ */
+size_t task_queue::pending() {
+  lock_guard<mutex> lock(tasks_mutex);
+  return num_pending;
+}
+
+void task_queue::run_tasks() {
+  unique_lock<mutex> lock(tasks_mutex);
+  while (running) {
+    function<void()> task = std::move(tasks.front());
+    tasks.pop_front();
+    lock.unlock();
+    try {
+      task();
+    } catch (...) {
+      lock.lock();
+      if (!error)
+        error = current_exception();
+      lock.unlock();
+    }
+    lock.lock();
+
+    // Stop running before the last task is marked as done, as the queue may be destroyed right after
+    running = !tasks.empty();
+    num_pending--;
+    metrics::add_gauge(metrics::fanout_tasks_pending, -1);
+    tasks_done.notify_all();
+  }
+}
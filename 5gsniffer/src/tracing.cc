@@ -0,0 +1,233 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include "tracing.h"
+#include "config.h"
+#include <vector>
+#include <mutex>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <spdlog/spdlog.h>
+
+extern struct config config;
+
+namespace tracing {
+  atomic<bool> enabled(false);
+
+  struct event {
+    const char* name;
+    int64_t start_ns;
+    int64_t end_ns;
+  };
+
+  /**
+   * Ring of the most recent events of a single thread. Only that thread
+   * writes it: it advances writing before it overwrites a slot, and head
+   * once the event is complete, so readers can tell which slots changed.
+   */
+  struct ring {
+    vector<event> events;
+    atomic<uint64_t> head{0};
+    atomic<uint64_t> writing{0};
+    uint32_t tid;
+  };
+
+  struct registry {
+    mutex rings_mutex;
+    vector<shared_ptr<ring>> rings;
+    size_t events_per_thread = 65536;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  };
+
+  static registry& get_registry() {
+    static registry r;
+    return r;
+  }
+
+  static ring& local_ring() {
+    thread_local shared_ptr<ring> r = [] {
+      auto new_ring = make_shared<ring>();
+      registry& reg = get_registry();
+      lock_guard<mutex> lock(reg.rings_mutex);
+      new_ring->events.resize(reg.events_per_thread);
+      new_ring->tid = reg.rings.size() + 1;
+      reg.rings.push_back(new_ring);
+      return new_ring;
+    }();
+    return *r;
+  }
+
+  /**
+   * Starts recording. Rings are created on the first event of each thread.
+   *
+   * @param events_per_thread number of most recent events kept per thread
+   */
+  void enable(size_t events_per_thread) {
+    {
+      registry& reg = get_registry();
+      lock_guard<mutex> lock(reg.rings_mutex);
+      reg.events_per_thread = std::max<size_t>(events_per_thread, 1);
+    }
+    enabled = true;
+  }
+
+  /**
+   * Nanoseconds since the start of the process, or rather of the tracer.
+   */
+  int64_t now_ns() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - get_registry().start).count();
+  }
+
+  /**
+   * Appends an event to the ring of the calling thread, overwriting its
+   * oldest event if the ring is full.
+   *
+   * @param name name of the event, must outlive the trace
+   * @param start_ns start time from now_ns
+   * @param end_ns end time from now_ns
+   */
+  void record(const char* name, int64_t start_ns, int64_t end_ns) {
+    ring& r = local_ring();
+    uint64_t head = r.head.load(memory_order_relaxed);
+    r.writing.store(head + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    r.events[head % r.events.size()] = {name, start_ns, end_ns};
+    r.head.store(head + 1, memory_order_release);
+  }
+
+  /**
+   * Formats the events of all threads as Chrome trace JSON. Threads keep
+   * recording meanwhile, so events that may have been overwritten while they
+   * were copied are left out.
+   */
+  string to_chrome_json() {
+    registry& reg = get_registry();
+    vector<shared_ptr<ring>> rings;
+    {
+      lock_guard<mutex> lock(reg.rings_mutex);
+      rings = reg.rings;
+    }
+
+    string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    bool first = true;
+    for (auto& r : rings) {
+      out += fmt::format("{}{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":\"thread {}\"}}}}", first ? "" : ",\n", r->tid, r->tid);
+      first = false;
+
+      size_t size = r->events.size();
+      uint64_t head = r->head.load(memory_order_acquire);
+      uint64_t begin = head > size ? head - size : 0;
+      vector<event> copy;
+      copy.reserve(head - begin);
+      for (uint64_t i = begin; i < head; i++) {
+        copy.push_back(r->events[i % size]);
+      }
+
+      // Drop the events the thread overwrote, or started to, while copying
+      atomic_thread_fence(memory_order_acquire);
+      uint64_t writing = r->writing.load(memory_order_relaxed);
+      size_t overwritten = writing > size ? std::min<uint64_t>(writing - size - begin, copy.size()) : 0;
+      for (size_t i = overwritten; i < copy.size(); i++) {
+        event& e = copy[i];
+        out += fmt::format(",\n{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+          e.name, r->tid, e.start_ns / 1e3, (e.end_ns - e.start_ns) / 1e3);
+      }
+    }
+    out += "\n]}\n";
+    return out;
+  }
+
+  /**
+   * Writes the trace to a file.
+   *
+   * @param path path of the JSON file
+   */
+  bool write_chrome_json(string path) {
+    ofstream f(path, ios::trunc);
+    f << to_chrome_json();
+    if (!f) {
+      SPDLOG_WARN("Could not write trace to {}", path);
+      return false;
+    }
+    SPDLOG_INFO("Wrote trace to {}", path);
+    return true;
+  }
+
+  static volatile sig_atomic_t pending_signal = 0;
+
+  static void on_signal(int signal) {
+    pending_signal = signal;
+  }
+
+  /**
+   * Constructor for session.
+   *
+   * @param path path to write the Chrome trace JSON to
+   * @param events_per_thread number of most recent events kept per thread
+   */
+  session::session(string path, size_t events_per_thread) :
+    path(path),
+    stopping(false) {
+    enable(events_per_thread);
+    std::signal(SIGUSR1, on_signal);
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    t = thread(&session::handle_signals, this);
+    SPDLOG_INFO("Tracing to {}, send SIGUSR1 to write the trace so far", path);
+  }
+
+  session::~session() {
+    stopping = true;
+    t.join();
+    enabled = false;
+    std::signal(SIGUSR1, SIG_DFL);
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    write_chrome_json(path);
+  }
+
+  /**
+   * Creates a session for trace_file, or nullptr if it is not set.
+   */
+  unique_ptr<session> session::from_config() {
+    if (config.trace_file.empty())
+      return nullptr;
+    return make_unique<session>(config.trace_file, config.trace_events_per_thread);
+  }
+
+  /**
+   * Writes the trace when signalled, outside of the signal handler. SIGINT
+   * and SIGTERM then exit, as they would have without the tracer.
+   */
+  void session::handle_signals() {
+    while (!stopping) {
+      int signal = pending_signal;
+      if (signal != 0) {
+        pending_signal = 0;
+        write_chrome_json(path);
+        if (signal != SIGUSR1)
+          std::_Exit(128 + signal);
+      }
+      this_thread::sleep_for(chrono::milliseconds(100));
+    }
+  }
+}
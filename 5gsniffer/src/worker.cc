@@ -20,7 +20,9 @@
  */
 
 #include "worker.h"
+#include "metrics.h"
 #include <cstddef>
+#include <chrono>
 #include <spdlog/spdlog.h>
 
 /** 
@@ -29,6 +31,8 @@
 worker::worker() {
   finished = false;
   total_produced_samples = 0;
+  fanout_queue_depth = 0;
+  fanout_force_queue = false;
 }
 
 /** 
@@ -66,6 +70,8 @@ shared_ptr<vector<complex<float>>> worker::produce_samples(size_t num_samples) {
  */
 void worker::connect(shared_ptr<worker> w) {
   this->next_workers.push_back(w);
+  if (fanout_pool)
+    this->edge_queues.push_back(make_unique<task_queue>(fanout_pool));
 }
 
 /** 
@@ -74,14 +80,59 @@ void worker::connect(shared_ptr<worker> w) {
  * @param worker pointer to a worker
  */
 void worker::disconnect(shared_ptr<worker> w) {
-  this->next_workers.erase(find(this->next_workers.begin(), this->next_workers.end(), w));
+  auto it = find(this->next_workers.begin(), this->next_workers.end(), w);
+  if (!edge_queues.empty()) {
+    auto& queue = edge_queues.at(it - this->next_workers.begin());
+    queue->wait();
+    this->edge_queues.erase(edge_queues.begin() + (it - this->next_workers.begin()));
+  }
+  this->next_workers.erase(it);
 }
 
 /** 
  * Used to disconnect all subsequent workers from this worker.
  */
 void worker::disconnect_all() {
+  join_next_workers();
   this->next_workers.clear();
+  this->edge_queues.clear();
+}
+
+/** 
+ * Makes the next workers run in parallel on a shared pool of threads. Every
+ * edge to a next worker gets its own queue, so each next worker still sees its
+ * buffers in order. Only enable it if the next workers do not share state and
+ * leave their input untouched.
+ *
+ * @param pool pool to run the next workers on, or nullptr to run them in turn
+ * @param queue_depth number of buffers an edge may still have pending when
+ * send_to_next_workers returns, 0 to wait until all next workers are done
+ * @param force_queue also queue the buffers of a lone next worker, which is
+ * otherwise run on the calling thread
+ */
+void worker::set_parallel_fanout(shared_ptr<task_pool> pool, size_t queue_depth, bool force_queue) {
+  join_next_workers();
+  edge_queues.clear();
+  fanout_pool = pool;
+  fanout_queue_depth = queue_depth;
+  fanout_force_queue = force_queue;
+  if (fanout_pool) {
+    for (size_t i = 0; i < next_workers.size(); i++) {
+      edge_queues.push_back(make_unique<task_queue>(fanout_pool));
+    }
+  }
+}
+
+/** 
+ * Waits for the next workers to process their pending buffers, and rethrows
+ * any exception they threw. Does nothing without parallel fan-out.
+ *
+ * @param max_pending number of buffers each edge may still have pending
+ */
+void worker::join_next_workers(size_t max_pending) {
+  for (auto& queue : edge_queues) {
+    queue->wait(max_pending);
+  }
 }
 
 
@@ -93,7 +144,23 @@ void worker::disconnect_all() {
  */
 void worker::work(size_t num_samples) {
   shared_ptr<vector<complex<float>>> produced_samples = this->produce_samples(num_samples);
-  this->send_to_next_workers(produced_samples, total_produced_samples);
+  metrics::count(metrics::chunks_in);
+  metrics::count(metrics::samples_in, produced_samples->size());
+
+  frame_metadata metadata;
+  metadata.sample_index = total_produced_samples - produced_samples->size();
+  metadata.timestamp_ns = get_timestamp_ns(metadata.sample_index);
+  this->send_to_next_workers(produced_samples, metadata);
+}
+
+/** 
+ * Gets the time at which a produced sample was received. By default this is
+ * the current time, producers that know better can override it.
+ *
+ * @param sample_index index of the sample in the produced stream
+ */
+int64_t worker::get_timestamp_ns(int64_t sample_index) {
+  return chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
 }
 
 /**
@@ -111,9 +178,12 @@ void worker::finish() {
  * their workload.
  */
 void worker::disconnect_finished() {
+  join_next_workers();
   auto it = this->next_workers.begin();
   while(it != this->next_workers.end()) {
     if(it->get()->finished) {
+      if (!edge_queues.empty())
+        this->edge_queues.erase(edge_queues.begin() + (it - this->next_workers.begin()));
       it = this->next_workers.erase(it);
     } else {
       it++;
@@ -127,6 +197,7 @@ void worker::disconnect_finished() {
  * disconnected so their resources are freed.
  */
 void worker::finish_next_workers() {
+  join_next_workers();
   for (const auto& worker : this->next_workers) {
     worker->finish();
   }
@@ -0,0 +1,120 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include "gtest/gtest.h"
+#include "active_rnti_table.h"
+#include "metrics.h"
+
+using namespace std;
+
+TEST(active_rnti_table_test, records_per_rnti_statistics) {
+  active_rnti_table table(2.0);
+  EXPECT_TRUE(table.update(17921, 1.0, 4, 39, 500));
+  EXPECT_FALSE(table.update(17921, 1.5, 8, 41, 501));
+  EXPECT_TRUE(table.update(65535, 1.2, 8, 39, 1));
+  EXPECT_EQ(table.size(), 2);
+
+  auto snapshot = table.get_snapshot();
+  ASSERT_EQ(snapshot.size(), 2);
+  EXPECT_EQ(snapshot.at(0).rnti, 17921);
+  EXPECT_DOUBLE_EQ(snapshot.at(0).first_seen, 1.0);
+  EXPECT_DOUBLE_EQ(snapshot.at(0).last_seen, 1.5);
+  EXPECT_EQ(snapshot.at(0).dci_count, 2);
+  EXPECT_EQ(snapshot.at(0).aggregation_levels, 4 | 8);
+  EXPECT_EQ(snapshot.at(0).dci_sizes, set<uint8_t>({39, 41}));
+  EXPECT_EQ(snapshot.at(0).scrambling_id, 501);
+  EXPECT_EQ(snapshot.at(1).rnti, 65535);
+}
+
+TEST(active_rnti_table_test, expires_inactive_rntis) {
+  int64_t gauge_before = metrics::get_gauge(metrics::active_rntis);
+  active_rnti_table table(2.0);
+  table.update(100, 0.0, 1, 39, 0);
+  table.update(200, 1.0, 1, 39, 0);
+  EXPECT_EQ(metrics::get_gauge(metrics::active_rntis) - gauge_before, 2);
+
+  EXPECT_TRUE(table.expire(1.9).empty());
+  EXPECT_EQ(table.expire(2.0), vector<uint16_t>({100}));
+  EXPECT_FALSE(table.contains(100));
+
+  // A DCI keeps the RNTI active
+  table.update(200, 2.5, 1, 39, 0);
+  EXPECT_TRUE(table.expire(3.5).empty());
+  EXPECT_EQ(table.expire(4.5), vector<uint16_t>({200}));
+  EXPECT_EQ(table.size(), 0);
+  EXPECT_EQ(metrics::get_gauge(metrics::active_rntis), gauge_before);
+
+  // An expired RNTI becomes active again with its next DCI
+  EXPECT_TRUE(table.update(100, 5.0, 1, 39, 0));
+}
+
+TEST(active_rnti_table_test, writes_csv_snapshot) {
+  active_rnti_table table(10.0);
+  table.update(300, 0.5, 2, 39, 42);
+  table.update(300, 0.75, 16, 27, 42);
+
+  string path = testing::TempDir() + "active_rntis.csv";
+  ASSERT_TRUE(table.write_file(path));
+  ifstream f(path);
+  stringstream contents;
+  contents << f.rdbuf();
+  EXPECT_EQ(contents.str(), "rnti,first_seen,last_seen,dci_count,aggregation_levels,dci_sizes,scrambling_id\n"
+                            "300,0.500000,0.750000,2,2 16,27 39,42\n");
+  std::remove(path.c_str());
+}
+
+TEST(active_rnti_table_test, writer_writes_on_request) {
+  string path = testing::TempDir() + "active_rntis_writer.csv";
+  std::remove(path.c_str());
+  {
+    active_rnti_table table(10.0);
+    table.start_writer(path, 10.0);
+    table.update(400, 1.0, 4, 41, 7);
+    table.request_write(1.0);
+  }
+
+  // The writer has written the file at the latest when the table is destroyed
+  ifstream f(path);
+  stringstream contents;
+  contents << f.rdbuf();
+  EXPECT_EQ(contents.str(), "rnti,first_seen,last_seen,dci_count,aggregation_levels,dci_sizes,scrambling_id\n"
+                            "400,1.000000,1.000000,1,4,41,7\n");
+  std::remove(path.c_str());
+}
+
+TEST(active_rnti_table_test, counts_the_listed_rntis) {
+  active_rnti_table table(2.0, 100, 65519);
+  table.update(17921, 1.0, 4, 39, 500);
+  table.update(65535, 1.0, 8, 39, 1);
+  table.update(50, 1.5, 8, 39, 1);
+  EXPECT_EQ(table.size(), 3);
+  EXPECT_EQ(table.listed_size(), 1);
+
+  table.update(200, 2.5, 1, 39, 0);
+  EXPECT_EQ(table.listed_size(), 2);
+  table.expire(3.0);
+  EXPECT_EQ(table.size(), 2);
+  EXPECT_EQ(table.listed_size(), 1);
+}
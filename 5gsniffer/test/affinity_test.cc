@@ -0,0 +1,50 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <vector>
+#include <sched.h>
+#include "gtest/gtest.h"
+#include "affinity.h"
+#include "exceptions.h"
+
+using namespace std;
+
+class affinity_test : public ::testing::Test {
+ protected:
+  affinity_test() {
+  }
+};
+
+TEST_F(affinity_test, parse_cpu_list) {
+  EXPECT_EQ(parse_cpu_list("0-3,8,10-11"), vector<int>({0, 1, 2, 3, 8, 10, 11}));
+  EXPECT_EQ(parse_cpu_list("5\n"), vector<int>({5}));
+  EXPECT_EQ(parse_cpu_list(""), vector<int>());
+  EXPECT_THROW(parse_cpu_list("3-1"), config_exception);
+  EXPECT_THROW(parse_cpu_list("a"), config_exception);
+  EXPECT_THROW(parse_cpu_list("1-2x"), config_exception);
+  EXPECT_THROW(parse_cpu_list("0-" + to_string(CPU_SETSIZE)), config_exception);
+}
+
+TEST_F(affinity_test, is_cpu_online) {
+  EXPECT_TRUE(is_cpu_online(0));
+  EXPECT_FALSE(is_cpu_online(-1));
+  EXPECT_FALSE(is_cpu_online(CPU_SETSIZE));
+}
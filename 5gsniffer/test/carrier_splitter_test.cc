@@ -0,0 +1,112 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+
+#include <cstdint>
+#include <vector>
+#include <complex>
+#include <numbers>
+#include <span>
+#include <memory>
+#include "gtest/gtest.h"
+#include "carrier_splitter.h"
+#include "config.h"
+
+using namespace std;
+
+/**
+ * Worker that collects the samples and metadata of a carrier.
+ */
+class carrier_collector : public worker {
+  public:
+    void process(shared_ptr<vector<complex<float>>>& samples, const frame_metadata& metadata) override {
+      metadatas.push_back(metadata);
+      collected.insert(collected.end(), samples->begin(), samples->end());
+    }
+    vector<frame_metadata> metadatas;
+    vector<complex<float>> collected;
+};
+
+class carrier_splitter_test : public ::testing::Test {
+ protected:
+  carrier_splitter_test() {
+  }
+
+  /**
+   * Frequency of the strongest tone, from the mean phase step between samples.
+   */
+  double tone_frequency(span<const complex<float>> samples, double sample_rate) {
+    complex<double> sum = 0;
+    for(size_t i = 1; i < samples.size(); i++)
+      sum += complex<double>(samples[i]) * conj(complex<double>(samples[i - 1]));
+    return std::arg(sum) * sample_rate / (2 * std::numbers::pi);
+  }
+};
+
+TEST_F(carrier_splitter_test, carriers_are_shifted_to_baseband_with_their_metadata) {
+  uint64_t sample_rate = 23'040'000;
+  double center_frequency = 3'500'000'000;
+
+  // 8 channels 2.88 MHz apart: the carriers are 120 kHz above channel 1 and 260 kHz above channel 6
+  vector<carrier_config> carriers = {{center_frequency + 3'000'000, 3'600'000}, {center_frequency - 5'500'000, 3'600'000}};
+  carrier_splitter splitter(sample_rate, center_frequency, carriers);
+  ASSERT_EQ(splitter.carrier_sample_rate, sample_rate / 2);
+  vector<shared_ptr<carrier_collector>> collectors;
+  for(size_t carrier = 0; carrier < carriers.size(); carrier++) {
+    collectors.push_back(make_shared<carrier_collector>());
+    splitter.connect_carrier(carrier, collectors.back());
+  }
+
+  // A tone 200 kHz above the first carrier, and one 300 kHz below the second
+  size_t num_samples = 4608;
+  vector<double> tones = {3'200'000, -5'800'000};
+  for(int64_t buffer = 0; buffer < 2; buffer++) {
+    auto samples = make_shared<vector<complex<float>>>(num_samples);
+    for(size_t i = 0; i < num_samples; i++) {
+      double t = (double)(buffer * num_samples + i) / sample_rate;
+      for(double tone : tones)
+        samples->at(i) += std::polar(1.0, 2 * std::numbers::pi * tone * t);
+    }
+    frame_metadata metadata;
+    metadata.sample_index = buffer * num_samples;
+    metadata.timestamp_ns = 1000 + buffer * 200'000;
+    metadata.sfn = 5;
+    splitter.process(samples, metadata);
+  }
+
+  for(size_t carrier = 0; carrier < carriers.size(); carrier++) {
+    auto& collector = *collectors.at(carrier);
+
+    // The sample index counts samples at the carrier sample rate, the rest is passed on
+    ASSERT_EQ(collector.metadatas.size(), 2);
+    for(int64_t buffer = 0; buffer < 2; buffer++) {
+      EXPECT_EQ(collector.metadatas.at(buffer).sample_index, buffer * num_samples / 2);
+      EXPECT_EQ(collector.metadatas.at(buffer).timestamp_ns, 1000 + buffer * 200'000);
+      EXPECT_EQ(collector.metadatas.at(buffer).sfn, 5);
+    }
+    ASSERT_EQ(collector.collected.size(), num_samples);
+
+    // The SSB center of the carrier is at baseband, skipping the filter transient
+    double expected = tones.at(carrier) - (carriers.at(carrier).frequency - center_frequency);
+    double measured = tone_frequency({collector.collected.data() + 512, collector.collected.size() - 512}, splitter.carrier_sample_rate);
+    EXPECT_NEAR(measured, expected, 1000) << "carrier " << carrier;
+  }
+}
@@ -0,0 +1,86 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <cstdint>
+#include <vector>
+#include <complex>
+#include <numbers>
+#include <random>
+#include "gtest/gtest.h"
+#include "cfo_hypothesis_bank.h"
+#include "pss.h"
+
+using namespace std;
+
+class cfo_hypothesis_bank_test : public ::testing::Test {
+ protected:
+  cfo_hypothesis_bank_test() {
+  }
+};
+
+TEST_F(cfo_hypothesis_bank_test, finds_integer_cfo) {
+  pss generator;
+  auto pss_seq_t = generator.convert_pss_t(generator.generate_pss_seq(2));
+
+  mt19937 rng(7);
+  normal_distribution<float> noise(0.0f, 2.0f);
+  vector<complex<float>> samples(1000);
+  for(auto& sample : samples) {
+    sample = {noise(rng), noise(rng)};
+  }
+  int64_t pss_position = 321;
+  for(int i = 0; i < ssb_nfft; i++) {
+    samples.at(pss_position + i) += pss_seq_t.at(i);
+  }
+
+  for(int32_t subcarrier_offset : {-2, 0, 3}) {
+    // Shift the whole input up by the CFO
+    vector<complex<float>> shifted(samples.size());
+    for(size_t n = 0; n < samples.size(); n++) {
+      shifted[n] = samples[n] * polar(1.0f, (float)(2 * numbers::pi * subcarrier_offset * (double)n / ssb_nfft));
+    }
+
+    cfo_hypothesis_bank bank({-3, -2, -1, 0, 1, 2, 3});
+    cfo_hypothesis_bank::result best;
+    ASSERT_TRUE(bank.search(shifted, 0, 2, best));
+    EXPECT_EQ(best.subcarrier_offset, subcarrier_offset);
+    EXPECT_EQ(best.position, pss_position);
+    EXPECT_EQ(best.nid_2, 2);
+    ASSERT_EQ(bank.results.size(), 7u);
+  }
+}
+
+TEST_F(cfo_hypothesis_bank_test, rejects_noise) {
+  mt19937 rng(11);
+  normal_distribution<float> noise(0.0f, 1.0f);
+  vector<complex<float>> samples(1000);
+  for(auto& sample : samples) {
+    sample = {noise(rng), noise(rng)};
+  }
+
+  // The peak of pure noise is only a few times its average
+  cfo_hypothesis_bank bank({-3, -2, -1, 0, 1, 2, 3}, 0, make_shared<task_pool>(2), 5.0f);
+  cfo_hypothesis_bank::result best;
+  EXPECT_FALSE(bank.search(samples, 0, 2, best));
+  for(auto& result : bank.results) {
+    EXPECT_FALSE(result.found);
+  }
+}
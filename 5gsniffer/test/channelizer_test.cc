@@ -0,0 +1,109 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <cstdint>
+#include <vector>
+#include <complex>
+#include <numbers>
+#include "gtest/gtest.h"
+#include "channelizer.h"
+
+using namespace std;
+
+class channelizer_test : public ::testing::Test {
+ protected:
+  channelizer_test() {
+  }
+
+  vector<complex<float>> tone(size_t num_samples, double frequency) {
+    vector<complex<float>> samples(num_samples);
+    for(size_t i = 0; i < num_samples; i++)
+      samples[i] = std::polar(1.0, 2 * std::numbers::pi * frequency * i);
+    return samples;
+  }
+};
+
+TEST_F(channelizer_test, tone_is_brought_to_baseband) {
+  uint32_t num_channels = 16;
+  uint32_t decimation = 4;
+  channelizer c(num_channels, decimation);
+
+  // Tone at 3.2 channel spacings, i.e. 0.2 spacings above the center of channel 3
+  double spacing = 1.0 / num_channels;
+  auto input = tone(8192, 3.2 * spacing);
+  vector<vector<complex<float>>> outputs;
+  c.execute(input, outputs);
+
+  ASSERT_EQ(outputs.size(), num_channels);
+  ASSERT_EQ(outputs.at(3).size(), input.size() / decimation);
+  EXPECT_EQ(c.nearest_channel(3.2 * spacing, 1), 3);
+  EXPECT_EQ(c.nearest_channel(-0.9 * spacing, 1), 15);
+
+  // Skip the filter transient
+  double expected_rotation = 2 * std::numbers::pi * 0.2 * spacing * decimation;
+  for(size_t n = 100; n < outputs.at(3).size(); n++) {
+    EXPECT_NEAR(std::abs(outputs.at(3).at(n)), 1.0, 0.01);
+    EXPECT_NEAR(std::arg(outputs.at(3).at(n) * std::conj(outputs.at(3).at(n - 1))), expected_rotation, 1e-3);
+    EXPECT_NEAR(std::abs(outputs.at(4).at(n)), 1.0, 0.01); // Adjacent channels overlap
+    EXPECT_LT(std::abs(outputs.at(6).at(n)), 1e-3);
+    EXPECT_LT(std::abs(outputs.at(12).at(n)), 1e-3);
+  }
+}
+
+TEST_F(channelizer_test, chunks_are_processed_as_a_stream) {
+  uint32_t num_channels = 8;
+  uint32_t decimation = 2;
+  channelizer whole(num_channels, decimation);
+  channelizer chunked(num_channels, decimation);
+
+  auto input = tone(1000, 0.3);
+  vector<vector<complex<float>>> expected;
+  whole.execute(input, expected);
+
+  vector<vector<complex<float>>> outputs(num_channels);
+  vector<vector<complex<float>>> chunk_outputs;
+  size_t chunk_sizes[] = {1, 333, 7, 659};
+  size_t position = 0;
+  for(size_t chunk_size : chunk_sizes) {
+    chunked.execute(span<complex<float>>(input.data() + position, chunk_size), chunk_outputs);
+    for(uint32_t k = 0; k < num_channels; k++)
+      outputs[k].insert(outputs[k].end(), chunk_outputs[k].begin(), chunk_outputs[k].end());
+    position += chunk_size;
+  }
+
+  for(uint32_t k = 0; k < num_channels; k++) {
+    ASSERT_EQ(outputs[k].size(), expected[k].size());
+    for(size_t n = 0; n < outputs[k].size(); n++) {
+      EXPECT_NEAR(std::abs(outputs[k][n] - expected[k][n]), 0.0, 1e-5);
+    }
+  }
+}
+
+TEST_F(channelizer_test, number_of_channels) {
+  // 11.8 MHz spacing needed for a 20 MHz carrier
+  EXPECT_EQ(channelizer::get_num_channels(122880000, 10e6, 15000), 8);
+  EXPECT_EQ(channelizer::get_num_channels(46080000, 10e6, 15000), 4);
+  // 2.1 MHz spacing needed for an SSB
+  EXPECT_EQ(channelizer::get_num_channels(46080000, 1.8e6), 20);
+  EXPECT_EQ(channelizer::get_num_channels(23040000, 1.8e6, 15000), 8);
+  // 61.44 MHz cannot be decimated by 7 to a whole rate, but by 6 it can
+  EXPECT_EQ(channelizer::get_num_channels(61440000, 1.8e6), 24);
+}
@@ -0,0 +1,82 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <cstdint>
+#include "gtest/gtest.h"
+#include "cost_estimator.h"
+#include "config.h"
+
+using namespace std;
+
+class cost_estimator_test : public ::testing::Test {
+ protected:
+  cost_estimator_test() {
+    pdcch_cfg = {};
+    pdcch_cfg.scrambling_id_start = 10;
+    pdcch_cfg.scrambling_id_end = 13;
+    pdcch_cfg.rnti_start = 1000;
+    pdcch_cfg.rnti_end = 1099;
+    pdcch_cfg.rnti_list_length = 20;
+    pdcch_cfg.dci_sizes_list = {39, 41};
+    pdcch_cfg.num_candidates_per_AL = {8, 4, 2, 1, 1};
+  }
+
+  pdcch_config pdcch_cfg;
+};
+
+TEST_F(cost_estimator_test, counts_follow_the_search_space) {
+  auto w = cost_estimator::count_workload(pdcch_cfg);
+
+  // 4 scrambling IDs times the candidates of each AL
+  EXPECT_EQ(w.correlations[0], 32);
+  EXPECT_EQ(w.correlations[4], 4);
+  EXPECT_EQ(w.total_correlations(), 64);
+  EXPECT_EQ(w.total_equalizations(), 128);
+
+  // Low ALs decode rnti_list_length RNTIs, AL 8 and 16 decode once and scan all 100 RNTIs
+  EXPECT_EQ(w.decodes[0], 32 * 2 * 20);
+  EXPECT_EQ(w.decodes[3], 4 * 2);
+  EXPECT_EQ(w.repetition_rntis[3], 4 * 2 * 100);
+  EXPECT_EQ(w.repetition_rntis[0], 0);
+}
+
+TEST_F(cost_estimator_test, si_dci_only_searches_one_scrambling_id_and_rnti) {
+  pdcch_cfg.si_dci_only = true;
+  auto w = cost_estimator::count_workload(pdcch_cfg);
+  EXPECT_EQ(w.total_correlations(), 16);
+  EXPECT_EQ(w.decodes[0], 8 * 2);
+  // The SI-RNTI is decoded for every candidate of AL 8 and 16
+  EXPECT_EQ(w.decodes[4], 2);
+  EXPECT_EQ(w.repetition_rntis[4], 2);
+}
+
+TEST_F(cost_estimator_test, cost_scales_with_the_kernel_costs) {
+  auto w = cost_estimator::count_workload(pdcch_cfg);
+  cost_estimator::kernel_costs costs;
+  costs.correlation.fill(1e-6);
+  costs.decode.fill(1e-5);
+  costs.repetition_rnti = 1e-8;
+
+  EXPECT_NEAR(cost_estimator::idle_seconds_per_slot(w, costs), 64e-6, 1e-12);
+  double decodes = (32 + 16 + 8) * 2 * 20 + (4 + 4) * 2;
+  EXPECT_NEAR(cost_estimator::worst_seconds_per_slot(w, costs), 64e-6 + decodes * 1e-5 + 8 * 2 * 100 * 1e-8, 1e-12);
+  EXPECT_EQ(cost_estimator::slots_per_second(pdcch_cfg), 1000);
+}
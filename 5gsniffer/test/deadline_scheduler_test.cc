@@ -0,0 +1,113 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <chrono>
+#include <vector>
+#include "gtest/gtest.h"
+#include "deadline_scheduler.h"
+#include "exceptions.h"
+#include "metrics.h"
+
+using namespace std;
+
+class deadline_scheduler_test : public ::testing::Test {
+ protected:
+  deadline_scheduler_test() :
+    scheduler(chrono::microseconds(500), {shed_step::low_al, shed_step::rnti_list, shed_step::scrambling_ids}, 4, 3) {
+  }
+
+  deadline_scheduler scheduler;
+};
+
+TEST_F(deadline_scheduler_test, sheds_in_order_when_over_budget) {
+  uint64_t over_before = metrics::get_counter(metrics::slots_over_budget);
+  EXPECT_FALSE(scheduler.skip_aggregation_level(0));
+  EXPECT_EQ(scheduler.rnti_limit(100), 100);
+
+  scheduler.slot_done(chrono::microseconds(400));
+  EXPECT_EQ(scheduler.get_level(), 0);
+
+  scheduler.slot_done(chrono::microseconds(600));
+  EXPECT_EQ(scheduler.get_level(), 1);
+  EXPECT_TRUE(scheduler.skip_aggregation_level(0));
+  EXPECT_TRUE(scheduler.skip_aggregation_level(1));
+  EXPECT_FALSE(scheduler.skip_aggregation_level(2));
+  EXPECT_EQ(scheduler.rnti_limit(100), 100);
+
+  scheduler.slot_done(chrono::microseconds(600));
+  EXPECT_EQ(scheduler.rnti_limit(100), 4);
+  EXPECT_EQ(scheduler.rnti_limit(2), 2);
+  EXPECT_FALSE(scheduler.is_shedding(shed_step::scrambling_ids));
+
+  scheduler.slot_done(chrono::microseconds(600));
+  scheduler.slot_done(chrono::microseconds(600));
+  EXPECT_EQ(scheduler.get_level(), 3);
+  EXPECT_TRUE(scheduler.is_shedding(shed_step::scrambling_ids));
+  EXPECT_EQ(metrics::get_counter(metrics::slots_over_budget) - over_before, 4);
+}
+
+TEST_F(deadline_scheduler_test, recovers_after_slots_under_half_the_budget) {
+  scheduler.slot_done(chrono::microseconds(600));
+  scheduler.slot_done(chrono::microseconds(600));
+  EXPECT_EQ(scheduler.get_level(), 2);
+
+  // Slots between half the budget and the budget neither shed nor recover
+  for (int i = 0; i < 10; i++)
+    scheduler.slot_done(chrono::microseconds(300));
+  EXPECT_EQ(scheduler.get_level(), 2);
+
+  // They break a run of slots under half the budget
+  for (int i = 0; i < 10; i++) {
+    scheduler.slot_done(chrono::microseconds(100));
+    scheduler.slot_done(chrono::microseconds(100));
+    scheduler.slot_done(chrono::microseconds(300));
+  }
+  EXPECT_EQ(scheduler.get_level(), 2);
+
+  for (int i = 0; i < 3; i++)
+    scheduler.slot_done(chrono::microseconds(100));
+  EXPECT_EQ(scheduler.get_level(), 1);
+  EXPECT_TRUE(scheduler.is_shedding(shed_step::low_al));
+  EXPECT_FALSE(scheduler.is_shedding(shed_step::rnti_list));
+
+  // A slot over budget restarts the count
+  scheduler.slot_done(chrono::microseconds(100));
+  scheduler.slot_done(chrono::microseconds(100));
+  scheduler.slot_done(chrono::microseconds(600));
+  EXPECT_EQ(scheduler.get_level(), 2);
+}
+
+TEST_F(deadline_scheduler_test, narrows_to_hot_scrambling_ids) {
+  EXPECT_EQ(scheduler.get_scrambling_ids(0, 1000, 500), vector<uint16_t>({500}));
+  EXPECT_EQ(scheduler.get_scrambling_ids(600, 1000, 500), vector<uint16_t>({600}));
+
+  scheduler.add_hot_scrambling_id(700);
+  scheduler.add_hot_scrambling_id(20);
+  scheduler.add_hot_scrambling_id(700);
+  EXPECT_EQ(scheduler.get_scrambling_ids(0, 1000, 500), vector<uint16_t>({20, 700}));
+  EXPECT_EQ(scheduler.get_scrambling_ids(100, 1000, 500), vector<uint16_t>({700}));
+}
+
+TEST_F(deadline_scheduler_test, parses_step_names) {
+  EXPECT_EQ(parse_shed_step("rnti_list"), shed_step::rnti_list);
+  EXPECT_STREQ(shed_step_name(shed_step::scrambling_ids), "scrambling_ids");
+  EXPECT_THROW(parse_shed_step("everything"), config_exception);
+}
@@ -48,3 +48,34 @@ TEST_F(dsp_test, correlation_magnitude_normalized) {
   correlate_magnitude_normalized(result, ref, random_corr);
   EXPECT_FLOAT_EQ(result.at(0), 0.238744325750948);
 }
+
+TEST_F(dsp_test, cp_correlation) {
+  size_t delay = 16;
+  size_t window_size = 4;
+  vector<complex<float>> samples(100);
+  for(size_t i = 0; i < samples.size(); i++) {
+    samples[i] = polar(1.0f + 0.01f * (i % 7), 0.3f * i * i);
+  }
+
+  // Reference: moving correlation with a zero-padded delayed copy
+  vector<complex<float>> delayed(samples.size());
+  std::copy(samples.begin(), samples.end() - delay, delayed.begin() + delay);
+  vector<complex<float>> expected;
+  moving_correlate(expected, samples, delayed, window_size);
+  for(size_t i = 0; i < samples.size(); i++) {
+    complex<float> brute_force = 0;
+    for(size_t k = (i + 1 > window_size ? i + 1 - window_size : 0); k <= i; k++) {
+      brute_force += samples[k] * conj(delayed[k]);
+    }
+    EXPECT_NEAR(abs(expected[i] - brute_force), 0.0f, 1e-4) << "at " << i;
+  }
+
+  // Only at the requested lags
+  vector<size_t> lags = {0, 3, 17, 20, 99};
+  vector<complex<float>> at_lags;
+  cp_correlate(at_lags, samples, delay, window_size, lags);
+  ASSERT_EQ(at_lags.size(), lags.size());
+  for(size_t i = 0; i < lags.size(); i++) {
+    EXPECT_NEAR(abs(at_lags[i] - expected[lags[i]]), 0.0f, 1e-4) << "at lag " << lags[i];
+  }
+}
@@ -0,0 +1,137 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <complex>
+#include <memory>
+#include "gtest/gtest.h"
+#include "grid_sink.h"
+#include "grid_source.h"
+
+using namespace std;
+
+/**
+ * Worker that collects the symbols it is given.
+ */
+class symbol_collector : public worker {
+  public:
+    void process(shared_ptr<vector<symbol>>& symbols, const frame_metadata& metadata) override {
+      chunks.push_back(*symbols);
+      metadatas.push_back(metadata);
+    }
+    vector<vector<symbol>> chunks;
+    vector<frame_metadata> metadatas;
+};
+
+class grid_recording_test : public ::testing::Test {
+ protected:
+  grid_recording_test() {
+  }
+
+  shared_ptr<vector<symbol>> make_symbols(size_t num_symbols, size_t num_res, uint8_t slot_index) {
+    auto symbols = make_shared<vector<symbol>>();
+    for(size_t i = 0; i < num_symbols; i++) {
+      symbol s;
+      s.sample_index = 1000 * slot_index + i;
+      s.sfn = 1023;
+      s.slot_index = slot_index;
+      s.symbol_index = 0;
+      for(size_t j = 0; j < num_res; j++) {
+        s.samples.push_back(complex<float>(0.25f * j, -0.5f * i));
+      }
+      symbols->push_back(s);
+    }
+    return symbols;
+  }
+
+  void round_trip(bool half_precision) {
+    string path = "/tmp/grid_recording_test.grid";
+    grid_file_header header = {};
+    header.flags = half_precision ? grid_flag_half_precision : 0;
+    header.sample_rate = 23040000;
+    header.cell_id = 1;
+    header.coreset_id = 1;
+    header.num_prbs = 48;
+    header.coreset_duration = 2;
+
+    auto first = make_symbols(2, 16, 3);
+    auto second = make_symbols(1, 16, 4);
+    {
+      grid_sink sink(path, header);
+      frame_metadata first_metadata;
+      first_metadata.sample_index = 100;
+      first_metadata.sync_generation = 1;
+      frame_metadata second_metadata;
+      second_metadata.sample_index = 200;
+      sink.process(first, first_metadata);
+      sink.process(second, second_metadata);
+    }
+
+    grid_source source(path);
+    auto collector = make_shared<symbol_collector>();
+    bool ended = false;
+    source.on_end = [&ended](){ ended = true; };
+    source.connect(collector);
+    while(!ended) {
+      source.work(0);
+    }
+
+    EXPECT_EQ(source.header.cell_id, 1);
+    EXPECT_EQ(source.header.num_prbs, 48);
+    ASSERT_EQ(collector->chunks.size(), 2);
+    EXPECT_EQ(collector->metadatas.at(0).sample_index, 100);
+    EXPECT_EQ(collector->metadatas.at(0).sync_generation, 1);
+    EXPECT_EQ(collector->metadatas.at(1).sample_index, 200);
+    ASSERT_EQ(collector->chunks.at(0).size(), 2);
+    ASSERT_EQ(collector->chunks.at(1).size(), 1);
+
+    auto& s = collector->chunks.at(0).at(1);
+    EXPECT_EQ(s.sample_index, 3001);
+    EXPECT_EQ(s.sfn, 1023);
+    EXPECT_EQ(s.slot_index, 3);
+    ASSERT_EQ(s.samples.size(), 16);
+    for(size_t j = 0; j < s.samples.size(); j++) {
+      EXPECT_EQ(s.samples.at(j), first->at(1).samples.at(j)); // Values are exactly representable as half floats
+    }
+    remove(path.c_str());
+  }
+};
+
+TEST_F(grid_recording_test, half_float_conversion) {
+  vector<float> exact = {0.0f, -0.0f, 1.0f, -2.5f, 65504.0f, 6.103515625e-05f, 5.960464477539063e-08f};
+  for(float value : exact) {
+    EXPECT_EQ(half_to_float(float_to_half(value)), value);
+  }
+  EXPECT_EQ(float_to_half(1.0f), 0x3c00);
+  EXPECT_TRUE(std::isinf(half_to_float(float_to_half(1e6f))));
+  EXPECT_NEAR(half_to_float(float_to_half(0.1f)), 0.1f, 0.1f / 1024);
+  EXPECT_EQ(half_to_float(float_to_half(1e-9f)), 0.0f);
+}
+
+TEST_F(grid_recording_test, round_trip_single_precision) {
+  round_trip(false);
+}
+
+TEST_F(grid_recording_test, round_trip_half_precision) {
+  round_trip(true);
+}
@@ -0,0 +1,56 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <cstdint>
+#include <vector>
+#include "gtest/gtest.h"
+#include "gscn.h"
+
+using namespace std;
+
+TEST(gscn_test, raster_frequencies) {
+  EXPECT_DOUBLE_EQ(gscn_to_frequency(2), 1.25e6);
+  EXPECT_DOUBLE_EQ(gscn_to_frequency(3), 1.35e6);
+  EXPECT_DOUBLE_EQ(gscn_to_frequency(4), 1.45e6);
+  EXPECT_DOUBLE_EQ(gscn_to_frequency(1569), 627.75e6); // Band n71
+  EXPECT_DOUBLE_EQ(gscn_to_frequency(7498), 2999.05e6);
+  EXPECT_DOUBLE_EQ(gscn_to_frequency(7499), 3000e6);
+  EXPECT_DOUBLE_EQ(gscn_to_frequency(7711), 3305.28e6); // Band n78
+  EXPECT_DOUBLE_EQ(gscn_to_frequency(22256), 24250.08e6);
+}
+
+TEST(gscn_test, frequency_to_gscn) {
+  EXPECT_EQ(frequency_to_gscn(0), 2);
+  EXPECT_EQ(frequency_to_gscn(627.75e6), 1569);
+  EXPECT_EQ(frequency_to_gscn(627.76e6), 1570);
+  EXPECT_EQ(frequency_to_gscn(2999.1e6), 7499);
+  EXPECT_EQ(frequency_to_gscn(3305.28e6), 7711);
+
+  for(uint32_t gscn = gscn_min; gscn < 8000; gscn++) {
+    ASSERT_EQ(frequency_to_gscn(gscn_to_frequency(gscn)), gscn);
+  }
+}
+
+TEST(gscn_test, range) {
+  vector<uint32_t> gscns = gscns_in_range(626.5e6, 628e6);
+  vector<uint32_t> expected = {1566, 1567, 1568, 1569, 1570};
+  EXPECT_EQ(gscns, expected);
+}
@@ -0,0 +1,121 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "metrics.h"
+
+using namespace std;
+
+class metrics_test : public ::testing::Test {
+ protected:
+  metrics_test() {
+  }
+};
+
+TEST_F(metrics_test, counters_sum_over_threads) {
+  uint64_t before = metrics::get_counter(metrics::polar_decodes);
+  vector<thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([] {
+      for (int i = 0; i < 1000; i++)
+        metrics::count(metrics::polar_decodes);
+    });
+  }
+  for (auto& t : threads)
+    t.join();
+
+  // Counts of finished threads are kept
+  EXPECT_EQ(metrics::get_counter(metrics::polar_decodes) - before, 4000);
+}
+
+TEST_F(metrics_test, latency_histogram) {
+  string name = "stage=\"syncer_find_sss\"";
+  uint64_t before = metrics::get_latency_count(metrics::syncer_find_sss);
+  metrics::record_latency(metrics::syncer_find_sss, chrono::nanoseconds(500));
+  metrics::record_latency(metrics::syncer_find_sss, chrono::microseconds(3));
+  metrics::record_latency(metrics::syncer_find_sss, chrono::seconds(10));
+  EXPECT_EQ(metrics::get_latency_count(metrics::syncer_find_sss) - before, 3);
+
+  if (before == 0) {
+    string text = metrics::to_prometheus();
+    EXPECT_NE(text.find("sniffer_stage_latency_seconds_bucket{" + name + ",le=\"1e-06\"} 1\n"), string::npos);
+    EXPECT_NE(text.find("sniffer_stage_latency_seconds_bucket{" + name + ",le=\"2e-06\"} 1\n"), string::npos);
+    EXPECT_NE(text.find("sniffer_stage_latency_seconds_bucket{" + name + ",le=\"4e-06\"} 2\n"), string::npos);
+    EXPECT_NE(text.find("sniffer_stage_latency_seconds_bucket{" + name + ",le=\"+Inf\"} 3\n"), string::npos);
+    EXPECT_NE(text.find("sniffer_stage_latency_seconds_count{" + name + "} 3\n"), string::npos);
+  }
+}
+
+TEST_F(metrics_test, gauges) {
+  int64_t before = metrics::get_gauge(metrics::flows_in_use);
+  metrics::add_gauge(metrics::flows_in_use, 3);
+  metrics::add_gauge(metrics::flows_in_use, -1);
+  EXPECT_EQ(metrics::get_gauge(metrics::flows_in_use) - before, 2);
+  metrics::add_gauge(metrics::flows_in_use, -2);
+}
+
+TEST_F(metrics_test, http_endpoint) {
+  metrics::count(metrics::crc_passes, 7);
+  metrics::exporter exporter(0);
+  ASSERT_GT(exporter.get_port(), 0);
+
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(exporter.get_port());
+  ASSERT_EQ(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+  string request = "GET /metrics HTTP/1.0\r\n\r\n";
+  send(fd, request.data(), request.size(), 0);
+
+  string response;
+  char buffer[4096];
+  ssize_t n;
+  while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0)
+    response.append(buffer, n);
+  close(fd);
+
+  EXPECT_EQ(response.rfind("HTTP/1.0 200 OK", 0), 0);
+  EXPECT_NE(response.find("# TYPE sniffer_crc_passes_total counter"), string::npos);
+  EXPECT_NE(response.find("sniffer_crc_passes_total " + to_string(metrics::get_counter(metrics::crc_passes))), string::npos);
+}
+
+TEST_F(metrics_test, stats_file) {
+  string path = testing::TempDir() + "metrics_test.prom";
+  {
+    metrics::exporter exporter(-1, path, 0.05);
+    EXPECT_EQ(exporter.get_port(), -1);
+  }
+  ifstream f(path);
+  stringstream contents;
+  contents << f.rdbuf();
+  EXPECT_NE(contents.str().find("sniffer_samples_in_total"), string::npos);
+  remove(path.c_str());
+}
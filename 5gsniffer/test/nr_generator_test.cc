@@ -0,0 +1,246 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <cstdint>
+#include <cmath>
+#include <fstream>
+#include <vector>
+#include <complex>
+#include <memory>
+#include "gtest/gtest.h"
+#include "nr_generator.h"
+#include "config.h"
+#include "ofdm.h"
+#include "pss.h"
+#include "dsp.h"
+#include "pbch.h"
+#include "phy.h"
+#include "dci.h"
+#include "exceptions.h"
+
+using namespace std;
+
+/**
+ * Worker that collects the symbols it is given.
+ */
+class generated_symbol_collector : public worker {
+  public:
+    void process(shared_ptr<vector<symbol>>& symbols, const frame_metadata& metadata) override {
+      collected.insert(collected.end(), symbols->begin(), symbols->end());
+    }
+    vector<symbol> collected;
+};
+
+class nr_generator_test : public ::testing::Test {
+ protected:
+  nr_generator_test() {
+    string path = "/tmp/nr_generator_test.toml";
+    ofstream toml(path);
+    toml << "[sniffer]\n"
+            "sample_rate = 11520000\n"
+            "[[pdcch]]\n"
+            "subcarrier_offset = 60\n"
+            "num_prbs = 48\n"
+            "coreset_duration = 1\n"
+            "coreset_interleaving_pattern = \"interleaved\"\n"
+            "coreset_nshift = 500\n"
+            "num_candidates_per_AL = [8, 4, 2, 1, 0]\n"
+            "dci_sizes_list = [41]\n"
+            "[generator]\n"
+            "output_path = \"/tmp/nr_generator_test.fc32\"\n"
+            "cell_id = 500\n"
+            "[[generator.dci]]\n"
+            "rnti = 17921\n"
+            "scrambling_id = 500\n"
+            "aggregation_level = 4\n"
+            "candidate = 1\n"
+            "slot_period = 10\n"
+            "slot_offset = 3\n";
+    toml.close();
+    conf = config::load(path);
+    remove(path.c_str());
+  }
+
+  /**
+   * Demodulates a frame the way the sniffer does for a bandwidth part.
+   */
+  vector<symbol> demodulate(vector<complex<float>>& frame, uint16_t num_prbs, int32_t subcarrier_offset) {
+    auto bwp = make_shared<bandwidth_part>(conf.sample_rate, 0, num_prbs);
+    if (subcarrier_offset != 0)
+      rotate(frame, frame, (float)subcarrier_offset * bwp->scs, conf.sample_rate);
+    auto demodulator = make_shared<ofdm>(bwp);
+    auto collector = make_shared<generated_symbol_collector>();
+    demodulator->connect(collector);
+    auto samples = make_shared<vector<complex<float>>>(frame);
+    frame_metadata metadata;
+    demodulator->process(samples, metadata);
+    return collector->collected;
+  }
+
+  struct config conf;
+};
+
+TEST_F(nr_generator_test, config_is_parsed) {
+  EXPECT_EQ(conf.generator.cell_id, 500);
+  EXPECT_EQ(conf.generator.truth_path, "/tmp/nr_generator_test.fc32.csv");
+  ASSERT_EQ(conf.generator.dcis.size(), 1);
+  EXPECT_EQ(conf.generator.dcis.at(0).rnti, 17921);
+  EXPECT_EQ(conf.generator.dcis.at(0).dci_size, 41); // First size of the PDCCH by default
+}
+
+TEST_F(nr_generator_test, pss_is_centered_in_even_frames) {
+  nr::nr_generator generator(conf.sample_rate, conf.pdcch_configs, conf.generator);
+  vector<nr::generated_dci> dcis;
+  auto frame = generator.modulate_frame(2, dcis);
+  ASSERT_EQ(frame.size(), generator.samples_per_frame);
+
+  auto symbols = demodulate(frame, ssb_rb, 0);
+  ASSERT_EQ(symbols.size(), 140);
+  pss pss_(500 % 3);
+  auto pss_seq = pss_.get_pss_seq_f();
+  float scale = std::sqrt(conf.sample_rate / 15000.0f);
+  for (size_t i = 0; i < pss_seq.size(); i++) {
+    EXPECT_NEAR(std::abs(symbols.at(2).samples.at(56 + i) / scale - pss_seq.at(i)), 0.0f, 1e-3);
+  }
+
+  // No SSB in odd frames
+  frame = generator.modulate_frame(3, dcis);
+  symbols = demodulate(frame, ssb_rb, 0);
+  EXPECT_NEAR(std::abs(symbols.at(2).samples.at(56)), 0.0f, 1e-3);
+}
+
+TEST_F(nr_generator_test, dci_dmrs_correlates_at_its_candidate) {
+  nr::nr_generator generator(conf.sample_rate, conf.pdcch_configs, conf.generator);
+  vector<nr::generated_dci> dcis;
+  auto frame = generator.modulate_frame(1, dcis);
+  ASSERT_EQ(dcis.size(), 1);
+  EXPECT_EQ(dcis.at(0).slot_index, 3);
+  EXPECT_EQ(dcis.at(0).payload.size(), 41);
+
+  const pdcch_config& pdcch_cfg = conf.pdcch_configs.at(0);
+  auto symbols = demodulate(frame, pdcch_cfg.num_prbs, pdcch_cfg.subcarrier_offset);
+  symbol& coreset_symbol = symbols.at(3 * 14);
+  EXPECT_EQ(coreset_symbol.slot_index, 3);
+  EXPECT_EQ(coreset_symbol.sample_index, dcis.at(0).sample_index);
+
+  // The DMRS only matches the scrambling ID it was generated with
+  for (uint16_t scrambling_id : {500, 501}) {
+    nr::pdcch pdcch;
+    pdcch.scrambling_id_start = scrambling_id;
+    pdcch.scrambling_id_end = scrambling_id;
+    pdcch.set_coreset_info(coreset(0, 48, 1, "interleaved", 6, 2, 500, 500, 0, 14, 10, {8, 4, 2, 1, 0}));
+    pdcch.initialize_dmrs_seq();
+    string key = to_string(scrambling_id) + "2" + "3" + "1"; // AL 4, slot 3, candidate 1
+    float correlation = pdcch.compute_correlation_DMRS(coreset_symbol, pdcch.dmrs_seq_table.at(key), pdcch.dmrs_sc_indices_table.at(key));
+    if (scrambling_id == 500)
+      EXPECT_GT(correlation, 0.99);
+    else
+      EXPECT_LT(correlation, 0.5);
+  }
+}
+
+TEST_F(nr_generator_test, dci_decodes_with_its_rnti) {
+  // A UE-specific scrambling ID, so that the RNTI also scrambles the DCI
+  conf.generator.dcis.at(0).scrambling_id = 321;
+  nr::nr_generator generator(conf.sample_rate, conf.pdcch_configs, conf.generator);
+  vector<nr::generated_dci> dcis;
+  auto frame = generator.modulate_frame(1, dcis);
+  ASSERT_EQ(dcis.size(), 1);
+
+  const pdcch_config& pdcch_cfg = conf.pdcch_configs.at(0);
+  auto symbols = demodulate(frame, pdcch_cfg.num_prbs, pdcch_cfg.subcarrier_offset);
+  symbol& coreset_symbol = symbols.at(3 * 14);
+
+  nr::pdcch pdcch;
+  pdcch.scrambling_id_start = 321;
+  pdcch.scrambling_id_end = 321;
+  pdcch.sample_rate_time = conf.sample_rate;
+  pdcch.set_coreset_info(coreset(0, 48, 1, "interleaved", 6, 2, 500, 500, 0, 14, 10, {8, 4, 2, 1, 0}));
+  pdcch.initialize_RNTI_list();
+  pdcch.initialize_dmrs_seq();
+
+  // AL 4, candidate 1 of the 2 candidates of AL 4
+  dci candidate(true, 4, 1, 2, 0, 0, "ue-rnti", "dci-unknown", 0, {}, 0, 321, coreset_symbol.slot_index, coreset_symbol.symbol_index, 1.0f);
+  candidate.set_nof_bits(41);
+  auto equalized_symbols = pdcch.estimate_channel_dci(coreset_symbol, candidate);
+  frame_metadata metadata;
+  for (uint16_t rnti : {17921, 17922}) {
+    candidate.set_rnti(rnti);
+    srsran_pdcch_nr_res_t res = {};
+    int crc = pdcch.decode_pdcch(coreset_symbol, equalized_symbols, candidate, &res, false, metadata);
+    if (rnti == 17921)
+      EXPECT_EQ(crc, 1);
+    else
+      EXPECT_EQ(crc, 0);
+  }
+}
+
+TEST_F(nr_generator_test, pbch_carries_the_mib) {
+  conf.generator.ssb_offset = 3;
+  conf.generator.coreset0_idx = 5;
+  conf.generator.ss0_idx = 2;
+  conf.generator.dmrs_typeA_pos = true;
+  nr::nr_generator generator(conf.sample_rate, conf.pdcch_configs, conf.generator);
+  vector<nr::generated_dci> dcis;
+  auto frame = generator.modulate_frame(42, dcis);
+  auto symbols = demodulate(frame, ssb_rb, 0);
+
+  auto phy = make_shared<nr::phy>();
+  phy->nid1 = 500 / 3;
+  phy->nid2 = 500 % 3;
+  phy->in_synch = false;
+  nr::pbch pbch(phy);
+  bool found = false;
+  srsran_mib_nr_t decoded = {};
+  pbch.on_mib_found = [&](srsran_mib_nr_t& mib, bool crc) {
+    found = crc;
+    decoded = mib;
+  };
+
+  // The SSB spans symbols 2 to 5 of the slot
+  auto ssb = make_shared<vector<symbol>>(symbols.begin() + 2, symbols.begin() + 6);
+  frame_metadata metadata;
+  pbch.process(ssb, metadata);
+  ASSERT_TRUE(found);
+  EXPECT_EQ(decoded.sfn, 42);
+  EXPECT_EQ(decoded.ssb_offset, 3);
+  EXPECT_EQ(decoded.coreset0_idx, 5);
+  EXPECT_EQ(decoded.ss0_idx, 2);
+  EXPECT_EQ(decoded.dmrs_typeA_pos, srsran_dmrs_sch_typeA_pos_3);
+  EXPECT_EQ(phy->i_ssb, 0);
+  EXPECT_EQ(phy->n_hf, 0);
+}
+
+TEST_F(nr_generator_test, config_rejects_unsafe_values) {
+  string path = "/tmp/nr_generator_test_invalid.toml";
+  string pdcch = "[sniffer]\nfile_path = \"recording.fc32\"\n[[pdcch]]\n";
+  auto load = [&](const string& generator) {
+    ofstream(path) << pdcch << generator;
+    auto loaded = config::load(path);
+    remove(path.c_str());
+    return loaded;
+  };
+
+  // The output is never the recording of the sniffer
+  EXPECT_EQ(load("").generator.output_path, "");
+  EXPECT_THROW(load("[generator]\noutput_path = \"out.fc32\"\n[[generator.dci]]\nslot_period = 10\nslot_offset = 10\n"), config_exception);
+  remove(path.c_str());
+}
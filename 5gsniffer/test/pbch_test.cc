@@ -0,0 +1,76 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <cstdint>
+#include <memory>
+#include "gtest/gtest.h"
+#include "pbch.h"
+#include "phy.h"
+
+using namespace std;
+
+class pbch_test : public ::testing::Test {
+ protected:
+  pbch_test() {
+  }
+
+  static shared_ptr<nr::phy> make_phy(uint16_t cell_id) {
+    auto phy = make_shared<nr::phy>();
+    phy->nid1 = cell_id / 3;
+    phy->nid2 = cell_id % 3;
+    return phy;
+  }
+
+  static void expect_same_tables(const nr::pbch& cached, const nr::pbch& fresh) {
+    EXPECT_EQ(cached.dmrs_sc_indices_table, fresh.dmrs_sc_indices_table);
+    EXPECT_EQ(cached.data_sc_indices_table, fresh.data_sc_indices_table);
+    EXPECT_EQ(cached.dmrs_seq_table, fresh.dmrs_seq_table);
+  }
+};
+
+TEST_F(pbch_test, cached_tables_match_freshly_built_ones) {
+  auto phy = make_phy(500);
+  nr::pbch cached(phy);
+  cached.initialize_dmrs_seq();
+
+  // The tables are only rebuilt when the cell ID changes
+  for (uint16_t cell_id : {500, 17, 17, 500, 1007}) {
+    phy->nid1 = cell_id / 3;
+    phy->nid2 = cell_id % 3;
+    cached.initialize_dmrs_seq();
+
+    nr::pbch fresh(make_phy(cell_id));
+    fresh.initialize_dmrs_seq();
+    expect_same_tables(cached, fresh);
+  }
+}
+
+TEST_F(pbch_test, tables_depend_on_the_cell_id) {
+  nr::pbch pbch_500(make_phy(500));
+  pbch_500.initialize_dmrs_seq();
+  nr::pbch pbch_501(make_phy(501));
+  pbch_501.initialize_dmrs_seq();
+
+  // The DMRS subcarriers shift with the cell ID modulo 4, the sequence depends on all of it
+  EXPECT_NE(pbch_500.dmrs_sc_indices_table, pbch_501.dmrs_sc_indices_table);
+  EXPECT_NE(pbch_500.dmrs_seq_table, pbch_501.dmrs_seq_table);
+  EXPECT_EQ(pbch_500.dmrs_sc_indices_table[0].size() + pbch_500.data_sc_indices_table[0].size(), 240);
+}
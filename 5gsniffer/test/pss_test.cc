@@ -20,6 +20,8 @@
  */
 
 #include "gtest/gtest.h"
+#include <random>
+#include <vector>
 #include "pss.h"
 #include "fftw3.h"
 // #include "mat.h"
@@ -304,3 +306,32 @@ TEST_F(pss_test, test_FFT_precision) {
 
 }
 
+TEST_F(pss_test, test_pss_detector) {
+  pss generator;
+  auto pss_seq_t = generator.convert_pss_t(generator.generate_pss_seq(1));
+
+  // PSS of NID_2 1 at a known position in noise, with a phase offset
+  std::mt19937 rng(42);
+  std::normal_distribution<float> noise(0.0f, 4.0f);
+  std::vector<std::complex<float>> samples(4000);
+  for (auto& sample : samples) {
+    sample = {noise(rng), noise(rng)};
+  }
+  int64_t pss_position = 1234;
+  for (int i = 0; i < ssb_nfft; i++) {
+    samples.at(pss_position + i) += pss_seq_t.at(i) * std::polar(1.0f, 0.7f);
+  }
+
+  for (uint16_t decimation : {1, 2, 4, 8}) {
+    pss_detector detector(decimation);
+    int64_t position = 0;
+    float correlation = 0.0f;
+    uint8_t nid_2 = 0;
+    ASSERT_TRUE(detector.search(samples, 0, 2, position, correlation, nid_2)) << "decimation " << decimation;
+    EXPECT_EQ(position, pss_position) << "decimation " << decimation;
+    EXPECT_EQ(nid_2, 1) << "decimation " << decimation;
+    if (decimation > 1) {
+      EXPECT_LT(detector.get_cost(samples.size(), 3), pss_detector::get_exhaustive_cost(samples.size(), 3));
+    }
+  }
+}
@@ -0,0 +1,121 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include "gtest/gtest.h"
+#include "rnti_recency_list.h"
+
+using namespace std;
+
+class rnti_recency_list_test : public ::testing::Test {
+ protected:
+  rnti_recency_list_test() {
+    list.assign(100, 109);
+  }
+
+  rnti_recency_list list;
+};
+
+TEST_F(rnti_recency_list_test, starts_in_ascending_order) {
+  auto rntis = list.get_snapshot();
+  ASSERT_EQ(rntis->size(), 10);
+  EXPECT_EQ(rntis->front(), 100);
+  EXPECT_EQ(rntis->back(), 109);
+  EXPECT_TRUE(list.contains(105));
+  EXPECT_FALSE(list.contains(110));
+}
+
+TEST_F(rnti_recency_list_test, promotes_found_rntis_to_the_front) {
+  auto before = list.get_snapshot();
+  EXPECT_TRUE(list.promote(105));
+  EXPECT_TRUE(list.promote(102));
+  EXPECT_TRUE(list.promote(105));
+  EXPECT_FALSE(list.promote(65535));
+
+  EXPECT_EQ(*list.get_snapshot(), vector<uint16_t>({105, 102, 100, 101, 103, 104, 106, 107, 108, 109}));
+  // Snapshots taken before are not changed
+  EXPECT_EQ(before->at(5), 105);
+}
+
+TEST_F(rnti_recency_list_test, adds_and_removes_rntis) {
+  EXPECT_TRUE(list.remove(100));
+  EXPECT_FALSE(list.remove(100));
+  EXPECT_TRUE(list.push_front(2000));
+  EXPECT_FALSE(list.push_front(109));
+  EXPECT_TRUE(list.remove(2000));
+  EXPECT_TRUE(list.push_front(2000));
+  EXPECT_EQ(list.size(), 10);
+  EXPECT_FALSE(list.contains(100));
+  EXPECT_EQ(*list.get_snapshot(), vector<uint16_t>({2000, 109, 101, 102, 103, 104, 105, 106, 107, 108}));
+}
+
+TEST_F(rnti_recency_list_test, concurrent_promotions_keep_every_rnti) {
+  list.assign(0, 4095);
+  vector<thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([this, t] {
+      for (int i = 0; i < 500; i++) {
+        list.promote((i * 7 + t * 1000) % 4096);
+        auto rntis = list.get_snapshot();
+        EXPECT_EQ(rntis->size(), 4096);
+      }
+    });
+  }
+  for (auto& t : threads)
+    t.join();
+
+  auto rntis = *list.get_snapshot();
+  ASSERT_EQ(rntis.size(), 4096);
+  sort(rntis.begin(), rntis.end());
+  EXPECT_EQ(adjacent_find(rntis.begin(), rntis.end()), rntis.end());
+}
+
+TEST_F(rnti_recency_list_test, promotes_during_a_large_rebuild) {
+  list.assign(0, 65535);
+  atomic<bool> promoting = true;
+  vector<thread> readers;
+  for (int t = 0; t < 2; t++) {
+    readers.emplace_back([this, &promoting] {
+      while (promoting) {
+        auto rntis = list.get_snapshot();
+        EXPECT_EQ(rntis->size(), 65536);
+      }
+    });
+  }
+
+  // Every promotion makes the next snapshot a full rebuild of the 65536 RNTIs
+  for (int i = 0; i < 2000; i++)
+    list.promote((i * 7919) % 65536);
+  promoting = false;
+  for (auto& t : readers)
+    t.join();
+
+  auto rntis = *list.get_snapshot();
+  ASSERT_EQ(rntis.size(), 65536);
+  EXPECT_EQ(rntis.at(0), (1999 * 7919) % 65536);
+  EXPECT_EQ(rntis.at(1), (1998 * 7919) % 65536);
+  sort(rntis.begin(), rntis.end());
+  EXPECT_EQ(adjacent_find(rntis.begin(), rntis.end()), rntis.end());
+}
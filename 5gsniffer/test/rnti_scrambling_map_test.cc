@@ -0,0 +1,72 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <vector>
+#include "gtest/gtest.h"
+#include "rnti_scrambling_map.h"
+
+using namespace std;
+
+TEST(rnti_scrambling_map_test, learns_rntis_per_scrambling_id) {
+  rnti_scrambling_map map;
+  EXPECT_TRUE(map.get_rntis(500)->rntis.empty());
+
+  EXPECT_TRUE(map.learn(17921, 500));
+  EXPECT_TRUE(map.learn(4000, 500));
+  EXPECT_FALSE(map.learn(17921, 500));
+  EXPECT_TRUE(map.learn(300, 12));
+
+  auto learned = map.get_rntis(500);
+  EXPECT_EQ(learned->rntis, vector<uint16_t>({4000, 17921}));
+  EXPECT_TRUE(learned->contains(17921));
+  EXPECT_FALSE(learned->contains(300));
+  EXPECT_EQ(map.size(), 3);
+
+  uint16_t scrambling_id = 0;
+  ASSERT_TRUE(map.get_scrambling_id(300, scrambling_id));
+  EXPECT_EQ(scrambling_id, 12);
+  EXPECT_FALSE(map.get_scrambling_id(301, scrambling_id));
+}
+
+TEST(rnti_scrambling_map_test, moves_and_forgets_rntis) {
+  rnti_scrambling_map map;
+  map.learn(17921, 500);
+  map.learn(4000, 500);
+  auto before = map.get_rntis(500);
+
+  // A new RRC connection with another scrambling ID
+  EXPECT_TRUE(map.learn(17921, 501));
+  EXPECT_EQ(map.get_rntis(500)->rntis, vector<uint16_t>({4000}));
+  EXPECT_EQ(map.get_rntis(501)->rntis, vector<uint16_t>({17921}));
+  EXPECT_EQ(before->rntis, vector<uint16_t>({4000, 17921}));
+
+  EXPECT_TRUE(map.forget(4000));
+  EXPECT_FALSE(map.forget(4000));
+  EXPECT_TRUE(map.get_rntis(500)->rntis.empty());
+  EXPECT_EQ(map.size(), 1);
+}
+
+TEST(rnti_scrambling_map_test, only_learns_ue_specific_scrambling) {
+  EXPECT_TRUE(rnti_scrambling_map::is_learnable(17921, 500, 1));
+  EXPECT_FALSE(rnti_scrambling_map::is_learnable(17921, 1, 1));
+  EXPECT_FALSE(rnti_scrambling_map::is_learnable(65535, 500, 1));
+  EXPECT_FALSE(rnti_scrambling_map::is_learnable(0, 500, 1));
+}
@@ -261,4 +261,34 @@ TEST_F(sss_test, test_sss_generate_all_sequences) {
     EXPECT_FLOAT_EQ((sss_seq_330_2.at(i)).real(), (sss_seq_ref_330_2.at(i)).real()) << "Vectors x and y differ at real index " << i;
     EXPECT_FLOAT_EQ((sss_seq_330_2.at(i)).imag(), (sss_seq_ref_330_2.at(i)).imag()) << "Vectors x and y differ at imaginary index " << i;
   }
-}
\ No newline at end of file
+}
+TEST_F(sss_test, test_sss_detector) {
+  sss generator;
+  sss_detector matrix_detector(false);
+  sss_detector fast_detector(true);
+  std::array<float,nid_1_max+1> matrix_correlations;
+  std::array<float,nid_1_max+1> fast_correlations;
+
+  for (uint8_t nid_2 = 0; nid_2 <= nid_2_max; nid_2++) {
+    for (uint16_t nid_1 : {0, 111, 112, 200, 335}) {
+      // Received SSS with a phase rotation and a small distortion
+      auto sequence = generator.generate_sss_seq(nid_1, nid_2);
+      std::array<std::complex<float>,sss_length> received;
+      for (int i = 0; i < sss_length; i++) {
+        received[i] = sequence[i] * std::polar(0.5f, 0.3f + 0.01f * i);
+      }
+
+      matrix_detector.correlate(received, nid_2, matrix_correlations);
+      fast_detector.correlate(received, nid_2, fast_correlations);
+
+      auto max_it = std::max_element(matrix_correlations.begin(), matrix_correlations.end());
+      EXPECT_EQ(max_it - matrix_correlations.begin(), nid_1);
+      for (int i = 0; i <= nid_1_max; i++) {
+        EXPECT_NEAR(fast_correlations[i], matrix_correlations[i], 1e-3) << "Correlations differ for NID1 " << i;
+      }
+
+      // The reference matrix holds the same sequences as the generator
+      EXPECT_EQ(sss_detector::get_reference_matrix()[nid_2][nid_1][5], sequence[5].real());
+    }
+  }
+}
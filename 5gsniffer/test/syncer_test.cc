@@ -0,0 +1,231 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <cstdint>
+#include <fstream>
+#include <vector>
+#include <map>
+#include <complex>
+#include <memory>
+#include "gtest/gtest.h"
+#include "syncer.h"
+#include "nr_generator.h"
+#include "flow_pool.h"
+#include "config.h"
+#include "metrics.h"
+
+using namespace std;
+
+extern struct config config;
+
+/**
+ * Hands SSBs straight to the SSS search of the syncer, as the PSS search
+ * leaves them, so that the MIB of each SSB is either decoded or predicted.
+ */
+class syncer_test : public ::testing::Test {
+ protected:
+  syncer_test() : saved_config(config) {
+    string path = "/tmp/syncer_test.toml";
+    ofstream toml(path);
+    toml << "[sniffer]\n"
+            "sample_rate = 3840000\n"
+            "[[pdcch]]\n"
+            "[generator]\n"
+            "output_path = \"/tmp/syncer_test.fc32\"\n"
+            "cell_id = 500\n";
+    toml.close();
+    config = config::load(path);
+    remove(path.c_str());
+
+    // Without bandwidth parts only the SSB is processed
+    config.pdcch_configs.clear();
+  }
+
+  ~syncer_test() {
+    config = saved_config;
+  }
+
+  /**
+   * Creates a syncer for the generated cell, reporting its MIBs in mibs.
+   */
+  unique_ptr<syncer> make_syncer(uint32_t pbch_decode_interval, vector<srsran_mib_nr_t>& mibs) {
+    auto phy = make_shared<nr::phy>();
+    phy->ssb_bwp = make_shared<bandwidth_part>(sample_rate, 0, ssb_rb);
+    phy->nid2 = config.generator.cell_id % 3;
+    phy->i_ssb = 0;
+    phy->n_hf = 0;
+    auto s = make_unique<syncer>(sample_rate, phy, make_shared<nr::flow_pool>(1), phy->nid2);
+    s->on_cell_found = [&mibs](srsran_mib_nr_t& mib, float cfo) { mibs.push_back(mib); };
+    decode_intervals[s.get()] = pbch_decode_interval;
+    return s;
+  }
+
+  /**
+   * Hands the SSB of a generated frame to the syncer the way find_pss leaves
+   * it: the SSB samples start at the CP of the PSS, and the processing queue
+   * at the slot carrying the SSB.
+   *
+   * @return whether the MIB was predicted rather than decoded
+   */
+  bool receive_ssb(syncer& s, nr::nr_generator& generator, uint16_t sfn, int64_t sample_index) {
+    vector<nr::generated_dci> dcis;
+    auto frame = generator.modulate_frame(sfn, dcis);
+    auto pss_start = frame.begin() + s.phy->ssb_bwp->samples_per_symbol(0) + s.phy->ssb_bwp->samples_per_symbol(1);
+    s.downsampled_samples.assign(pss_start, pss_start + ssb_nfft * 10);
+    s.queue_metadata = frame_metadata();
+    s.queue_metadata.sample_index = sample_index;
+
+    // The syncers of a test share the config, which is read for each SSB
+    config.pbch_decode_interval = decode_intervals.at(&s);
+    uint64_t predicted = metrics::get_counter(metrics::mibs_predicted);
+    s.fine_sync();
+    s.find_sss();
+    return metrics::get_counter(metrics::mibs_predicted) > predicted;
+  }
+
+  /**
+   * Reports a MIB as if the PBCH of the SSB in the slot starting at sample_index was decoded.
+   */
+  void decode_mib(syncer& s, srsran_mib_nr_t mib, int64_t sample_index) {
+    s.queue_metadata = frame_metadata();
+    s.queue_metadata.sample_index = sample_index;
+    s.new_cfo_fine = 0;
+    s.on_mib_found(mib, true);
+  }
+
+  /**
+   * Predicts the MIB of the SSB in the slot starting at sample_index.
+   */
+  void predict_mib(syncer& s, int64_t sample_index) {
+    s.queue_metadata = frame_metadata();
+    s.queue_metadata.sample_index = sample_index;
+    s.new_cfo_fine = 0;
+    s.on_mib_predictable();
+  }
+
+  /**
+   * Labels the sample at sample_index with the frame timing of the syncer.
+   */
+  frame_metadata label(syncer& s, int64_t sample_index) {
+    frame_metadata metadata;
+    metadata.sample_index = sample_index;
+    s.label_frame_timing(metadata);
+    return metadata;
+  }
+
+  static constexpr uint64_t sample_rate = 3'840'000;
+  static constexpr int64_t samples_per_frame = sample_rate * seconds_per_frame;
+  static constexpr int64_t samples_per_slot = samples_per_frame / 10;
+  struct config saved_config;
+  map<syncer*, uint32_t> decode_intervals;
+  vector<srsran_mib_nr_t> reported;
+};
+
+TEST_F(syncer_test, predicted_mibs_advance_the_sfn_like_decoded_ones) {
+  nr::nr_generator generator(sample_rate, {}, config.generator);
+  const vector<uint16_t> sfns = {1018, 1020, 1022, 0, 2, 4, 6, 8};
+
+  // One syncer decodes every MIB, the other only one in 4 and predicts the others, across the SFN wrap
+  vector<srsran_mib_nr_t> decoded;
+  auto decoding = make_syncer(1, decoded);
+  auto predicting = make_syncer(4, reported);
+  for (size_t i = 0; i < sfns.size(); i++) {
+    int64_t ssb_slot = i * 2 * samples_per_frame;
+    EXPECT_FALSE(receive_ssb(*decoding, generator, sfns[i], ssb_slot));
+    EXPECT_EQ(receive_ssb(*predicting, generator, sfns[i], ssb_slot), i % 4 != 0) << "SSB " << i;
+
+    ASSERT_EQ(decoded.size(), i + 1);
+    ASSERT_EQ(reported.size(), i + 1);
+    EXPECT_EQ(decoded[i].sfn, sfns[i]);
+    EXPECT_EQ(reported[i].sfn, sfns[i]) << "SSB " << i;
+    EXPECT_EQ(reported[i].hrf, decoded[i].hrf) << "SSB " << i;
+
+    // Both label the slots of the following 20 ms the same
+    for (int64_t slot = 0; slot < 20; slot++) {
+      int64_t sample_index = ssb_slot + slot * samples_per_slot;
+      EXPECT_EQ(label(*predicting, sample_index).sfn, label(*decoding, sample_index).sfn);
+      EXPECT_EQ(label(*predicting, sample_index).slot_index, label(*decoding, sample_index).slot_index);
+    }
+    EXPECT_EQ(label(*predicting, ssb_slot + 13 * samples_per_slot).sfn, (sfns[i] + 1) % frames_per_hyperframe);
+    EXPECT_EQ(label(*predicting, ssb_slot + 13 * samples_per_slot).slot_index, 3);
+  }
+}
+
+TEST_F(syncer_test, predicted_mib_keeps_the_half_frame) {
+  srsran_mib_nr_t mib = {};
+  mib.sfn = 1023;
+  mib.hrf = true;
+  int64_t ssb_slot = 12345;
+
+  // The SSB of the second half frame of SFN 1023 decoded, then the one 20 ms later predicted or decoded
+  auto predicting = make_syncer(4, reported);
+  decode_mib(*predicting, mib, ssb_slot);
+  predict_mib(*predicting, ssb_slot + 2 * samples_per_frame);
+  vector<srsran_mib_nr_t> decoded;
+  auto decoding = make_syncer(1, decoded);
+  decode_mib(*decoding, mib, ssb_slot);
+  mib.sfn = 1;
+  decode_mib(*decoding, mib, ssb_slot + 2 * samples_per_frame);
+
+  ASSERT_EQ(reported.size(), 2);
+  EXPECT_EQ(reported[1].sfn, 1);
+  EXPECT_TRUE(reported[1].hrf);
+  for (int64_t slot = 0; slot < 20; slot++) {
+    int64_t sample_index = ssb_slot + 2 * samples_per_frame + slot * samples_per_slot;
+    EXPECT_EQ(label(*predicting, sample_index).sfn, label(*decoding, sample_index).sfn);
+    EXPECT_EQ(label(*predicting, sample_index).slot_index, label(*decoding, sample_index).slot_index);
+  }
+  EXPECT_EQ(label(*predicting, ssb_slot + 2 * samples_per_frame).slot_index, 5);
+}
+
+TEST_F(syncer_test, prediction_stops_after_the_decode_interval) {
+  nr::nr_generator generator(sample_rate, {}, config.generator);
+  auto s = make_syncer(3, reported);
+  uint64_t decoded = metrics::get_counter(metrics::mibs_decoded);
+  for (size_t i = 0; i < 7; i++)
+    EXPECT_EQ(receive_ssb(*s, generator, 2 * i, i * 2 * samples_per_frame), i % 3 != 0) << "SSB " << i;
+  EXPECT_EQ(metrics::get_counter(metrics::mibs_decoded) - decoded, 3);
+  ASSERT_EQ(reported.size(), 7);
+  EXPECT_EQ(reported.back().sfn, 12);
+}
+
+TEST_F(syncer_test, prediction_stops_when_the_sss_is_lost) {
+  nr::nr_generator generator(sample_rate, {}, config.generator);
+  generator_config other_cell = config.generator;
+  other_cell.cell_id = config.generator.cell_id + 3; // Same PSS, other SSS
+  nr::nr_generator other_generator(sample_rate, {}, other_cell);
+  auto s = make_syncer(4, reported);
+
+  EXPECT_FALSE(receive_ssb(*s, generator, 0, 0));
+  EXPECT_TRUE(receive_ssb(*s, generator, 2, 2 * samples_per_frame));
+
+  // The SSS of another cell is not predicted, its PBCH fails to decode with the tracked cell ID
+  uint64_t decoded = metrics::get_counter(metrics::mibs_decoded);
+  EXPECT_FALSE(receive_ssb(*s, other_generator, 4, 4 * samples_per_frame));
+  EXPECT_EQ(metrics::get_counter(metrics::mibs_decoded), decoded);
+  EXPECT_EQ(reported.size(), 2);
+
+  // The next SSB of the cell is decoded again
+  EXPECT_FALSE(receive_ssb(*s, generator, 6, 6 * samples_per_frame));
+  EXPECT_EQ(metrics::get_counter(metrics::mibs_decoded) - decoded, 1);
+  ASSERT_EQ(reported.size(), 3);
+  EXPECT_EQ(reported.back().sfn, 6);
+}
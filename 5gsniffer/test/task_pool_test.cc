@@ -0,0 +1,198 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include "gtest/gtest.h"
+#include "task_pool.h"
+#include "worker.h"
+#include "exceptions.h"
+
+using namespace std;
+
+/**
+ * Worker that records the sample indices it receives, slowly enough for
+ * parallel fan-out to overlap.
+ */
+class recording_worker : public worker {
+  public:
+    void process(shared_ptr<vector<complex<float>>>& samples, const frame_metadata& metadata) override {
+      this_thread::sleep_for(chrono::milliseconds(2));
+      lock_guard<mutex> lock(m);
+      sample_indices.push_back(metadata.sample_index);
+    }
+    vector<int64_t> sample_indices;
+    mutex m;
+};
+
+/**
+ * Worker that passes its input on to its next workers.
+ */
+class forwarding_worker : public worker {
+  public:
+    void process(shared_ptr<vector<complex<float>>>& samples, const frame_metadata& metadata) override {
+      send_to_next_workers(samples, metadata);
+    }
+};
+
+class task_pool_test : public ::testing::Test {
+ protected:
+  task_pool_test() {
+  }
+};
+
+TEST_F(task_pool_test, task_queue_order) {
+  auto pool = make_shared<task_pool>(4);
+  task_queue queue(pool);
+  vector<int> order;
+  atomic<int> running = 0;
+  bool overlapped = false;
+  for (int i = 0; i < 100; i++) {
+    queue.push([&, i] {
+      overlapped |= running++ > 0;
+      order.push_back(i);
+      running--;
+    });
+  }
+  queue.wait();
+
+  EXPECT_EQ(queue.pending(), 0);
+  EXPECT_FALSE(overlapped);
+  ASSERT_EQ(order.size(), 100);
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(order.at(i), i);
+  }
+}
+
+TEST_F(task_pool_test, task_queue_exception) {
+  auto pool = make_shared<task_pool>(2);
+  task_queue queue(pool);
+  bool ran_after = false;
+  queue.push([] { throw sniffer_exception("task failed"); });
+  queue.push([&] { ran_after = true; });
+  EXPECT_THROW(queue.wait(), sniffer_exception);
+  EXPECT_TRUE(ran_after);
+  EXPECT_NO_THROW(queue.wait());
+}
+
+TEST_F(task_pool_test, parallel_fanout) {
+  auto source = make_shared<forwarding_worker>();
+  vector<shared_ptr<recording_worker>> sinks;
+  for (int i = 0; i < 4; i++) {
+    sinks.push_back(make_shared<recording_worker>());
+    source->connect(sinks.back());
+  }
+  source->set_parallel_fanout(make_shared<task_pool>(4));
+
+  auto samples = make_shared<vector<complex<float>>>(16);
+  auto t0 = chrono::steady_clock::now();
+  for (int64_t i = 0; i < 10; i++) {
+    frame_metadata metadata;
+    metadata.sample_index = i;
+    source->process(samples, metadata);
+
+    // Join semantics: every next worker is done when process returns
+    for (auto& sink : sinks) {
+      EXPECT_EQ(sink->sample_indices.size(), i + 1);
+    }
+  }
+  auto elapsed = chrono::steady_clock::now() - t0;
+  EXPECT_LT(elapsed, chrono::milliseconds(4 * 10 * 2));
+
+  for (auto& sink : sinks) {
+    EXPECT_EQ(sink->sample_indices, vector<int64_t>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+  }
+}
+
+TEST_F(task_pool_test, pipelined_fanout) {
+  auto source = make_shared<forwarding_worker>();
+  vector<shared_ptr<recording_worker>> sinks;
+  for (int i = 0; i < 3; i++) {
+    sinks.push_back(make_shared<recording_worker>());
+    source->connect(sinks.back());
+  }
+  source->set_parallel_fanout(make_shared<task_pool>(2), 2);
+
+  auto samples = make_shared<vector<complex<float>>>(16);
+  for (int64_t i = 0; i < 20; i++) {
+    frame_metadata metadata;
+    metadata.sample_index = i;
+    source->process(samples, metadata);
+  }
+  source->join_next_workers();
+
+  for (auto& sink : sinks) {
+    ASSERT_EQ(sink->sample_indices.size(), 20);
+    for (int64_t i = 0; i < 20; i++) {
+      EXPECT_EQ(sink->sample_indices.at(i), i);
+    }
+  }
+
+  // Disconnecting keeps the remaining edges and their queues paired
+  source->disconnect(sinks.at(1));
+  frame_metadata metadata;
+  metadata.sample_index = 20;
+  source->process(samples, metadata);
+  source->join_next_workers();
+  EXPECT_EQ(sinks.at(0)->sample_indices.back(), 20);
+  EXPECT_EQ(sinks.at(1)->sample_indices.back(), 19);
+  EXPECT_EQ(sinks.at(2)->sample_indices.back(), 20);
+}
+
+/**
+ * Worker that records the threads it runs on.
+ */
+class thread_recording_worker : public worker {
+  public:
+    void process(shared_ptr<vector<complex<float>>>& samples, const frame_metadata& metadata) override {
+      lock_guard<mutex> lock(m);
+      thread_ids.push_back(this_thread::get_id());
+    }
+    vector<thread::id> thread_ids;
+    mutex m;
+};
+
+TEST_F(task_pool_test, forced_fanout_queues_a_lone_worker) {
+  auto source = make_shared<forwarding_worker>();
+  auto sink = make_shared<thread_recording_worker>();
+  source->connect(sink);
+  auto samples = make_shared<vector<complex<float>>>(16);
+  frame_metadata metadata;
+
+  // A lone next worker runs in place by default
+  source->set_parallel_fanout(make_shared<task_pool>(1));
+  source->process(samples, metadata);
+  source->join_next_workers();
+  ASSERT_EQ(sink->thread_ids.size(), 1);
+  EXPECT_EQ(sink->thread_ids.at(0), this_thread::get_id());
+
+  // It never does once the fan-out is forced to queue
+  source->set_parallel_fanout(make_shared<task_pool>(1), 1, true);
+  for (int i = 0; i < 5; i++)
+    source->process(samples, metadata);
+  source->join_next_workers();
+  ASSERT_EQ(sink->thread_ids.size(), 6);
+  for (size_t i = 1; i < sink->thread_ids.size(); i++)
+    EXPECT_NE(sink->thread_ids.at(i), this_thread::get_id());
+}
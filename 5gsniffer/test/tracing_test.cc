@@ -0,0 +1,71 @@
+/**
+ * Copyright 2022-2023 SpriteLab @ Northeastern University
+ *
+ * This file is part of 5GSniffer.
+ *
+ * 5GSniffer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * 5GSniffer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * A copy of the GNU Affero General Public License can be found in
+ * the LICENSE file in the top-level directory of this distribution
+ * and at http://www.gnu.org/licenses/.
+ *
+ */
+
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "tracing.h"
+
+using namespace std;
+
+class tracing_test : public ::testing::Test {
+ protected:
+  tracing_test() {
+  }
+};
+
+static size_t count_occurrences(const string& text, const string& pattern) {
+  size_t count = 0;
+  for (size_t pos = text.find(pattern); pos != string::npos; pos = text.find(pattern, pos + 1))
+    count++;
+  return count;
+}
+
+TEST_F(tracing_test, disabled_by_default) {
+  {
+    tracing::trace_scope trace("tracing_test::disabled");
+  }
+  EXPECT_EQ(tracing::to_chrome_json().find("tracing_test::disabled"), string::npos);
+}
+
+TEST_F(tracing_test, chrome_json) {
+  tracing::enable(4);
+
+  // Each thread keeps its own most recent events
+  vector<thread> threads;
+  for (int t = 0; t < 2; t++) {
+    threads.emplace_back([] {
+      for (int i = 0; i < 10; i++) {
+        tracing::trace_scope trace("tracing_test::event");
+      }
+    });
+  }
+  for (auto& t : threads)
+    t.join();
+  tracing::enabled = false;
+
+  string json = tracing::to_chrome_json();
+  EXPECT_EQ(json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0), 0);
+  EXPECT_EQ(count_occurrences(json, "\"name\":\"tracing_test::event\",\"ph\":\"X\""), 8);
+  EXPECT_GE(count_occurrences(json, "\"ph\":\"M\""), 2);
+  EXPECT_EQ(json.substr(json.size() - 4), "\n]}\n");
+}